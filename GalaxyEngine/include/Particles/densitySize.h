@@ -2,6 +2,8 @@
 
 #include "Particles/particle.h"
 
+#include "UX/parallel_for.h"
+
 struct DensitySize {
 
 	float minSize = 0.17f;
@@ -14,11 +16,9 @@ struct DensitySize {
 		float& sizeMultiplier) {
 
 		if (isForceSizeEnabled) {
-#pragma omp parallel for schedule(dynamic)
-
-			for (int64_t i = 0; i < pParticles.size(); i++) {
+			parallel_for(0, pParticles.size(), [&](size_t i, int) {
 				if (rParticles[i].isSolid || rParticles[i].isDarkMatter) {
-					continue;
+					return;
 				}
 
 				float particleAccSq = pParticles[i].acc.x * pParticles[i].acc.x +
@@ -28,23 +28,22 @@ struct DensitySize {
 				float normalizedAcc = clampedAcc / sizeAcc;
 
 				rParticles[i].size = Lerp(maxSize * sizeMultiplier, minSize * sizeMultiplier, normalizedAcc);
-			}
+				});
 		}
 
 		if (isDensitySizeEnabled) {
 
 			std::vector<int> neighborCounts(pParticles.size(), 0);
-#pragma omp parallel for schedule(dynamic)
-			for (int64_t i = 0; i < pParticles.size(); i++) {
+			parallel_for(0, pParticles.size(), [&](size_t i, int) {
 
 				if (rParticles[i].isDarkMatter || rParticles[i].isSolid) {
-					continue;
+					return;
 				}
 
 				float normalDensity = std::min(float(rParticles[i].neighbors) / 25, 1.0f);
 
 				rParticles[i].size = Lerp(maxSize * sizeMultiplier, minSize * sizeMultiplier, static_cast<float>(pow(normalDensity, 2)));
-			}
+				});
 		}
 	}
 
@@ -2,6 +2,9 @@
 
 #include "Particles/particle.h"
 
+#include "UX/frameArena.h"
+#include "UX/parallel_for.h"
+
 struct GridCellNS {
 	std::vector<size_t> particleIndices;
 };
@@ -15,20 +18,30 @@ struct NeighborSearch {
 
 	int cellAmount = 3840;
 
+	ScratchVector<size_t> particlesToProcessScratch{ "Density particles" };
+	ScratchVector<int> cellXScratch{ "Density cell x" };
+	ScratchVector<int> cellYScratch{ "Density cell y" };
+	ScratchVector<size_t> cellCountScratch{ "Density cell counts" };
+	ScratchVector<size_t> cellStartScratch{ "Density cell starts" };
+	ScratchVector<size_t> cellParticleScratch{ "Density cell particles" };
+	ScratchVector<size_t> fillCursorScratch{ "Density fill cursors" };
+	ScratchVector<int> neighborCountScratch{ "Density neighbor counts" };
+
 	size_t getGridIndex(const glm::vec2& pos) const {
 		size_t cellX = static_cast<size_t>(floor(pos.x / cellSize));
 		size_t cellY = static_cast<size_t>(floor(pos.y / cellSize));
 		return cellX * cellAmount + cellY;
 	}
 
-	std::vector<size_t> getNeighborCells(size_t cellIndex) const {
-		std::vector<size_t> neighbors;
+	std::array<size_t, 9> getNeighborCells(size_t cellIndex) const {
+		std::array<size_t, 9> neighbors{};
 		size_t cellX = cellIndex / cellAmount;
 		size_t cellY = cellIndex % cellAmount;
+		size_t n = 0;
 
 		for (int i = -1; i <= 1; i++) {
 			for (int j = -1; j <= 1; j++) {
-				neighbors.push_back((cellX + i) * cellAmount + (cellY + j));
+				neighbors[n++] = (cellX + i) * cellAmount + (cellY + j);
 			}
 		}
 
@@ -36,7 +49,12 @@ struct NeighborSearch {
 	}
 
 	void updateGrid(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles) {
-		grid.clear();
+
+		// Cells left empty last frame are dropped, the rest keep their lists' capacity for this frame
+		std::erase_if(grid, [](const auto& cell) { return cell.second.particleIndices.empty(); });
+		for (auto& cell : grid) {
+			cell.second.particleIndices.clear();
+		}
 
 		for (size_t i = 0; i < pParticles.size(); i++) {
 
@@ -60,10 +78,10 @@ struct NeighborSearch {
 		float h2 = cellSize * cellSize;
 
 		updateGrid(pParticles, rParticles);
-		#pragma omp parallel for
-		for (size_t i = 0; i < pParticles.size(); ++i) {
 
-			if (rParticles[i].isDarkMatter) continue;
+		parallel_for(0, pParticles.size(), [&](size_t i, int) {
+
+			if (rParticles[i].isDarkMatter) return;
 
 			auto& pi = pParticles[i];
 
@@ -89,7 +107,7 @@ struct NeighborSearch {
 					pi.neighborIds.push_back(pj.id);
 				}
 			}
-		}
+			});
 	}
 
 	void neighborSearch(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
@@ -101,7 +119,7 @@ struct NeighborSearch {
 			return;
 		}
 
-		std::vector<size_t> particlesToProcess;
+		std::vector<size_t>& particlesToProcess = particlesToProcessScratch.acquire();
 		particlesToProcess.reserve(pParticles.size());
 		for (size_t i = 0; i < pParticles.size(); i++) {
 			if (!rParticles[i].isDarkMatter && !rParticles[i].uniqueColor) {
@@ -118,32 +136,26 @@ struct NeighborSearch {
 		float maxX = std::numeric_limits<float>::lowest();
 		float maxY = std::numeric_limits<float>::lowest();
 
-		std::vector<int> cellXList(particlesToProcess.size());
-		std::vector<int> cellYList(particlesToProcess.size());
-
-#pragma omp parallel
-		{
-			float localMinX = std::numeric_limits<float>::max();
-			float localMinY = std::numeric_limits<float>::max();
-			float localMaxX = std::numeric_limits<float>::lowest();
-			float localMaxY = std::numeric_limits<float>::lowest();
-
-#pragma omp for nowait
-			for (int64_t idx = 0; idx < (int64_t)particlesToProcess.size(); idx++) {
-				const auto& pos = pParticles[particlesToProcess[idx]].pos;
-				localMinX = std::min(localMinX, pos.x);
-				localMinY = std::min(localMinY, pos.y);
-				localMaxX = std::max(localMaxX, pos.x);
-				localMaxY = std::max(localMaxY, pos.y);
-			}
+		std::vector<int>& cellXList = cellXScratch.acquireSized(particlesToProcess.size());
+		std::vector<int>& cellYList = cellYScratch.acquireSized(particlesToProcess.size());
 
-#pragma omp critical
-			{
-				minX = std::min(minX, localMinX);
-				minY = std::min(minY, localMinY);
-				maxX = std::max(maxX, localMaxX);
-				maxY = std::max(maxY, localMaxY);
-			}
+		const int boundThreads = clamp_thread_count(particlesToProcess.size(), threadPool.size());
+		std::vector<glm::vec4> threadBounds(static_cast<size_t>(boundThreads), { minX, minY, maxX, maxY });
+
+		parallel_for(0, particlesToProcess.size(), boundThreads, [&](size_t idx, int tid) {
+			const auto& pos = pParticles[particlesToProcess[idx]].pos;
+			glm::vec4& bounds = threadBounds[tid];
+			bounds.x = std::min(bounds.x, pos.x);
+			bounds.y = std::min(bounds.y, pos.y);
+			bounds.z = std::max(bounds.z, pos.x);
+			bounds.w = std::max(bounds.w, pos.y);
+			});
+
+		for (const glm::vec4& bounds : threadBounds) {
+			minX = std::min(minX, bounds.x);
+			minY = std::min(minY, bounds.y);
+			maxX = std::max(maxX, bounds.z);
+			maxY = std::max(maxY, bounds.w);
 		}
 
 		minX -= cellSize;
@@ -155,10 +167,9 @@ struct NeighborSearch {
 		int gridHeight = std::max(1, static_cast<int>((maxY - minY) / cellSize) + 1);
 		int numCells = gridWidth * gridHeight;
 
-		std::vector<size_t> cellCounts(numCells, 0);
+		std::vector<size_t>& cellCounts = cellCountScratch.acquire(numCells, 0);
 
-#pragma omp parallel for
-		for (int64_t idx = 0; idx < (int64_t)particlesToProcess.size(); idx++) {
+		parallel_for(0, particlesToProcess.size(), [&](size_t idx, int) {
 			const auto& pos = pParticles[particlesToProcess[idx]].pos;
 
 			int cx = static_cast<int>((pos.x - minX) / cellSize);
@@ -170,35 +181,31 @@ struct NeighborSearch {
 			cellXList[idx] = cx;
 			cellYList[idx] = cy;
 
-#pragma omp atomic
-			cellCounts[cellIdx]++;
-		}
+			std::atomic_ref<size_t>(cellCounts[cellIdx]).fetch_add(1, std::memory_order_relaxed);
+			});
 
-		std::vector<size_t> cellStart(numCells + 1, 0);
+		std::vector<size_t>& cellStart = cellStartScratch.acquire(numCells + 1, 0);
 		for (int i = 0; i < numCells; i++) {
 			cellStart[i + 1] = cellStart[i] + cellCounts[i];
 		}
 
-		std::vector<size_t> cellParticles(particlesToProcess.size());
-		std::vector<size_t> fillCursor = cellStart;
+		std::vector<size_t>& cellParticles = cellParticleScratch.acquireSized(particlesToProcess.size());
+		std::vector<size_t>& fillCursor = fillCursorScratch.acquire();
+		fillCursor.assign(cellStart.begin(), cellStart.end());
 
-#pragma omp parallel for
-		for (int64_t idx = 0; idx < (int64_t)particlesToProcess.size(); idx++) {
+		parallel_for(0, particlesToProcess.size(), [&](size_t idx, int) {
 			int cx = cellXList[idx];
 			int cy = cellYList[idx];
 			int cellIdx = cy * gridWidth + cx;
 
-			size_t writePos;
-#pragma omp atomic capture
-			writePos = fillCursor[cellIdx]++;
+			size_t writePos = std::atomic_ref<size_t>(fillCursor[cellIdx]).fetch_add(1, std::memory_order_relaxed);
 
 			cellParticles[writePos] = particlesToProcess[idx];
-		}
+			});
 
-		std::vector<int> localNeighborCounts(particlesToProcess.size(), 0);
+		std::vector<int>& localNeighborCounts = neighborCountScratch.acquire(particlesToProcess.size(), 0);
 
-#pragma omp parallel for schedule(dynamic)
-		for (int64_t idx = 0; idx < (int64_t)particlesToProcess.size(); idx++) {
+		parallel_for(0, particlesToProcess.size(), [&](size_t idx, int) {
 			size_t i = particlesToProcess[idx];
 			const auto& particle = pParticles[i];
 
@@ -225,7 +232,7 @@ struct NeighborSearch {
 					}
 				}
 			}
-		}
+			});
 
 		for (size_t k = 0; k < particlesToProcess.size(); k++) {
 			rParticles[particlesToProcess[k]].neighbors = localNeighborCounts[k];
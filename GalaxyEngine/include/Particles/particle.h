@@ -36,12 +36,15 @@ struct ParticlePhysics {
 	bool isHotPoint;
 	bool hasSolidified;
 
+	// Block timestep level, the particle steps by timeFactor / 2^stepLevel
+	int stepLevel;
+
 	// Default constructor
 	ParticlePhysics()
 		: pos(0.0f, 0.0f), predPos{ 0,0 }, vel{ 0,0 }, prevVel{ 0.0f, 0.0f }, predVel{ 0.0f, 0.0f }, acc{ 0,0 },
 		mass(8500000000.0f), press(0.0f), pressTmp(0.0f), pressF{ 0.0f,0.0f }, dens(0.0f), predDens(0.0f), sphMass(1.0f),
 		restDens(0.0f), stiff(0.0f), visc(0.0f), cohesion(0.0f),
-		temp(0.0f), ke(0.0f), prevKe(0.0f), mortonKey(0), id(globalId++), isHotPoint(false), hasSolidified(false)
+		temp(0.0f), ke(0.0f), prevKe(0.0f), mortonKey(0), id(globalId++), isHotPoint(false), hasSolidified(false), stepLevel(0)
 	{
 	}
 
@@ -78,6 +81,8 @@ struct ParticlePhysics {
 
 		this->isHotPoint = false;
 		this->hasSolidified = false;
+
+		this->stepLevel = 0;
 	}
 };
 
@@ -3,6 +3,8 @@
 #include "Particles/particle.h"
 #include "Physics/materialsSPH.h"
 
+#include "UX/parallel_for.h"
+
 struct ColorVisuals {
 
 	bool solidColor = false;
@@ -128,10 +130,9 @@ struct ColorVisuals {
 
 			const float invMaxNeighbors = 1.0f / maxNeighbors;
 
-#pragma omp parallel for schedule(dynamic)
-			for (int64_t i = 0; i < pParticles.size(); i++) {
+			parallel_for(0, pParticles.size(), [&](size_t i, int) {
 				if (rParticles[i].isDarkMatter) {
-					continue;
+					return;
 				}
 
 				if (!rParticles[i].uniqueColor) {
@@ -145,14 +146,14 @@ struct ColorVisuals {
 
 				float normalDensity = std::min(static_cast<float>(rParticles[i].neighbors) * invMaxNeighbors, 1.0f);
 				rParticles[i].color = ColorLerp(lowDensityColor, highDensityColor, normalDensity);
-			}
+				});
 
 			blendMode = 1;
 		}
 
 		if (velocityColor) {
-#pragma omp parallel for schedule(dynamic)
-			for (int64_t i = 0; i < pParticles.size(); i++) {
+			// The hue stays local, the loop runs on every thread of the pool
+			parallel_for(0, pParticles.size(), [&](size_t i, int) {
 
 				float particleVelSq = pParticles[i].vel.x * pParticles[i].vel.x +
 					pParticles[i].vel.y * pParticles[i].vel.y;
@@ -160,12 +161,8 @@ struct ColorVisuals {
 				float clampedVel = std::clamp(particleVel, minVel, maxVel);
 				float normalizedVel = maxVel > 0.0f ? (clampedVel / maxVel) : 0.0f;
 
-				hue = (1.0f - normalizedVel) * 240.0f;
-				saturation = 1.0f;
-				value = 1.0f;
-
-				rParticles[i].color = ColorFromHSV(hue, saturation, value);
-			}
+				rParticles[i].color = ColorFromHSV((1.0f - normalizedVel) * 240.0f, 1.0f, 1.0f);
+				});
 
 			blendMode = 0;
 		}
@@ -266,38 +263,28 @@ struct ColorVisuals {
 		}
 
 		if (pressureColor) {
-#pragma omp parallel for schedule(dynamic)
-			for (int64_t i = 0; i < pParticles.size(); i++) {
+			parallel_for(0, pParticles.size(), [&](size_t i, int) {
 
 				ParticlePhysics& p = pParticles[i];
 
 				float clampedPress = std::clamp(p.press, minPress, maxPress);
 				float normalizedPress = clampedPress / maxPress;
 
-				hue = (1.0f - normalizedPress) * 240.0f;
-				saturation = 1.0f;
-				value = 1.0f;
-
-				rParticles[i].color = ColorFromHSV(hue, saturation, value);
-			}
+				rParticles[i].color = ColorFromHSV((1.0f - normalizedPress) * 240.0f, 1.0f, 1.0f);
+				});
 			blendMode = 0;
 		}
 
 		if (temperatureColor) {
-#pragma omp parallel for schedule(dynamic)
-			for (int64_t i = 0; i < pParticles.size(); i++) {
+			parallel_for(0, pParticles.size(), [&](size_t i, int) {
 
 				ParticlePhysics& p = pParticles[i];
 
 				float clampedTemp = std::clamp(p.temp, tempColorMinTemp, tempColorMaxTemp);
 				float normalizedTemp = clampedTemp / tempColorMaxTemp;
 
-				hue = (1.0f - normalizedTemp) * 240.0f;
-				saturation = 1.0f;
-				value = 1.0f;
-
-				rParticles[i].color = ColorFromHSV(hue, saturation, value);
-			}
+				rParticles[i].color = ColorFromHSV((1.0f - normalizedTemp) * 240.0f, 1.0f, 1.0f);
+				});
 			blendMode = 0;
 		}
 
@@ -5,6 +5,7 @@
 #include "Physics/slingshot.h"
 
 #include "Physics/constraint.h"
+#include "Physics/trajectoryPredictor.h"
 
 #include "UI/brush.h"
 
@@ -35,10 +36,19 @@ public:
 
 	void particlesInitialConditions(Physics& physics, UpdateVariables& myVar, UpdateParameters& myParam);
 
-	void predictTrajectory(const std::vector<ParticlePhysics>& actualParticles, 
-		SceneCamera& myCamera, Physics physics, UpdateVariables& myVar, Slingshot& slingshot);
+	// Draws the path a heavy particle launched with the current slingshot would take. It's integrated in the background
+	// by trajectoryPredictor and drawn as far as it got
+	void predictTrajectory(SceneCamera& myCamera, const Physics& physics, UpdateVariables& myVar, Slingshot& slingshot);
+
+	// The path prediction copies the frame's tree when a drag starts. PM gravity doesn't build one, so it's asked for
+	// before particlesInitialConditions()
+	bool needsTree(const UpdateVariables& myVar) const;
 
 private:
 
 	float heavyParticleInitMass = 300000000000000.0f;
+
+	TrajectoryPredictor trajectoryPredictor;
+
+	std::vector<glm::vec2> predictedPath;
 };
\ No newline at end of file
@@ -2,18 +2,15 @@
 
 #include "Particles/particle.h"
 
-#include "parameters.h"
+#include "Physics/sphFluid.h"
+
+#include "simulationParameters.h"
 
 struct UpdateVariables;
 struct UpdateVariables;
 
-struct GridCell {
-	std::vector<size_t> particleIndices;
-};
-
 class SPH {
 public:
-	static constexpr size_t kInvalidCell = std::numeric_limits<size_t>::max();
 
 	float radiusMultiplier = 3.0f;
 	float mass = 0.03f;
@@ -24,16 +21,33 @@ public:
 	float delta = 9500.0f;
 	float verticalGravity = 3.0f;
 
-	float densTolerance = 0.08f;
+	// Pressure per unit of density error for particles that can reach their rest density, set every step by
+	// computeDelta() and scaled down for particles stiffer than the prototype. Materials a single particle is already
+	// denser than, like rock or sand, can't be solved to their rest density. Their density error stays an equation of
+	// state with the hand tuned delta
+	float solverDelta = 0.0f;
+
+	// The pressure iterations stop once no particle is compressed past densTolerance of its rest density, or after
+	// maxIter of them
+	float densTolerance = 0.01f;
 
-	int maxIter = 1; // I keep only 1 iteration when I don't use the density error condition
+	int maxIter = 4;
 	int iter = 0;
 
-	float cellSize;
-	std::unordered_map<size_t, GridCell> grid;
-	std::vector<glm::vec2> sphForce;
+	// Part of the missing pressure a DFSPH iteration adds. The solves only see how the density changes to first order,
+	// and the kernel's density rises faster than that as particles close in, so adding all of it overshoots
+	float dfsphRelaxation = 0.5f;
 
-	SPH() : cellSize(radiusMultiplier) {}
+	// Extra search distance of the neighbor lists. The lists are kept across steps until some particle moved half of
+	// it, 0 rebuilds them for the positions and again for the predicted positions every step
+	float neighborSkin = 0.5f;
+
+	// The fluid in cell order, with cells over the positions and predCells over the predicted positions. Every kernel
+	// walks neighborList, which is built from whichever of the two was rebuilt last
+	SPHFluid fluid;
+	SPHCellList cells;
+	SPHCellList predCells;
+	SPHNeighborList neighborList;
 
 	float smoothingKernel(float dst, float radiusMultiplier) {
 		if (dst >= radiusMultiplier) return 0.0f;
@@ -42,6 +56,13 @@ public:
 		return (radiusMultiplier - dst) * (radiusMultiplier - dst) / volume;
 	}
 
+	float smoothingKernelDerivative(float dst, float radiusMultiplier) {
+		if (dst >= radiusMultiplier) return 0.0f;
+
+		float volume = (PI * pow(radiusMultiplier, 4.0f)) / 6.0f;
+		return -2.0f * (radiusMultiplier - dst) / volume;
+	}
+
 	float spikyKernelDerivative(float dst, float radiusMultiplier) {
 		if (dst >= radiusMultiplier) return 0.0f;
 
@@ -63,81 +84,82 @@ public:
 		return (1.0f - q) * (0.5f - q) * (0.5f - q) * 30.0f / (PI * h * h);
 	}
 
-	int cellAmountX = 3840;
+	// Pressure per unit of density error, from a prototype particle in the middle of a full lattice like PCISPH does.
+	// A particle's mass and rest density set its spacing at rest, and the spacing cancels out of the result, so one
+	// prototype covers every material. accelScale is the integrator's, see Physics::accelScale()
+	float computeDelta(float dt, float accelScale);
 
-	size_t getGridIndex(const glm::vec2& pos) const {
-		size_t cellX = static_cast<size_t>(floor(pos.x / cellSize));
-		size_t cellY = static_cast<size_t>(floor(pos.y / cellSize));
-		return cellX * cellAmountX + cellY;
-	}
+	// Kernel gradient sums of the prototype on a lattice of the given spacing, the part of computeDelta() that depends
+	// on where the neighbors are. PCISPH compares every slot's own sums against it at the slot's rest spacing
+	float prototypeStiffness(float spacing);
 
-	std::array<size_t, 9> getNeighborCells(size_t cellIndex) const {
-		std::array<size_t, 9> neighbors{};
-		int cellX = static_cast<int>(cellIndex / cellAmountX);
-		int cellY = static_cast<int>(cellIndex % cellAmountX);
-		size_t n = 0;
-
-		for (int i = -1; i <= 1; i++) {
-			for (int j = -1; j <= 1; j++) {
-				int nx = cellX + i;
-				int ny = cellY + j;
-				if (nx < 0 || ny < 0) {
-					neighbors[n++] = kInvalidCell;
-					continue;
-				}
-				neighbors[n++] = static_cast<size_t>(nx) * cellAmountX + static_cast<size_t>(ny);
-			}
-		}
-
-		return neighbors;
-	}
+	// prototypeStiffness() of every rest spacing in the fluid this step
+	std::vector<std::pair<float, float>> prototypeCache;
 
-	void updateGrid(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles) {
-		grid.clear();
-		grid.reserve(pParticles.size());
+	// Ground mode walls act as fluid at rest density filling the space past them, half a particle's rest spacing behind
+	// the line the walls clamp positions to. wallDensity and wallPush hold, for distances to a wall from 0 to the radius,
+	// the share of the kernel past the wall and the inward pressure kernel gradient integrated over it
+	static constexpr int wallSamples = 64;
+	std::vector<float> wallDensity;
+	std::vector<float> wallPush;
+	float wallRadius = 0.0f;
 
-		for (size_t i = 0; i < pParticles.size(); i++) {
+	void buildWallTables();
 
-			if (rParticles[i].isDarkMatter) { continue; }
+	float wallLookup(const std::vector<float>& table, float dst) const {
+		float t = std::clamp(dst / radiusMultiplier, 0.0f, 1.0f) * static_cast<float>(wallSamples);
+		int k = std::min(static_cast<int>(t), wallSamples - 1);
+		return table[k] + (table[k + 1] - table[k]) * (t - static_cast<float>(k));
+	}
 
-			size_t cellIndex = getGridIndex(pParticles[i].pos);
-			grid[cellIndex].particleIndices.push_back(i);
-		}
+	// Change of a table per unit of distance from the wall
+	float wallSlope(const std::vector<float>& table, float dst) const {
+		float t = std::clamp(dst / radiusMultiplier, 0.0f, 1.0f) * static_cast<float>(wallSamples);
+		int k = std::min(static_cast<int>(t), wallSamples - 1);
+		return (table[k + 1] - table[k]) * static_cast<float>(wallSamples) / radiusMultiplier;
 	}
 
-	// Currently unused
-	float computeDelta(const std::vector<glm::vec2>& kernelGradients, float dt, float mass, float restDensity) {
-		float beta = (dt * dt * mass * mass) / (restDensity * restDensity);
+	// Distances from a position of slot i to the left, right, top and bottom walls
+	std::array<float, 4> wallDistances(glm::vec2 pos, size_t i, glm::vec2 domainSize) const;
 
-		glm::vec2 sumGradW = { 0.0f, 0.0f };
-		float sumGradW_dot = 0.0f;
+	// Copies the fluid out of pParticles and brings neighborList up to date with its positions
+	void updateNeighbors(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles);
 
-		for (const glm::vec2& gradW : kernelGradients) {
-			sumGradW.x += gradW.x;
-			sumGradW.y += gradW.y;
+	// Scatters the fluid back into pParticles and adds pressF to the acceleration of every particle that isn't pinned
+	void applyPressureForces(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles);
 
-			sumGradW_dot += gradW.x * gradW.x + gradW.y * gradW.y;
-		}
+	// Pressure force on slot i from fluid.press, with the pair densities and positions given
+	glm::vec2 pressureForce(size_t i, const std::vector<glm::vec2>& positions, const std::vector<float>& densities,
+		glm::vec2 domainSize, bool sphGround);
 
-		float sumDot = sumGradW.x * sumGradW.x + sumGradW.y * sumGradW.y;
+	// Adds viscosity and cohesion to fluid.force, over neighborList
+	void computeViscCohesionForces();
 
-		float delta = -1.0f / (beta * (-sumDot - sumGradW_dot));
+	void groundModeBoundary(std::vector<ParticlePhysics>& pParticles,
+		std::vector<ParticleRendering>& rParticles, glm::vec2 domainSize);
 
-		return delta;
-	}
+	void PCISPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt,
+		float accelScale, glm::vec2 domainSize, bool sphGround);
 
-	void computeViscCohesionForces(std::vector<ParticlePhysics>& pParticles,
-		std::vector<ParticleRendering>& rParticles, std::vector<glm::vec2>& sphForce, size_t& N);
+	// Divergence free SPH. Keeps the velocity field divergence free and then the density at rest with two pressure
+	// solves over the same neighbor lists, warm started with the last step's pressures where the fluid is still
+	// compressed. Materials a particle is already denser than on its own keep the equation of state pressure of
+	// PCISPH. Like PCISPH, the result is added to acc for the integrator, which scales it by accelScale
+	void DFSPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt,
+		float accelScale, glm::vec2 domainSize, bool sphGround);
 
-	void groundModeBoundary(std::vector<ParticlePhysics>& pParticles,
-		std::vector<ParticleRendering>& rParticles, glm::vec2 domainSize);
+	void dfsphSolver(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt, float accelScale, glm::vec2& domainSize, bool& sphGround) {
+
+		DFSPH(pParticles, rParticles, dt, accelScale, domainSize, sphGround);
 
-	void PCISPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt);
+		if (sphGround) {
+			groundModeBoundary(pParticles, rParticles, domainSize);
+		}
+	}
 
-	void pcisphSolver(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt, glm::vec2& domainSize, bool& sphGround) {
+	void pcisphSolver(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt, float accelScale, glm::vec2& domainSize, bool& sphGround) {
 
-		updateGrid(pParticles, rParticles);
-		PCISPH(pParticles, rParticles, dt);
+		PCISPH(pParticles, rParticles, dt, accelScale, domainSize, sphGround);
 
 		if (sphGround) {
 			groundModeBoundary(pParticles, rParticles, domainSize);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Particles/particle.h"
+
+#include "simulationParameters.h"
+
+// A dark matter halo as a smooth spherical profile around a moving center instead of thousands of dark matter
+// particles. It pulls on every particle with G * M(<r) / r^2 and moves with the opposite pull of the particles and the
+// other halos, so galaxies with analytic halos still orbit and merge
+struct AnalyticHalo {
+
+	enum class Profile : uint32_t {
+		NFW = 0,
+		Plummer = 1,
+		// Cored isothermal with the same radial mass as the dark matter particles the galaxy spawner places
+		Isothermal = 2
+	};
+
+	glm::vec2 pos = { 0.0f, 0.0f };
+	glm::vec2 vel = { 0.0f, 0.0f };
+	glm::vec2 acc = { 0.0f, 0.0f };
+
+	// Mass inside cutoffRadius, where the profile is truncated
+	float mass = 0.0f;
+	float scaleRadius = 1.0f;
+	float cutoffRadius = 1.0f;
+
+	Profile profile = Profile::Isothermal;
+
+	// Enclosed mass of the profile shape at x = r / scaleRadius, not normalized
+	template <Profile profileType>
+	static inline float shape(float x) {
+		if constexpr (profileType == Profile::NFW) {
+			return std::log1p(x) - x / (1.0f + x);
+		}
+		else if constexpr (profileType == Profile::Plummer) {
+			float xSq = x * x;
+			return xSq * x / ((1.0f + xSq) * sqrt(1.0f + xSq));
+		}
+		else {
+			return std::log1p(x * x);
+		}
+	}
+
+	static float shapeOf(Profile profileType, float x);
+
+	// Fraction of mass inside r
+	float enclosedFraction(float r) const;
+
+	// Picks the scale radius that puts half the mass inside halfMassRadius, for the current profile and cutoff
+	void fitScaleRadius(float halfMassRadius);
+};
+
+struct AnalyticHalos {
+
+	std::vector<AnalyticHalo> halos;
+
+	// Adds the pull of every halo to the particles' acc, except for frozen particles, and sums the particles' pull back
+	// on the halos into their acc
+	void addGravity(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		const UpdateVariables& myVar);
+
+	// Sets every halo's acc to the pull of the particles at their current positions, without touching the particles.
+	// Used where the halos step without a gravity pass, like the block timestep substeps
+	void computeReaction(const std::vector<ParticlePhysics>& pParticles, const UpdateVariables& myVar);
+
+	// Pull of every halo at a position. Used where a single particle needs it, like the block timestep substeps
+	glm::vec2 accelerationAt(glm::vec2 pos, const UpdateVariables& myVar) const;
+
+	// Adds the pull between halos to their acc. Call after addGravity() or computeReaction()
+	void addMutualPull(const UpdateVariables& myVar);
+
+	// Kicks every halo by kickStep of its acc, damps and drifts it, the same way Physics::stepParticle() steps
+	// particles, so halos and particles trade momentum over the same steps
+	void step(float kickStep, float driftStep, float damping, const UpdateVariables& myVar);
+
+	// Closing half kick the last block timestep frame left open, taken with the next pull like the particles' one
+	float pendingKick = 0.0f;
+
+	// Adds a halo of the profile picked in myVar with the mass and extent of the dark matter particles the galaxy
+	// spawner would place: a cored isothermal disk of core radius coreRadius cut at outerRadius
+	void spawnForGalaxy(glm::vec2 pos, glm::vec2 vel, float mass, float coreRadius, float outerRadius,
+		const UpdateVariables& myVar);
+
+	// Replaces dark matter particles by one halo of the chosen profile with the same mass, center of mass and mean
+	// velocity. The selected dark matter particles are used if there are any, all of them otherwise. The scale radius
+	// is fitted to their half mass radius
+	void freezeDarkMatter(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
+		const UpdateVariables& myVar);
+};
@@ -2,6 +2,8 @@
 
 #include "parameters.h"
 
+#include "UX/parallel_for.h"
+
 struct Cell {
 	glm::vec2 pos;
 	float size;
@@ -26,6 +28,10 @@ struct Field {
 
 	float gravityDisplayThreshold = 1000.0f;
 
+	// Mass multiplier of the gravity display, so ordinary scenes land in the color range. The compute shader gets it as
+	// massScale, fields solved elsewhere scale by it too
+	static constexpr float gravityDisplayMassScale = 10.0f;
+
 	bool computeField = true;
 
 	float gravityDisplaySoftness = 0.85f;
@@ -133,6 +139,7 @@ uniform int cellCount;
 
 uniform float G;
 uniform float gravityDisplaySoftness;
+uniform float massScale;
 
 uniform vec2 domainSize;
 uniform int periodicBoundary;
@@ -166,7 +173,7 @@ void main() {
         float dist = sqrt(distSq);
 
         if (dist > 0.0001) {
-            force += G * (particlesMass[j] * 10.0) / (dist * dist);
+            force += G * (particlesMass[j] * massScale) / (dist * dist);
         }
     }
 
@@ -401,6 +408,7 @@ void main()
 			myVar.isPeriodicBoundaryEnabled);
 
 		glUniform1f(glGetUniformLocation(gravityDisplayProgram, "G"), myVar.G);
+		glUniform1f(glGetUniformLocation(gravityDisplayProgram, "massScale"), gravityDisplayMassScale);
 
 		GLuint groups = (cellCount + 255) / 256;
 		glDispatchCompute(groups, 1, 1);
@@ -410,14 +418,42 @@ void main()
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboCellsData);
 		float* ptr = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
 
-#pragma omp parallel for
-		for (size_t i = 0; i < cellCount; i++) {
+		parallel_for(0, cellCount, [&](size_t i, int) {
 			cells[i].strength = ptr[i + 2 * cellCount];
-		}
+			});
 
 		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	}
 
+	// Gravity display from a field that is already solved, like the particle mesh. strengthAt(pos) gives the display
+	// value at a cell corner, where the compute shader samples it
+	template <typename StrengthAt>
+	void solvedGravityDisplay(UpdateVariables& myVar, StrengthAt strengthAt) {
+
+		if (cells.empty() || !myVar.isGravityFieldEnabled) {
+			return;
+		}
+
+		size_t cellCount = cells.size();
+
+		cellsData.resize(cellCount * 3);
+
+		parallel_for(0, cellCount, [&](size_t i, int) {
+			float strength = strengthAt(cells[i].pos);
+
+			cellsData[i] = cells[i].pos.x;
+			cellsData[i + cellCount] = cells[i].pos.y;
+			cellsData[i + 2 * cellCount] = strength;
+
+			cells[i].strength = strength;
+			});
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboCellsData);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+			cellsData.size() * sizeof(float),
+			cellsData.data());
+	}
+
 	void drawField(UpdateParameters& myParam, UpdateVariables& myVar)
 	{
 		BeginMode2D(myParam.myCamera.camera);
@@ -469,6 +505,8 @@ void main()
 #else
     inline void fieldGravityDisplayKernel() {}
     inline void gpuGravityDisplay(UpdateParameters&, UpdateVariables&) {}
+    template <typename StrengthAt>
+    inline void solvedGravityDisplay(UpdateVariables&, StrengthAt) {}
     inline void drawField(UpdateParameters&, UpdateVariables&) {}
 #endif
 
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Particles/particle.h"
+
+#include "Physics/quadtree.h"
+
+#include "simulationParameters.h"
+
+// One box of the FMM tree. Cells are globalNodes cut off at leafMaxParticles, stored breadth first so every level is
+// a contiguous range and the children of a cell sit next to each other
+struct FmmCell {
+	uint32_t node;
+	uint32_t parent;
+
+	uint32_t startIndex;
+	uint32_t endIndex;
+
+	uint32_t firstChild;
+	uint32_t childCount;
+
+	int level;
+
+	// Expansion center (center of mass, or the box center for massless cells) and the distance from it to the
+	// farthest particle of the cell
+	glm::vec2 center;
+	float radius;
+	float mass;
+
+	inline bool isLeaf() const {
+		return childCount == 0;
+	}
+};
+
+// Fast multipole gravity over the quadtree. The force law is the softened 3D one used everywhere else in the engine,
+// m * d / (r^2 + softening^2)^(3/2), which is not harmonic in the plane. The complex log expansions of the classic 2D
+// FMM would solve a different force, so the expansions here are Cartesian Taylor series of the softened kernel:
+//  - P2M and M2M: multipoles about each cell's center of mass, up to the selected order
+//  - M2L: a dual tree walk turns well separated cell pairs into local expansions, near leaf pairs go to P2P
+//  - L2L and L2P: locals are pushed down the levels and evaluated at the particles
+// Coefficients are doubles so the error keeps dropping past order 6
+struct FMM {
+
+	static constexpr int maxOrder = 12;
+	static constexpr uint32_t leafMaxParticles = 32;
+
+	// Two cells interact through their expansions when (radiusA + radiusB) < openingRatio * distance
+	float openingRatio = 0.5f;
+
+	std::vector<FmmCell> cells;
+	std::vector<uint32_t> levelStarts;
+
+	// Cells the dual walk is started from, one task each. They split the particles into disjoint ranges so each task
+	// only writes to its own particles and locals
+	std::vector<uint32_t> frontier;
+
+	// 0 above the frontier, 1 frontier, 2 below it
+	std::vector<uint8_t> frontierClass;
+
+	std::vector<double> multipoles;
+	std::vector<double> locals;
+
+	static constexpr int coeffCount(int order) {
+		return (order + 1) * (order + 2) / 2;
+	}
+
+	static constexpr int coeffIndex(int a, int b) {
+		return (a + b) * (a + b + 1) / 2 + b;
+	}
+
+	// Writes the gravity acceleration into every particle's acc, zero for frozen ones. Needs globalNodes built over the
+	// current particle order
+	void computeGravity(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		UpdateVariables& myVar, int order);
+
+	void buildCells();
+
+	void buildFrontier();
+
+	void upwardPass(const std::vector<ParticlePhysics>& pParticles, int order);
+
+	void dualWalk(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, int order, uint32_t target);
+
+	void downwardPass(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, int order);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Particles/particle.h"
+#include "Physics/morton.h"
+#include "Physics/quadtree.h"
+
+#include "UX/threadPool.h"
+
+struct UpdateVariables;
+struct UpdateParameters;
+struct Physics;
+
+// Future orbits of the selected particles. The scene is copied, decimated to futureOrbitMaxBodies by keeping every
+// selected particle and merging runs of k other ones into one body at their center of mass, and then run ahead as a
+// task on the thread pool with a coarse timestep and a loose theta. Each step rebuilds a private tree, so the scene's
+// tree and particles are never touched. Tracks are published in chunks while they grow. The run restarts when the
+// particles or the selection change, and again from the current scene once it finishes while time is playing. The
+// force loop and the tree's key sort inside the run are capped to futureOrbitThreads, the rest of the tree build is
+// serial, so the main simulation keeps the rest of the cores
+class FuturePreview {
+public:
+
+	FuturePreview() = default;
+
+	FuturePreview(const FuturePreview&) = delete;
+	FuturePreview& operator=(const FuturePreview&) = delete;
+
+	~FuturePreview();
+
+	// Starts, restarts or cancels the run for this frame's scene. Call once per frame after the scene update
+	void update(const UpdateParameters& myParam, const UpdateVariables& myVar, const Physics& physics);
+
+	// Drops the run and its tracks
+	void cancel();
+
+	// Draws the tracks in world space, inside BeginMode2D()
+	void draw(const UpdateVariables& myVar);
+
+private:
+
+	struct Snapshot;
+
+	// Steps the worker runs between publishing tracks
+	static constexpr int chunkSteps = 16;
+
+	TaskGroup task;
+	std::mutex mutex;
+
+	// Guarded by mutex. requested is bumped by every start and cancel, the worker drops work from older ones.
+	// isRunning is set while the worker task is queued or running, it ends once it catches up with requested
+	std::shared_ptr<const Snapshot> snapshot;
+	uint64_t requested = 0;
+	bool isFinished = false;
+	bool isRunning = false;
+
+	// Tracks of the run in progress, and of the last run that finished. The finished ones stay on screen while a
+	// refresh catches up so the overlay doesn't flicker
+	std::vector<std::vector<glm::vec2>> building;
+	std::vector<std::vector<glm::vec2>> finished;
+	std::vector<Color> buildingColors;
+	std::vector<Color> finishedColors;
+
+	// Copy of requested the worker polls between steps to give up early
+	std::atomic<uint64_t> latest{ 0 };
+
+	// Main thread only. What the running snapshot was taken from, to notice when the scene changed under it
+	size_t sceneParticles = 0;
+	std::vector<uint32_t> sceneSelection;
+	bool isActive = false;
+
+	void start(const UpdateParameters& myParam, const UpdateVariables& myVar, const Physics& physics,
+		std::vector<uint32_t>&& selection, bool isRefresh);
+
+	void workerLoop();
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+// A batch of gravity sources as plain float arrays, the layout the group walk's interaction lists already use
+struct GravitySources {
+	const float* x;
+	const float* y;
+	const float* mass;
+	int count;
+};
+
+// Inner loop of the batched gravity walk. Adds sum(mass * d / (r^2 + softening^2)^(3/2)) to ax, ay for one target.
+// G is left to the caller.
+// The vector paths take 8 (AVX2) or 4 (SSE, NEON) sources per iteration and replace the sqrt and divide with rsqrt
+// plus Newton refinement. The widest path the CPU supports is picked on first use, the scalar loop is the fallback
+// and handles the tails
+struct GravityKernel {
+
+	enum class Path {
+		Scalar,
+		SSE,
+		AVX2,
+		NEON
+	};
+
+	// maskCoincident skips sources within 0.001 of the target on both axes, which also drops the target itself
+	static void accumulate(const GravitySources& sources, float px, float py, float softeningSq,
+		bool maskCoincident, float& ax, float& ay);
+
+	static Path path();
+
+	static const char* pathName(Path path);
+
+	static bool isSupported(Path path);
+
+	// Forces a path, for benchmarks. Returns false and keeps the current one if the CPU can't run it
+	static bool setPath(Path path);
+};
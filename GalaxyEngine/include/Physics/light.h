@@ -1,8 +1,9 @@
 #pragma once
 
 #include "UX/randNum.h"
-#include "IO/io.h"
-#include "parameters.h"
+#include "simulationParameters.h"
+
+struct UpdateParameters;
 
 extern uint32_t globalWallId;
 
@@ -1551,7 +1552,7 @@ struct Lighting {
 
 	void emission();
 
-	void lightRendering(UpdateParameters& myParam);
+	void lightRendering();
 
 	void drawRays() {
 
@@ -1642,64 +1643,6 @@ struct Lighting {
 
 	int totalLights = 0;
 
-	void rayLogic(UpdateVariables& myVar, UpdateParameters& myParam) {
-
-		if (shouldRender) {
-			rays.clear();
-			currentSamples = 0;
-
-			accumulatedRays = 0;
-			accumulationResetRequested = true;
-			shouldRender = false;
-		}
-
-		if (IO::shortcutPress(KEY_C)) {
-			shouldRender = true;
-		}
-
-		createPointLight(myVar, myParam);
-		createAreaLight(myVar, myParam);
-		createConeLight(myVar, myParam);
-		createWall(myVar, myParam);
-		createShape(myVar, myParam);
-
-		if (!walls.empty()) {
-			wallPointers.clear();
-			for (Wall& wall : walls) {
-				wallPointers.push_back(&wall);
-			}
-			bvh.build(wallPointers);
-		}
-
-		moveLogic(myVar, myParam);
-
-		eraseLogic(myVar, myParam);
-
-		selectLogic(myVar, myParam);
-
-		lightRendering(myParam);
-
-		drawRays();
-
-		totalLights = static_cast<int>(pointLights.size()) + static_cast<int>(areaLights.size()) + static_cast<int>(coneLights.size());
-
-		if (currentSamples <= maxSamples) {
-			accumulatedRays += static_cast<int>(rays.size());
-		}
-
-		if (IO::shortcutPress(KEY_C)) {
-			rays.clear();
-			pointLights.clear();
-			areaLights.clear();
-			coneLights.clear();
-			walls.clear();
-			shapes.clear();
-
-			wallPointers.clear();
-			for (Wall& wall : walls) {
-				wallPointers.push_back(&wall);
-			}
-			bvh.build(wallPointers);
-		}
-	}
+	// Editing tools, ray tracing and drawing of one frame. Defined with the tools in lightingTools.cpp
+	void rayLogic(UpdateVariables& myVar, UpdateParameters& myParam);
 };
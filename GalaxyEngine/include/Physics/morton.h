@@ -2,16 +2,34 @@
 
 #include "Particles/particle.h"
 
+struct MortonEntry {
+	uint64_t key;
+	uint32_t index;
+};
+
 struct Morton {
+
+	// 32 bits per axis, so a full key fills 64 bits and the tree can go 32 levels deep
+	static constexpr int bitsPerAxis = 32;
+
+	std::vector<MortonEntry> entries;
+	std::vector<MortonEntry> scratch;
+
+	std::vector<ParticlePhysics> pSorted;
+	std::vector<ParticleRendering> rSorted;
+
 	uint64_t scaleToGrid(float pos, float minVal, float maxVal = 3840);
 
 	uint64_t spreadBits(uint64_t x);
 
 	uint64_t morton2D(uint64_t x, uint64_t y);
 
-	void computeMortonKeys(std::vector<ParticlePhysics>& pParticles, glm::vec3& posSize);
+	// Fills entries with one 64-bit key per particle and radix sorts them on up to threads threads. Particles are not
+	// moved
+	void computeSortedKeys(const std::vector<ParticlePhysics>& pParticles, const glm::vec3& posSize, int threads);
 
-	static void sortParticlesByMortonKey(std::vector<ParticlePhysics>& pParticles,
-		std::vector<ParticleRendering>& rParticles);
+	// Reorders both particle vectors to match entries after computeSortedKeys
+	void reorderParticles(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles);
 
-};
\ No newline at end of file
+	static void radixSort(std::vector<MortonEntry>& entries, std::vector<MortonEntry>& scratch, int threads);
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <complex>
+
+#include "Particles/particle.h"
+
+#include "simulationParameters.h"
+
+// Split of the softened 1/r potential between the mesh and the tree. The mesh takes erf(r / 2rs) / r, whose plane
+// Fourier transform is 2 pi erfc(k rs) / k, and the tree walks what is left up to cutoff, past which it is negligible
+struct TreePMSplit {
+
+	static constexpr int tableSize = 1024;
+	static constexpr float cutoffInScales = 4.5f;
+
+	float scale = 0.0f;
+	float cutoff = 0.0f;
+	float cutoffSq = 0.0f;
+
+	// Long range force factor over [0, cutoff]: the mesh force on a pair is G * m * M * d * longRange(|d|)
+	std::vector<float> longFactor;
+	float invTableStep = 0.0f;
+
+	void setScale(float newScale);
+
+	inline float longRange(float distance) const {
+		float x = distance * invTableStep;
+		int i = static_cast<int>(x);
+
+		if (i >= tableSize - 1) {
+			return longFactor[tableSize - 1];
+		}
+
+		float t = x - static_cast<float>(i);
+		return longFactor[i] + (longFactor[i + 1] - longFactor[i]) * t;
+	}
+};
+
+// Particle mesh gravity. Masses are deposited on a 2^pmGridLevel square grid with cloud in cell or triangular shaped
+// cloud weights, transformed with an FFT and convolved with the force of a unit mass, then the two acceleration
+// components come back in one complex inverse FFT and are interpolated with the same weights. Cost follows the grid
+// size, the particle count only enters the deposit and the interpolation.
+// In looping space the convolution is periodic and done with the Green's function of the plane 1/r potential, the
+// k = 0 mode is dropped, which is the usual neutralizing background of periodic boxes. For TreePM the Green's function
+// is filtered by the split so the mesh only carries the long range part. In closed space the grid is padded to twice
+// its size so the empty half keeps the domain from feeling its own copies, and the softened force is convolved in
+// real space terms
+struct ParticleMesh {
+
+	// Cells a side over the domain
+	int gridSize = 0;
+	int gridLevel = 0;
+
+	// Side of the transforms, twice gridSize when padded
+	int fftSize = 0;
+	bool isIsolated = false;
+
+	// Cells a particle spreads over in each direction: 2 for cloud in cell, 3 for triangular shaped cloud
+	int assignmentOrder = 2;
+
+	glm::vec2 domainSize = { 0.0f, 0.0f };
+	glm::vec2 cellSize = { 0.0f, 0.0f };
+
+	TreePMSplit split;
+
+	// Per slice deposit grids, summed into field before the forward transform
+	std::vector<float> threadMass;
+
+	// One line of the transform per thread of the pool
+	std::vector<std::vector<std::complex<double>>> fftScratch;
+
+	std::vector<std::complex<double>> field;
+
+	// Acceleration on the grid from the last solve, kept so the block timestep substeps can sample it at new positions
+	// and the gravity display can show it
+	std::vector<glm::vec2> accGrid;
+
+	// Transform of the softened force of a unit mass as fx + i fy, for the padded grid. Redone when the cells or the
+	// softening change
+	std::vector<std::complex<double>> kernelSpectrum;
+	glm::vec2 kernelCellSize = { 0.0f, 0.0f };
+	float kernelSoftening = -1.0f;
+
+	// Bit reversal and roots of unity for the current fftSize
+	std::vector<uint32_t> bitReverse;
+	std::vector<std::complex<double>> roots;
+
+	// Resizes the grid and split for the periodic domain. The short range walk needs the split, so this runs before it
+	void prepareSplit(const UpdateVariables& myVar);
+
+	// Deposits the particles on the grid prepareSplit() sized and solves. Adds the long range acceleration to acc for
+	// every particle that isn't frozen, on top of the short range part the walk wrote
+	void computeLongRange(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		UpdateVariables& myVar);
+
+	// The whole softened gravity from the mesh alone, periodic in looping space and isolated otherwise. Writes acc for
+	// every particle, zero for frozen ones
+	void computeGravity(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		UpdateVariables& myVar);
+
+	// Mesh acceleration at any position, from the last solve
+	glm::vec2 interpolate(glm::vec2 pos) const;
+
+	void resize(int level, glm::vec2 domain, bool isolated);
+
+	void deposit(const std::vector<ParticlePhysics>& pParticles);
+
+	// Periodic solve. The long range Green's function uses the split, the other one the softening
+	void solvePeriodic(double G, bool isLongRange, float softening);
+
+	void solveIsolated(double G, float softening);
+
+	// Moves the inverse transformed field into accGrid
+	void storeAcceleration(double normalization);
+
+	// Interpolates the mesh acceleration onto every particle that isn't frozen. Adds it to acc, or replaces acc when
+	// isAdding is false and zeroes it for frozen particles
+	void applyAcceleration(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		const UpdateVariables& myVar, bool isAdding) const;
+
+	// In place radix 2 transform of one line of fftSize values spaced by stride
+	void fftLine(std::complex<double>* data, size_t stride, bool inverse, std::complex<double>* scratch) const;
+
+	void fft2D(std::complex<double>* data, bool inverse);
+};
@@ -5,14 +5,61 @@
 #include "Physics/quadtree.h"
 
 #include "Physics/constraint.h"
+#include "Physics/analyticHalo.h"
+
+#include "simulationParameters.h"
+
+// A run of sorted particles that share one tree walk. Groups are the largest subtrees holding at most
+// groupMaxParticles particles
+struct GravityGroup {
+	uint32_t startIndex;
+	uint32_t endIndex;
+};
+
+// Interactions shared by every particle of a group. Cells are accepted nodes, particles come from nearby leaves that
+// had to be opened. Kept as plain float arrays so the evaluation loops vectorize. The gravity walk fills the masses,
+// the heat pass the temperatures
+struct GravityInteractionLists {
+	std::vector<float> cellX;
+	std::vector<float> cellY;
+	std::vector<float> cellMass;
+	std::vector<float> cellTemp;
+
+	// Only filled when quadrupoles are enabled
+	std::vector<float> cellQXX;
+	std::vector<float> cellQXY;
+	std::vector<float> cellQYY;
+
+	std::vector<float> partX;
+	std::vector<float> partY;
+	std::vector<float> partMass;
+	std::vector<float> partTemp;
+
+	void clear() {
+		cellX.clear();
+		cellY.clear();
+		cellMass.clear();
+		cellTemp.clear();
+		cellQXX.clear();
+		cellQXY.clear();
+		cellQYY.clear();
+
+		partX.clear();
+		partY.clear();
+		partMass.clear();
+		partTemp.clear();
+	}
+};
 
-#include "parameters.h"
+struct TreePMSplit;
 
 struct Physics {
 
 	std::vector<ParticleConstraint> particleConstraints;
 	std::unordered_map<uint64_t, ParticleConstraint*> constraintMap;
 
+	AnalyticHalos analyticHalos;
+
 	uint64_t makeKey(uint32_t id1, uint32_t id2) {
 		return id1 < id2 ? ((uint64_t)id1 << 32) | id2
 			: ((uint64_t)id2 << 32) | id1;
@@ -25,6 +72,54 @@ struct Physics {
 	glm::vec2 calculateForceFromGrid(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, 
 		ParticlePhysics& pParticle);
 
+	// Particles gravity leaves alone: pinned ones, and the ones being drawn while SPH is on. The solvers set their
+	// acceleration to zero
+	static bool isGravityFrozen(const ParticleRendering& rParticle, const UpdateVariables& myVar) {
+		return (rParticle.isBeingDrawn && myVar.isBrushDrawing && myVar.isSPHEnabled) || rParticle.isPinned;
+	}
+
+	// Nodes and particles the last gravity walk took for each particle, for the stats window. Sized by the caller
+	std::vector<uint32_t> particleInteractions;
+
+	// Walk for one of the particles the tree was built from. The relative opening criterion reads its acc, so the
+	// caller writes the result only after this returns. Sets particleInteractions[particleIndex]
+	glm::vec2 calculateForceFromGrid(const std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar,
+		uint32_t particleIndex);
+
+	// Tree part of TreePM: only the pairs within the split cutoff, minus the long range part the mesh already covers
+	glm::vec2 calculateShortRangeForce(const std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar,
+		uint32_t particleIndex, const TreePMSplit& split);
+
+	// Force on a probe that isn't part of the tree, walked on a copy of gravityNodes. Quadrupoles must be disabled in
+	// myVar since the copy has none
+	static glm::vec2 calculateForceFromNodes(const std::vector<GravityNode>& nodes, UpdateVariables& myVar, glm::vec2 pos,
+		float mass);
+
+	// Force on one of the particles a private tree was built from, skipping its own leaf. Same quadrupole caveat
+	static glm::vec2 calculateForceFromNodes(const std::vector<GravityNode>& nodes, UpdateVariables& myVar,
+		const std::vector<ParticlePhysics>& pParticles, uint32_t particleIndex);
+
+	static constexpr uint32_t groupMaxParticles = 32;
+
+	std::vector<GravityGroup> gravityGroups;
+
+	std::vector<GravityInteractionLists> interactionLists;
+
+	void buildGravityGroups();
+
+	// Walks the tree once for the whole group against its bounding box, then evaluates the shared lists for every
+	// particle in it. Writes the group's acc and particleInteractions, so groups can run in parallel
+	void calculateGroupForces(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		UpdateVariables& myVar, const GravityGroup& group, GravityInteractionLists& lists);
+
+	// Long range heat exchange for one group, over heatStep. Each particle takes heat from the tree nodes and nearby
+	// particles in proportion to their temperature difference over distance. Reads the temperatures from temps, a
+	// copy taken before the pass, and only writes the group's own pParticles, so groups can run in any order and give
+	// the same result
+	void conductHeat(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		const std::vector<float>& temps, const UpdateVariables& myVar, const GravityGroup& group,
+		GravityInteractionLists& lists, float heatStep);
+
 	void temperatureCalculation(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar);
 
 	void createConstraints(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, bool& constraintCreateSpecialFlag,
@@ -34,13 +129,73 @@ struct Physics {
 
 	void pausedConstraints(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar);
 
+	// Per particle flag for particles already absorbed this frame, and the indices to remove afterwards
+	ScratchVector<uint8_t> mergedScratch{ "Merger flags" };
+	ScratchVector<size_t> mergerDeleteScratch{ "Merger deletions" };
+
 	void mergerSolver(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar);
 
 	void physicsUpdate(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar, bool& sphGround);
 
+	// Velocity gained per unit of timeFactor * acc in physicsUpdate(). The default integrator takes accelerations half
+	// again as strong, the symplectic one as they are. Anything predicting the integrator's step has to use the same
+	static float accelScale(const UpdateVariables& myVar) {
+		return myVar.useSymplecticIntegrator ? 1.0f : 1.5f;
+	}
+
+	// One particle's part of a step, shared by physicsUpdate() and the block timesteps. Kicks the velocity by kickStep
+	// times accelScale() times acc, caps SPH speeds, multiplies it by damping, then drifts the position by driftStep
+	// and wraps it around a periodic domain
+	static void stepParticle(ParticlePhysics& pParticle, float kickStep, float driftStep, float damping,
+		const UpdateVariables& myVar, bool sphGround) {
+
+		pParticle.vel += kickStep * accelScale(myVar) * pParticle.acc;
+
+		// Max velocity for SPH
+		if (myVar.isSPHEnabled) {
+			const float sphMaxVelSq = myVar.sphMaxVel * myVar.sphMaxVel;
+			float vSq = pParticle.vel.x * pParticle.vel.x + pParticle.vel.y * pParticle.vel.y;
+			float prevVSq = pParticle.prevVel.x * pParticle.prevVel.x + pParticle.prevVel.y * pParticle.prevVel.y;
+			if (vSq > sphMaxVelSq) {
+				float invPrevLen = myVar.sphMaxVel / sqrtf(prevVSq);
+				float invLen = myVar.sphMaxVel / sqrtf(vSq);
+				pParticle.prevVel *= invPrevLen;
+				pParticle.vel *= invLen;
+			}
+		}
+
+		pParticle.vel *= damping;
+
+		pParticle.pos += pParticle.vel * driftStep;
+
+		if (myVar.isPeriodicBoundaryEnabled && !sphGround) {
+			if (pParticle.pos.x < 0.0f)
+				pParticle.pos.x += myVar.domainSize.x;
+			else if (pParticle.pos.x >= myVar.domainSize.x)
+				pParticle.pos.x -= myVar.domainSize.x;
+
+			if (pParticle.pos.y < 0.0f)
+				pParticle.pos.y += myVar.domainSize.y;
+			else if (pParticle.pos.y >= myVar.domainSize.y)
+				pParticle.pos.y -= myVar.domainSize.y;
+		}
+	}
+
+	// Deletes the particles that left a closed domain. Ground mode walls keep them in
+	static void removeOutsideDomain(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
+		const UpdateVariables& myVar, bool sphGround);
+
+	// Velocity damping over a step of the given length
+	static float dampingFactor(const UpdateVariables& myVar, float step);
+
 	void collisions(ParticlePhysics& pParticleA, ParticlePhysics& pParticleB,
 		ParticleRendering& rParticleA, ParticleRendering& rParticleB, float& radius);
 
+	// Cell list of the spawn correction grid, particles sorted by cell with each cell's start offset
+	ScratchVector<uint32_t> spawnCellStartScratch{ "Spawn cell starts" };
+	ScratchVector<uint32_t> spawnCellIdScratch{ "Spawn cell ids" };
+	ScratchVector<size_t> spawnCellParticleScratch{ "Spawn cell particles" };
+
 	void buildGrid(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
 		Physics& physics, glm::vec2& domainSize, const int& iterations);
 };
\ No newline at end of file
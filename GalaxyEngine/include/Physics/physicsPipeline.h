@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Particles/particle.h"
+
+#include "Physics/quadtree.h"
+#include "Physics/physics.h"
+#include "Physics/fmm.h"
+#include "Physics/particleMesh.h"
+#include "Physics/SPH.h"
+
+#include "simulationParameters.h"
+
+// Milliseconds spent in each phase during the last step
+struct PhaseTimings {
+	double treeBuild = 0.0;
+	double neighbors = 0.0;
+	double gravity = 0.0;
+	double merger = 0.0;
+	double sph = 0.0;
+	double constraints = 0.0;
+	double integration = 0.0;
+	double temperature = 0.0;
+
+	double total() const {
+		return treeBuild + neighbors + gravity + merger + sph + constraints + integration + temperature;
+	}
+};
+
+// The physics part of updateScene(). None of this touches input, ImGui, the camera or any drawing call, so the same
+// code steps the interactive app and ge-headless.
+struct PhysicsPipeline {
+
+	PhaseTimings timings;
+
+	FMM fmm;
+
+	ParticleMesh mesh;
+
+	TreeRefit treeRefit;
+
+	// Frames and time since the last heat conduction pass
+	int heatFramesPending = 0;
+	float heatTimePending = 0.0f;
+
+	// Set after a block timestep frame. Every particle still owes the closing half kick of its last step
+	bool isBlockKickPending = false;
+
+	ScratchVector<uint32_t> activeParticleScratch{ "Block step active particles" };
+
+	ScratchVector<float> heatTempScratch{ "Heat conduction temperatures" };
+
+	glm::vec3 bb = { 0.0f, 0.0f, 0.0f };
+
+	// Set when buildTree() skipped the build. globalNodes and gravityNodes are then from an older frame
+	bool isTreeStale = true;
+
+	static glm::vec3 boundingBox(const std::vector<ParticlePhysics>& pParticles);
+
+	// Refits the tree instead when tree refit is on and it still fits. Skipped when nothing this frame walks it
+	void buildTree(UpdateVariables& myVar, SimulationParameters& simParam);
+
+	// PM gravity alone needs no tree. The other solvers, the GPU pass and a heat conduction pass do
+	bool needsTree(const UpdateVariables& myVar) const;
+
+	// Builds the tree if buildTree() skipped it, for readers outside the solvers like the path prediction. Must run
+	// before computeGravity(), the build reorders the particles
+	void requireTree(UpdateVariables& myVar, SimulationParameters& simParam);
+
+	// Always refits the current tree, and only builds a new one when it doesn't fit anymore. Block substeps count
+	// toward the refit's rebuild interval like frames do
+	void refitTree(UpdateVariables& myVar, SimulationParameters& simParam);
+
+	// Full Morton build. Records it for refitting when tree refit or block steps will refit it
+	void rebuildTree(UpdateVariables& myVar, SimulationParameters& simParam);
+
+	void prepareNeighbors(UpdateVariables& myVar, SimulationParameters& simParam);
+
+	void computeGravity(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics);
+
+	// Long range heat exchange on the tree built this frame, in its own pass after the gravity walk. Runs every
+	// heatConductionInterval frames over the time they covered. Must run before anything that moves, removes or
+	// reorders particles
+	void conductHeat(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics);
+
+	// Average and largest physics.particleInteractions over the particles the tree walk ran for, into myVar for the
+	// stats window
+	void countInteractions(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics);
+
+	// Adds the analytic halos on top of accelerations computed elsewhere, like the GPU gravity pass. computeGravity()
+	// already includes them
+	void addHaloGravity(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics);
+
+	void solveInteractions(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics, SPH& sph);
+
+	void integrate(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics);
+
+	// SPH and the GPU pass step every particle at once, so they keep physicsUpdate()
+	static bool usesBlockSteps(const UpdateVariables& myVar) {
+		return myVar.isBlockTimestepEnabled && !myVar.isSPHEnabled && !myVar.isGPUEnabled;
+	}
+
+	// Kick drift kick leapfrog where each particle steps by timeFactor / 2^stepLevel, picked from its acceleration.
+	// The frame is cut into 2^maxStepLevel substeps. Everything drifts every substep, but only particles whose step
+	// ends there get a new force walk on the tree refit to the current positions. Kicks, drifts, damping and deletion
+	// are physicsUpdate()'s, through Physics::stepParticle(). Used by integrate()
+	void integrateBlockSteps(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics);
+
+	// One full fixed step with time always playing, ends the arena frame. Used by ge-headless
+	void step(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics, SPH& sph);
+};
@@ -1,33 +1,43 @@
 #pragma once
 
 #include "Particles/particle.h"
+#include "Physics/morton.h"
 
-// --- UNUSED QUADTREE FOR MORTON KEYS VERSION --- //
-//struct Node {
-//	glm::vec2 pos;
-//	float size;
-//	float mass;
-//	glm::vec2 CoM;
-//	uint32_t next;
-//	int level;
-//
-//	Node(glm::vec2 pos, float size, float mass, glm::vec2 CoM, uint32_t next, int level) {
-//		this->pos = pos;
-//		this->size = size;
-//		this->mass = mass;
-//		this->CoM = CoM;
-//		this->next = next;
-//		this->level = level;
-//	}
-//};
-//
-//struct TestTree {
-//	static std::vector<Node> nodesTest;
-//};
+#include "UX/frameArena.h"
 
 struct Node;
 extern std::vector<Node> globalNodes;
 
+// Traversal copy of a Node for the gravity walk, 20 bytes instead of 64. Leaves store a size of 0 so the opening test
+// always accepts them, which also means a leaf never needs its next offset
+struct GravityNode {
+	glm::vec2 centerOfMass;
+	float gridMass;
+	float sizeSq;
+
+	// Internal nodes: next. Leaves: index of their only particle, or UINT32_MAX when they hold several
+	uint32_t nextOrParticle;
+
+	inline bool isLeaf() const {
+		return sizeSq == 0.0f;
+	}
+};
+
+extern std::vector<GravityNode> gravityNodes;
+
+// Average temperature per node, parallel to gravityNodes. Only read when temperature is enabled
+extern std::vector<float> gravityNodeTemps;
+
+// Quadrupole moment about the center of mass, Q = sum of m * (3 * r * r^T - |r|^2 * I) over the xy block.
+// Parallel to gravityNodes, only read when quadrupoles are enabled
+struct GravityQuadrupole {
+	float xx;
+	float xy;
+	float yy;
+};
+
+extern std::vector<GravityQuadrupole> gravityNodeQuads;
+
 struct Node {
 	glm::vec2 pos;
 	float size;
@@ -39,16 +49,33 @@ struct Node {
 	glm::vec2 centerOfMass;
 	float gridTemp;
 
+	GravityQuadrupole quadrupole;
+
 	uint32_t subGrids[2][2] = { { UINT32_MAX, UINT32_MAX }, { UINT32_MAX, UINT32_MAX } };
 	uint32_t next = 0;
 
-	Node(glm::vec2 pos, float size,
-		uint32_t startIndex, uint32_t endIndex,
-		std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles);
+	Node(glm::vec2 pos, float size, uint32_t startIndex, uint32_t endIndex) {
+		this->pos = pos;
+		this->size = size;
+		this->startIndex = startIndex;
+		this->endIndex = endIndex;
+		this->gridMass = 0.0f;
+		this->centerOfMass = { 0.0f, 0.0f };
+		this->gridTemp = 0.0f;
+		this->quadrupole = { 0.0f, 0.0f, 0.0f };
+	}
 
 	Node() = default;
 
-	void subGridMaker(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles);
+	static inline bool isLeaf(uint32_t count, float size) {
+		return ((count <= 16 /*Max Leaf Particles*/ && size <= 2.0f) /*Max Non-Dense Size*/ || count == 1) ||
+			size <= 0.01f /*Min Leaf Size*/;
+	}
+
+	inline bool hasChildren() const {
+		return subGrids[0][0] != UINT32_MAX || subGrids[0][1] != UINT32_MAX ||
+			subGrids[1][0] != UINT32_MAX || subGrids[1][1] != UINT32_MAX;
+	}
 
 	inline void computeLeafMass(const std::vector<ParticlePhysics>& pParticles) {
 		gridMass = 0.0f;
@@ -64,9 +91,25 @@ struct Node {
 		if (gridMass > 0) {
 			centerOfMass /= gridMass;
 		}
+
+		quadrupole = { 0.0f, 0.0f, 0.0f };
+
+		if (endIndex - startIndex > 1) {
+			for (uint32_t i = startIndex; i < endIndex; ++i) {
+				addQuadrupoleTerm(pParticles[i].pos - centerOfMass, pParticles[i].mass);
+			}
+		}
+	}
+
+	inline void addQuadrupoleTerm(glm::vec2 r, float mass) {
+		float rSq = r.x * r.x + r.y * r.y;
+
+		quadrupole.xx += mass * (3.0f * r.x * r.x - rSq);
+		quadrupole.xy += mass * (3.0f * r.x * r.y);
+		quadrupole.yy += mass * (3.0f * r.y * r.y - rSq);
 	}
 
-	inline void computeInternalMass() {
+	inline void computeInternalMass(const std::vector<Node>& nodes = globalNodes) {
 		gridMass = 0.0f;
 		gridTemp = 0.0f;
 		centerOfMass = { 0.0f, 0.0f };
@@ -77,7 +120,7 @@ struct Node {
 
 				if (idx == UINT32_MAX) continue;
 
-				Node& child = globalNodes[idx];
+				const Node& child = nodes[idx];
 
 				gridMass += child.gridMass;
 				gridTemp += child.gridTemp;
@@ -89,9 +132,28 @@ struct Node {
 		if (gridMass > 0) {
 			centerOfMass /= gridMass;
 		}
+
+		// Parallel axis theorem: each child's moment plus its mass moved to the child's center of mass
+		quadrupole = { 0.0f, 0.0f, 0.0f };
+
+		for (int i = 0; i < 2; ++i) {
+			for (int j = 0; j < 2; ++j) {
+				uint32_t idx = subGrids[i][j];
+
+				if (idx == UINT32_MAX) continue;
+
+				const Node& child = nodes[idx];
+
+				quadrupole.xx += child.quadrupole.xx;
+				quadrupole.xy += child.quadrupole.xy;
+				quadrupole.yy += child.quadrupole.yy;
+
+				addQuadrupoleTerm(child.centerOfMass - centerOfMass, child.gridMass);
+			}
+		}
 	}
 
-	inline void calculateNextNeighbor() {
+	inline void calculateNextNeighbor(const std::vector<Node>& nodes = globalNodes) {
 
 		next = 0;
 
@@ -103,7 +165,7 @@ struct Node {
 
 				next++;
 
-				Node& child = globalNodes[idx];
+				const Node& child = nodes[idx];
 
 				next += child.next;
 			}
@@ -111,19 +173,90 @@ struct Node {
 	}
 };
 
+struct PendingNode {
+	glm::vec2 pos;
+	float size;
+	uint32_t startIndex;
+	uint32_t endIndex;
+	int level;
+	uint32_t parent;
+	int quadrant;
+};
+
+// Builds globalNodes from Morton sorted particles. The particles get reordered along the curve, then the nodes are
+// emitted depth first over the sorted keys, so the layout matches the old recursive partition build: children follow
+// their parent and next skips the whole subtree.
+// The top of the tree is split serially until ranges drop under a cutoff. Each of those subtrees is built by its own
+// thread into its own buffer, then everything is spliced into globalNodes with child indices shifted
 struct Quadtree {
 
 	glm::vec3 boundingBox;
 
-	Quadtree(std::vector<ParticlePhysics>& pParticles,
+	static std::vector<std::vector<Node>> taskBuffers;
+
+	// Segments list the top nodes and the subtrees in depth first order. While the top is being split, the subGrids of
+	// top nodes point at segments instead of nodes
+	struct Segment {
+		bool isTask;
+		uint32_t index;
+		uint32_t offset;
+	};
+
+	// Scratch for splitting the top of the tree, defined in simulationState.cpp next to frameArena
+	static ScratchVector<Segment> segmentScratch;
+	static ScratchVector<Node> topNodeScratch;
+	static ScratchVector<PendingNode> taskScratch;
+	static ScratchVector<PendingNode> stackScratch;
+
+	Quadtree(Morton& morton,
+		std::vector<ParticlePhysics>& pParticles,
 		std::vector<ParticleRendering>& rParticles,
 		glm::vec3& boundingBox) {
 
 		this->boundingBox = boundingBox;
 
-		root(pParticles, rParticles);
+		root(morton, pParticles, rParticles);
 	}
 
-	void root(std::vector<ParticlePhysics>& pParticles,
+	void root(Morton& morton,
+		std::vector<ParticlePhysics>& pParticles,
 		std::vector<ParticleRendering>& rParticles);
+
+	static void buildSubtree(const std::vector<MortonEntry>& entries, const PendingNode& subtreeRoot, std::vector<Node>& nodes);
+
+	static void computeMasses(const std::vector<ParticlePhysics>& pParticles, std::vector<Node>& nodes);
+
+	// Fills gravityNodes and gravityNodeTemps from globalNodes
+	static void emitGravityNodes();
+
+	// Traversal copy of one node, for trees built outside globalNodes too
+	static GravityNode toGravityNode(const Node& node);
+};
+
+// Reuses the last build's topology on frames where the particles barely moved. Leaves keep their particle ranges, so
+// nothing is re-sorted: masses and centers of mass are refit bottom-up and every node's box grows to cover where its
+// particles are now, which keeps the opening test conservative. Moving a particle into another leaf would shift every
+// range after it in the flat layout, and most leaves hold a single particle anyway, so drift is measured by how much
+// the internal boxes grew instead. Past maxInflation the walk opens too many nodes and a full rebuild is cheaper
+struct TreeRefit {
+
+	// Summed internal node size over the built one that triggers a rebuild
+	static constexpr float maxInflation = 1.2f;
+
+	// Particle order and node boxes (x, y, size) of the last full build
+	std::vector<uint32_t> particleIds;
+	std::vector<glm::vec3> builtBoxes;
+
+	// Max corners of the boxes while refitting, kept so refit frames don't allocate
+	std::vector<glm::vec2> boxMax;
+
+	int stepsSinceBuild = 0;
+
+	float inflation = 1.0f;
+
+	void recordBuild(const std::vector<ParticlePhysics>& pParticles);
+
+	// Refits globalNodes and the gravity nodes in place. Returns false when the particles changed since the last build
+	// or the boxes grew past maxInflation, and the tree has to be rebuilt
+	bool refit(const std::vector<ParticlePhysics>& pParticles);
 };
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Particles/particle.h"
+#include "Physics/morton.h"
+
+// Flat cell list over a set of positions. The keys are sorted with the parallel radix sort the tree build uses, so a
+// rebuild allocates nothing once the vectors have grown. Cells are numbered row by row over the bounding box of the
+// positions, which makes the three cells of one row of a 3x3 neighborhood a single range of slots
+struct SPHCellList {
+
+	float cellSize = 1.0f;
+	glm::vec2 origin = { 0.0f, 0.0f };
+	int width = 0;
+	int height = 0;
+
+	// Slots in cell order, key is the cell and index the position's index in the input
+	std::vector<MortonEntry> entries;
+	std::vector<MortonEntry> scratch;
+
+	// cellStart[c] to cellStart[c + 1] are the slots of cell c
+	std::vector<uint32_t> cellStart;
+
+	std::vector<float> boundsScratch;
+
+	// Cells are never smaller than minCellSize. The grid holds at most a few cells per position, past that it covers
+	// the bulk of the positions with the outliers clamped into its border, and cells grow if that's still too many
+	void build(const std::vector<glm::vec2>& positions, float minCellSize);
+
+	inline int cellX(float x) const {
+		return static_cast<int>(std::clamp((x - origin.x) / cellSize, 0.0f, static_cast<float>(width - 1)));
+	}
+
+	inline int cellY(float y) const {
+		return static_cast<int>(std::clamp((y - origin.y) / cellSize, 0.0f, static_cast<float>(height - 1)));
+	}
+
+	// Calls func(index) for every position in the 3x3 cells around pos, pos itself included if it's one of them
+	template <typename Func>
+	inline void forEachNeighbor(glm::vec2 pos, Func&& func) const {
+
+		const int cx = cellX(pos.x);
+		const int cy = cellY(pos.y);
+
+		const int minX = std::max(cx - 1, 0);
+		const int maxX = std::min(cx + 1, width - 1);
+
+		for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, height - 1); y++) {
+			const uint32_t row = static_cast<uint32_t>(y) * static_cast<uint32_t>(width);
+
+			const uint32_t end = cellStart[row + maxX + 1];
+			for (uint32_t k = cellStart[row + minX]; k < end; k++) {
+				func(entries[k].index);
+			}
+		}
+	}
+};
+
+// Structure of arrays copy of the particles SPH acts on, in the order of their cells so the particles of a cell and of
+// the cells beside it sit next to each other in memory. Gathered at the start of every step and scattered back at the
+// end, so the rest of the engine keeps working on ParticlePhysics
+struct SPHFluid {
+
+	// Index of each slot's particle in pParticles, and its id
+	std::vector<uint32_t> particleIndex;
+	std::vector<uint32_t> particleId;
+
+	std::vector<glm::vec2> pos;
+	std::vector<glm::vec2> vel;
+	std::vector<glm::vec2> predPos;
+	std::vector<glm::vec2> predVel;
+
+	// Acceleration from everything but SPH, the predictor moves particles by it too
+	std::vector<glm::vec2> acc;
+	std::vector<glm::vec2> force;
+	std::vector<glm::vec2> pressForce;
+
+	std::vector<float> sphMass;
+	std::vector<float> restDens;
+	std::vector<float> stiff;
+	std::vector<float> visc;
+	std::vector<float> cohesion;
+
+	std::vector<float> dens;
+	std::vector<float> predDens;
+	std::vector<float> press;
+	std::vector<float> pressTmp;
+
+	// Prototype stiffness at the slot's rest spacing, see SPH::prototypeStiffness()
+	std::vector<float> protoStiff;
+
+	// Divergence free solver state. densFactor is the stiffness factor of the current positions, densKappa and divKappa
+	// the density and divergence pressures of the last step, which warm start the next one and follow their particle
+	// to its new slot when the fluid is gathered again
+	std::vector<float> densFactor;
+	std::vector<float> densKappa;
+	std::vector<float> divKappa;
+
+	std::vector<uint8_t> isPinned;
+
+	size_t size() const {
+		return particleIndex.size();
+	}
+
+	void resize(size_t count);
+
+	// Copies every SPH particle that isn't being drawn and sorts them by the cells of their position. Leaves cells
+	// built over the gathered positions, with every slot indexing itself
+	void gather(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+		SPHCellList& cells, float cellSize);
+
+	// Copies the same particles as the last gather() into the same slots, wherever the tree build moved them in
+	// pParticles, so neighbor lists over the slots stay usable. Returns false when the fluid isn't the same particles
+	// anymore and gather() has to run
+	bool regather(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles);
+
+	// Writes the pressure state back and sets pressF to force plus pressForce on every particle, zero for those SPH
+	// didn't act on
+	void scatter(std::vector<ParticlePhysics>& pParticles) const;
+
+private:
+
+	std::vector<uint32_t> gatheredIndex;
+	std::vector<glm::vec2> gatheredPos;
+
+	std::vector<uint32_t> prevId;
+	std::vector<float> prevDensKappa;
+	std::vector<float> prevDivKappa;
+
+	// Slot of every particle id gathered last, UINT32_MAX for the others
+	std::vector<uint32_t> slotById;
+
+	void copyFields(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles);
+};
+
+// Neighbors of every fluid slot in compressed rows: neighbors[start[i]] to neighbors[start[i + 1]] are the slots within
+// radius + skin of slot i, itself excluded. The kernels check the radius themselves, so the lists stay good for as long
+// as no particle moved more than half the skin away from where it was at the build, and can be kept for a few steps
+struct SPHNeighborList {
+
+	std::vector<uint32_t> start;
+	std::vector<uint32_t> neighbors;
+
+	// Positions, radius and skin of the build
+	std::vector<glm::vec2> builtPos;
+	float radius = 0.0f;
+	float skin = 0.0f;
+
+	bool isBuilt = false;
+
+	// cells has to be built over positions with cells at least radius + skin wide
+	void build(const std::vector<glm::vec2>& positions, const SPHCellList& cells, float buildRadius, float buildSkin);
+
+	// True if the lists are still good for these slot positions
+	bool holds(const std::vector<glm::vec2>& positions, float currentRadius, float currentSkin) const;
+
+private:
+
+	std::vector<uint32_t> counts;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "UX/threadPool.h"
+
+struct UpdateVariables;
+struct Physics;
+
+// Slingshot path preview. The probe flies through a frozen copy of the gravity tree taken when aiming starts, so the
+// scene's particles are never copied and the tree is walked once per step instead of rebuilt. The integration runs as
+// a task on the thread pool and publishes the path in chunks while it grows. Moving the aim restarts it, and the main thread
+// only ever copies the points done so far
+class TrajectoryPredictor {
+public:
+
+	TrajectoryPredictor() = default;
+
+	TrajectoryPredictor(const TrajectoryPredictor&) = delete;
+	TrajectoryPredictor& operator=(const TrajectoryPredictor&) = delete;
+
+	~TrajectoryPredictor();
+
+	// Copies gravityNodes, the analytic halos and the settings the walk reads. Call once the tree for the frame exists
+	void captureField(const UpdateVariables& myVar, const Physics& physics);
+
+	bool hasField() const {
+		return field != nullptr;
+	}
+
+	// Starts a new path for this launch unless it's the one already running
+	void aim(glm::vec2 pos, glm::vec2 vel, float mass, int steps);
+
+	// Cancels the path and drops the field, for when aiming ends
+	void stop();
+
+	// Points of the current path computed so far
+	void copyPath(std::vector<glm::vec2>& out);
+
+private:
+
+	struct Field;
+
+	struct Launch {
+		glm::vec2 pos = { 0.0f, 0.0f };
+		glm::vec2 vel = { 0.0f, 0.0f };
+		float mass = 0.0f;
+		int steps = 0;
+
+		bool operator==(const Launch& other) const {
+			return pos == other.pos && vel == other.vel && mass == other.mass && steps == other.steps;
+		}
+	};
+
+	// Points the worker publishes at once
+	static constexpr int chunkSteps = 32;
+
+	std::shared_ptr<const Field> field;
+
+	TaskGroup task;
+	std::mutex mutex;
+
+	// Guarded by mutex. requested is bumped by every new launch or field, the worker drops work from older ones.
+	// isRunning is set while the worker task is queued or running, it ends once it catches up with requested
+	Launch launch;
+	bool isAiming = false;
+	bool isRunning = false;
+	uint64_t requested = 0;
+	std::vector<glm::vec2> path;
+
+	// Copy of requested the worker polls between steps to give up early
+	std::atomic<uint64_t> latest{ 0 };
+
+	// Queues the worker task. Called outside the lock after setting isRunning
+	void startWorker();
+
+	void workerLoop();
+};
@@ -3,6 +3,8 @@
 #include "Particles/particle.h"
 #include "Physics/physics.h"
 #include "Physics/light.h"
+#include "IO/io.h"
+#include "parameters.h"
 
 struct CopyPaste {
 
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Bookkeeping for the memory the simulation reuses every frame. Systems keep their temporary arrays as persistent
+// vectors and register them here instead of building new vectors, maps and sets each frame. At the end of the frame
+// the scratch buffers are cleared, which keeps their capacity, so memory only grows to the largest frame seen and a
+// steady scene stops allocating after a few frames. The arena also records how much each buffer used at most. Buffers
+// that are refilled several times a frame (block substeps rebuild the tree) are measured before each refill too
+struct FrameArena {
+
+	struct Entry {
+		const char* name;
+		void* buffer;
+
+		size_t (*usedBytes)(const void* buffer);
+		size_t (*capacityBytes)(const void* buffer);
+
+		// Null for buffers that have to live past the frame, like the gravity tree
+		void (*reset)(void* buffer);
+
+		size_t highWaterBytes = 0;
+	};
+
+	std::vector<Entry> entries;
+
+	// Registers a vector once, later calls with the same vector only measure what it holds. Scratch vectors are also
+	// cleared by endFrame(), the others are only measured
+	template <typename T>
+	void track(const char* name, std::vector<T>& buffer, bool isScratch) {
+
+		for (Entry& entry : entries) {
+			if (entry.buffer == &buffer) {
+				updateHighWater(entry);
+				return;
+			}
+		}
+
+		Entry entry;
+		entry.name = name;
+		entry.buffer = &buffer;
+
+		entry.usedBytes = [](const void* buffer) {
+			return static_cast<const std::vector<T>*>(buffer)->size() * sizeof(T);
+			};
+
+		entry.capacityBytes = [](const void* buffer) {
+			return static_cast<const std::vector<T>*>(buffer)->capacity() * sizeof(T);
+			};
+
+		entry.reset = nullptr;
+		if (isScratch) {
+			entry.reset = [](void* buffer) {
+				static_cast<std::vector<T>*>(buffer)->clear();
+				};
+		}
+
+		entries.push_back(entry);
+	}
+
+	// Measures a tracked buffer before it is emptied and refilled
+	void sample(const void* buffer) {
+		for (Entry& entry : entries) {
+			if (entry.buffer == buffer) {
+				updateHighWater(entry);
+				return;
+			}
+		}
+	}
+
+	void untrack(const void* buffer) {
+		for (size_t i = 0; i < entries.size(); i++) {
+			if (entries[i].buffer == buffer) {
+				entries.erase(entries.begin() + i);
+				return;
+			}
+		}
+	}
+
+	// Updates the high-water marks, then clears the scratch buffers. Called once at the end of every frame
+	void endFrame() {
+		for (Entry& entry : entries) {
+			updateHighWater(entry);
+
+			if (entry.reset) {
+				entry.reset(entry.buffer);
+			}
+		}
+	}
+
+	size_t capacityBytes() const {
+		size_t total = 0;
+		for (const Entry& entry : entries) {
+			total += entry.capacityBytes(entry.buffer);
+		}
+		return total;
+	}
+
+	size_t highWaterBytes() const {
+		size_t total = 0;
+		for (const Entry& entry : entries) {
+			total += entry.highWaterBytes;
+		}
+		return total;
+	}
+
+private:
+	static void updateHighWater(Entry& entry) {
+		size_t used = entry.usedBytes(entry.buffer);
+		if (used > entry.highWaterBytes) {
+			entry.highWaterBytes = used;
+		}
+	}
+};
+
+extern FrameArena& frameArena;
+
+// A per frame vector owned by a system. It registers itself with frameArena on first use and unregisters when destroyed.
+// Copies start empty and untracked. acquire() must be called outside parallel regions
+template <typename T>
+struct ScratchVector {
+
+	const char* name;
+	std::vector<T> data;
+	bool isTracked = false;
+
+	explicit ScratchVector(const char* name) : name(name) {}
+
+	ScratchVector(const ScratchVector& other) : name(other.name) {}
+
+	ScratchVector& operator=(const ScratchVector&) {
+		return *this;
+	}
+
+	~ScratchVector() {
+		if (isTracked) {
+			frameArena.untrack(&data);
+		}
+	}
+
+	// Empty vector to fill, with the capacity of earlier frames. What the last fill used counts toward the peak first
+	std::vector<T>& acquire() {
+		if (!isTracked) {
+			frameArena.track(name, data, true);
+			isTracked = true;
+		}
+		else {
+			frameArena.sample(&data);
+		}
+
+		data.clear();
+		return data;
+	}
+
+	std::vector<T>& acquire(size_t count, const T& value) {
+		acquire().assign(count, value);
+		return data;
+	}
+
+	// Sized vector whose contents the caller overwrites anyway
+	std::vector<T>& acquireSized(size_t count) {
+		acquire().resize(count);
+		return data;
+	}
+};
@@ -4,6 +4,8 @@
 #include <thread>
 #include <vector>
 
+#include "UX/threadPool.h"
+
 inline int clamp_thread_count(size_t work_items, int requested_threads) {
 	if (requested_threads <= 1 || work_items <= 1) {
 		return 1;
@@ -11,6 +13,8 @@ inline int clamp_thread_count(size_t work_items, int requested_threads) {
 	return std::max(1, std::min<int>(requested_threads, static_cast<int>(work_items)));
 }
 
+// Runs func(i, thread) over [begin, end) on the persistent pool with work stealing. thread is below the clamped thread
+// count, so per thread buffers sized with clamp_thread_count() can be indexed with it
 template <typename Func>
 inline void parallel_for(size_t begin, size_t end, int requested_threads, Func&& func) {
 	const size_t count = (end > begin) ? (end - begin) : 0;
@@ -22,24 +26,12 @@ inline void parallel_for(size_t begin, size_t end, int requested_threads, Func&&
 		return;
 	}
 
-	const size_t chunk = (count + static_cast<size_t>(thread_count) - 1) / static_cast<size_t>(thread_count);
-	std::vector<std::thread> workers;
-	workers.reserve(static_cast<size_t>(thread_count));
-
-	for (int t = 0; t < thread_count; ++t) {
-		const size_t start = begin + static_cast<size_t>(t) * chunk;
-		const size_t finish = std::min(end, start + chunk);
-		if (start >= finish) {
-			break;
-		}
-		workers.emplace_back([start, finish, t, &func]() {
-			for (size_t i = start; i < finish; ++i) {
-				func(i, t);
-			}
-		});
-	}
+	threadPool.parallelFor(begin, end, thread_count, func);
+}
 
-	for (auto& worker : workers) {
-		worker.join();
-	}
+// Same on every thread of the pool, which enableMultiThreading() sizes from threadsAmount. For code that doesn't have
+// the settings at hand
+template <typename Func>
+inline void parallel_for(size_t begin, size_t end, Func&& func) {
+	parallel_for(begin, end, threadPool.size(), func);
 }
@@ -2,15 +2,15 @@
 
 #include "Particles/particle.h"
 #include "Physics/light.h"
-#include "Physics/field.h"
 
 #include "Physics/SPH.h"
 #include "Physics/physics.h"
-#include "UI/UI.h"
 
-#include "parameters.h"
+#include "simulationParameters.h"
 
 struct ParticleConstraint;
+struct UpdateParameters;
+struct Field;
 
 inline std::ostream& operator<<(std::ostream& os, const Vector2& vec) {
 	return os << vec.x << " " << vec.y;
@@ -33,7 +33,8 @@ public:
 	const uint32_t version172 = 172;
 	const uint32_t version173 = 173;
 	const uint32_t version174 = 174;
-	const uint32_t currentVersion = version174; // VERY IMPORTANT. CHANGE THIS IF YOU MAKE ANY CHANGES TO THE SAVE SYSTEM. VERSION "1.6.0" = 160, VERSION "1.6.12" = 1612
+	const uint32_t version175 = 175;
+	const uint32_t currentVersion = version175; // VERY IMPORTANT. CHANGE THIS IF YOU MAKE ANY CHANGES TO THE SAVE SYSTEM. VERSION "1.6.0" = 160, VERSION "1.6.12" = 1612
 
 	template <typename T>
 	void paramIO(const std::string& filename, YAML::Emitter& out, std::string key, T& value) {
@@ -112,12 +113,21 @@ public:
 		}
 	}
 
+	// Saves or loads a scene with the app's display settings (trails, colors, camera, brush, gravity field). Defined with
+	// the save menu in saveSystemView.cpp
 	void saveSystem(const std::string& filename, UpdateVariables& myVar, UpdateParameters& myParam, SPH& sph, Physics& physics, Lighting& lighting, Field& field);
 
+	// Saves or loads only what the simulation needs, for ge-headless. Files from the app load too, their display
+	// settings are left alone
+	void saveSystem(const std::string& filename, UpdateVariables& myVar, SimulationParameters& simParam, SPH& sph, Physics& physics, Lighting& lighting);
+
+	// Simulation settings, particles, constraints, optics and halos. The app emits its display settings into out first
+	void sceneIO(const std::string& filename, YAML::Emitter& out, UpdateVariables& myVar, SimulationParameters& simParam, SPH& sph, Physics& physics, Lighting& lighting);
+
 	bool deserializeParticleSystem(const std::string& filename,
 		std::string& yamlString,
 		UpdateVariables& myVar,
-		UpdateParameters& myParam,
+		SimulationParameters& simParam,
 		SPH& sph,
 		Physics& physics,
 		Lighting& lighting,
@@ -162,24 +172,30 @@ public:
 			std::cout << "File version: " << loadedVersion << std::endl;
 		}
 
+		physics.analyticHalos.halos.clear();
+
 		if (loadedVersion == currentVersion) {
-			deserializeVersion172(file, myParam, physics, lighting);
+			deserializeVersion172(file, simParam, physics, lighting);
+			deserializeHalos(file, physics);
+		}
+		else if (loadedVersion == version174) {
+			deserializeVersion172(file, simParam, physics, lighting);
 		}
 		else if (loadedVersion == version173) {
-			deserializeVersion172(file, myParam, physics, lighting);
+			deserializeVersion172(file, simParam, physics, lighting);
 		}
 		else if (loadedVersion == version172) {
-			deserializeVersion172(file, myParam, physics, lighting);
+			deserializeVersion172(file, simParam, physics, lighting);
 		}
 		else if (loadedVersion == version171) {
-			deserializeVersion170(file, myParam, physics, lighting);
+			deserializeVersion170(file, simParam, physics, lighting);
 		}
 		else if (loadedVersion == version170) {
-			deserializeVersion170(file, myParam, physics, lighting);
+			deserializeVersion170(file, simParam, physics, lighting);
 		}
 		else if (loadedVersion == version160) {
 
-			deserializeVersion160(file, myParam);
+			deserializeVersion160(file, simParam);
 
 			physics.particleConstraints.clear();
 			uint32_t numConstraints = 0;
@@ -225,7 +241,7 @@ public:
 		file.close();
 
 		uint32_t maxId = 0;
-		for (const auto& particle : myParam.pParticles) {
+		for (const auto& particle : simParam.pParticles) {
 			if (particle.id > maxId) maxId = particle.id;
 		}
 		globalId = maxId + 1;
@@ -233,7 +249,7 @@ public:
 		return true;
 	}
 
-	bool deserializeVersion172(std::istream& file, UpdateParameters& myParam, Physics& physics, Lighting& lighting) {
+	bool deserializeVersion172(std::istream& file, SimulationParameters& simParam, Physics& physics, Lighting& lighting) {
 
 		file.read(reinterpret_cast<char*>(&globalId), sizeof(globalId));
 		file.read(reinterpret_cast<char*>(&globalShapeId), sizeof(globalShapeId));
@@ -242,10 +258,10 @@ public:
 		uint32_t particleCount;
 		file.read(reinterpret_cast<char*>(&particleCount), sizeof(particleCount));
 
-		myParam.pParticles.clear();
-		myParam.rParticles.clear();
-		myParam.pParticles.reserve(particleCount);
-		myParam.rParticles.reserve(particleCount);
+		simParam.pParticles.clear();
+		simParam.rParticles.clear();
+		simParam.pParticles.reserve(particleCount);
+		simParam.rParticles.reserve(particleCount);
 
 		for (uint32_t i = 0; i < particleCount; i++) {
 			ParticlePhysics p;
@@ -307,8 +323,8 @@ public:
 			file.read(reinterpret_cast<char*>(&r.spawnCorrectIter), sizeof(r.spawnCorrectIter));
 			file.read(reinterpret_cast<char*>(&r.turbulence), sizeof(r.turbulence));
 
-			myParam.pParticles.push_back(p);
-			myParam.rParticles.push_back(r);
+			simParam.pParticles.push_back(p);
+			simParam.rParticles.push_back(r);
 		}
 
 		physics.particleConstraints.clear();
@@ -541,7 +557,33 @@ public:
 		return true;
 	}
 
-	bool deserializeVersion170(std::istream& file, UpdateParameters& myParam, Physics& physics, Lighting& lighting) {
+	// Analytic halos, stored after the lights since version 175
+	bool deserializeHalos(std::istream& file, Physics& physics) {
+
+		uint32_t haloCount = 0;
+		file.read(reinterpret_cast<char*>(&haloCount), sizeof(haloCount));
+
+		physics.analyticHalos.halos.clear();
+		physics.analyticHalos.halos.reserve(haloCount);
+
+		for (uint32_t i = 0; i < haloCount; i++) {
+
+			AnalyticHalo h;
+
+			file.read(reinterpret_cast<char*>(&h.pos), sizeof(h.pos));
+			file.read(reinterpret_cast<char*>(&h.vel), sizeof(h.vel));
+			file.read(reinterpret_cast<char*>(&h.mass), sizeof(h.mass));
+			file.read(reinterpret_cast<char*>(&h.scaleRadius), sizeof(h.scaleRadius));
+			file.read(reinterpret_cast<char*>(&h.cutoffRadius), sizeof(h.cutoffRadius));
+			file.read(reinterpret_cast<char*>(&h.profile), sizeof(h.profile));
+
+			physics.analyticHalos.halos.push_back(h);
+		}
+
+		return true;
+	}
+
+	bool deserializeVersion170(std::istream& file, SimulationParameters& simParam, Physics& physics, Lighting& lighting) {
 
 		file.read(reinterpret_cast<char*>(&globalId), sizeof(globalId));
 		file.read(reinterpret_cast<char*>(&globalShapeId), sizeof(globalShapeId));
@@ -550,10 +592,10 @@ public:
 		uint32_t particleCount;
 		file.read(reinterpret_cast<char*>(&particleCount), sizeof(particleCount));
 
-		myParam.pParticles.clear();
-		myParam.rParticles.clear();
-		myParam.pParticles.reserve(particleCount);
-		myParam.rParticles.reserve(particleCount);
+		simParam.pParticles.clear();
+		simParam.rParticles.clear();
+		simParam.pParticles.reserve(particleCount);
+		simParam.rParticles.reserve(particleCount);
 
 		for (uint32_t i = 0; i < particleCount; i++) {
 			ParticlePhysics p;
@@ -614,8 +656,8 @@ public:
 			file.read(reinterpret_cast<char*>(&r.isBeingDrawn), sizeof(r.isBeingDrawn));
 			file.read(reinterpret_cast<char*>(&r.spawnCorrectIter), sizeof(r.spawnCorrectIter));
 
-			myParam.pParticles.push_back(p);
-			myParam.rParticles.push_back(r);
+			simParam.pParticles.push_back(p);
+			simParam.rParticles.push_back(r);
 		}
 
 		physics.particleConstraints.clear();
@@ -848,15 +890,15 @@ public:
 		return true;
 	}
 
-	bool deserializeVersion160(std::istream& file, UpdateParameters& myParam) {
+	bool deserializeVersion160(std::istream& file, SimulationParameters& simParam) {
 
 		uint32_t particleCount;
 		file.read(reinterpret_cast<char*>(&particleCount), sizeof(particleCount));
 
-		myParam.pParticles.clear();
-		myParam.rParticles.clear();
-		myParam.pParticles.reserve(particleCount);
-		myParam.rParticles.reserve(particleCount);
+		simParam.pParticles.clear();
+		simParam.rParticles.clear();
+		simParam.pParticles.reserve(particleCount);
+		simParam.rParticles.reserve(particleCount);
 
 		for (uint32_t i = 0; i < particleCount; i++) {
 			ParticlePhysics p;
@@ -917,18 +959,19 @@ public:
 			file.read(reinterpret_cast<char*>(&r.isBeingDrawn), sizeof(r.isBeingDrawn));
 			file.read(reinterpret_cast<char*>(&r.spawnCorrectIter), sizeof(r.spawnCorrectIter));
 
-			myParam.pParticles.push_back(p);
-			myParam.rParticles.push_back(r);
+			simParam.pParticles.push_back(p);
+			simParam.rParticles.push_back(r);
 		}
 		return true;
 	}
 
 
+	// Save button and load menu. Defined in saveSystemView.cpp
 	void saveLoadLogic(UpdateVariables& myVar, UpdateParameters& myParam, SPH& sph, Physics& physics, Lighting& lighting, Field& field);
 
 private:
 
-	ImVec2 loadMenuSize = { 600.0f, 500.0f };
+	glm::vec2 loadMenuSize = { 600.0f, 500.0f };
 	float buttonHeight = 30.0f;
 
 	std::vector<std::string> filePaths;
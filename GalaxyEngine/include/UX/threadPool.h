@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Counts the unfinished tasks of one batch started with ThreadPool::run()
+struct TaskGroup {
+	std::atomic<int> pending{ 0 };
+};
+
+// Persistent work stealing pool behind parallel_for() and background tasks. Workers are started once and sleep
+// between jobs, so a loop costs a wake up instead of creating and joining threads.
+// Every thread owns a deque of tasks. It pushes and pops at the back, idle threads steal from the front of the others,
+// where the biggest pieces of work sit. parallelFor() splits its range lazily: a range is only halved while the thread
+// running it has nothing queued, so the grain follows how many threads are actually idle. Clustered scenes, where a
+// few ranges hold most of the work, get split finely, uniform ones run in a few large chunks.
+// The thread that last called resize() owns the pool and runs as thread 0. Loops from threads outside the pool run
+// inline on the caller. There is always at least one worker, so background tasks leave the owner free even when loops
+// run on it alone
+class ThreadPool {
+public:
+
+	ThreadPool() = default;
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool();
+
+	// Total loop threads including the owner. Workers are only restarted when the count changes, so it's safe to call
+	// every frame. Must not be called while a loop is running. A running background task is finished first, queued
+	// ones carry over
+	void resize(int threads);
+
+	int size() const {
+		return threadCount;
+	}
+
+	// Calls func(i, thread) for every i in [begin, end) and returns once all of them are done. thread is below
+	// maxThreads and unique among the threads running at the same time, so it can index per thread buffers. The caller
+	// works too, unless it is a background task whose own index is past maxThreads. minGrain is the smallest piece
+	// split off, 0 picks one from the range size and thread count
+	template <typename Func>
+	void parallelFor(size_t begin, size_t end, int maxThreads, Func&& func, size_t minGrain = 0) {
+
+		using FuncType = std::remove_reference_t<Func>;
+
+		RangeJob job;
+		job.invoke = [](void* func, size_t begin, size_t end, int thread) {
+			FuncType& f = *static_cast<FuncType*>(func);
+			for (size_t i = begin; i < end; i++) {
+				f(i, thread);
+			}
+			};
+		job.func = const_cast<void*>(static_cast<const void*>(&func));
+
+		runRangeJob(job, begin, end, maxThreads, minGrain);
+	}
+
+	// Queues a task that may run on any worker of the pool. Runs inline before the first resize()
+	void run(TaskGroup& group, std::function<void()> task);
+
+	// Helps with queued work until every task of the group is done
+	void wait(TaskGroup& group);
+
+private:
+
+	struct RangeJob {
+		void (*invoke)(void* func, size_t begin, size_t end, int thread);
+		void* func;
+
+		size_t minGrain = 1;
+		int maxThreads = 1;
+
+		std::atomic<size_t> remaining{ 0 };
+	};
+
+	struct Task {
+		RangeJob* job = nullptr;
+		size_t begin = 0;
+		size_t end = 0;
+
+		TaskGroup* group = nullptr;
+		std::function<void()> function;
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+		std::atomic<size_t> count{ 0 };
+	};
+
+	int threadCount = 1;
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<uint64_t> workEpoch{ 0 };
+	std::atomic<int> sleepingWorkers{ 0 };
+	std::atomic<bool> isStopping{ false };
+	// Background tasks taken and not finished. Stopping workers keep helping with loops until it's zero
+	std::atomic<int> runningBackground{ 0 };
+
+	// Index of the calling thread in this pool, -1 for threads outside it
+	int currentThread() const;
+
+	void runRangeJob(RangeJob& job, size_t begin, size_t end, int maxThreads, size_t minGrain);
+
+	void runRange(int thread, RangeJob& job, size_t begin, size_t end);
+
+	void push(int thread, Task task);
+
+	// rangeOnly skips queued background tasks and only takes parallelFor pieces
+	bool pop(int thread, Task& task, bool rangeOnly);
+
+	bool steal(int thread, Task& task, bool rangeOnly);
+
+	// Counts a background task as running before it's taken. Fails once the workers are stopping, the task then
+	// stays queued and carries over
+	bool claimBackground();
+
+	bool findTask(int thread, Task& task, bool rangeOnly);
+
+	void execute(int thread, Task& task);
+
+	void workerLoop(int thread);
+
+	void stopWorkers();
+};
+
+extern ThreadPool threadPool;
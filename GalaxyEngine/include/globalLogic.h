@@ -17,6 +17,8 @@
 #include "Physics/SPH.h"
 #include "Physics/light.h"
 #include "Physics/field.h"
+#include "Physics/physicsPipeline.h"
+#include "Physics/futurePreview.h"
 
 #include "UI/brush.h"
 #include "UI/rightClickSettings.h"
@@ -32,20 +34,19 @@
 #include "UX/copyPaste.h"
 
 #include "parameters.h"
+#include "simulationState.h"
 
 extern UpdateParameters myParam;
-extern UpdateVariables myVar;
 extern UI myUI;
-extern Physics physics;
 extern ParticleSpaceship ship;
-extern SPH sph;
 extern SaveSystem save;
 extern GESound geSound;
-extern Lighting lighting;
 extern CopyPaste copyPaste;
 
 extern Field field;
 
+extern FuturePreview futurePreview;
+
 struct ParticleBounds {
 	float minX, maxX, minY, maxY;
 };
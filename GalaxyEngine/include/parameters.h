@@ -7,9 +7,6 @@
 #include "Particles/particleTrails.h"
 #include "Particles/particleSelection.h"
 #include "Particles/particlesSpawning.h"
-#include "Particles/neighborSearch.h"
-
-#include "Physics/morton.h"
 
 #include "UI/brush.h"
 #include "UI/rightClickSettings.h"
@@ -17,10 +14,9 @@
 
 #include "UX/screenCapture.h"
 
-struct UpdateParameters {
-	std::vector<ParticlePhysics> pParticles;
-	std::vector<ParticleRendering> rParticles;
+#include "simulationParameters.h"
 
+struct UpdateParameters : SimulationParameters {
 	std::vector<ParticlePhysics> pParticlesSelected;
 	std::vector<ParticleRendering> rParticlesSelected;
 
@@ -28,8 +24,6 @@ struct UpdateParameters {
 
 	ScreenCapture screenCapture;
 
-	Morton morton;
-
 	ParticleTrails trails;
 
 	ParticleSelection particleSelection;
@@ -53,206 +47,4 @@ struct UpdateParameters {
 	ParticleDeletion particleDeletion;
 
 	ParticlesSpawning particlesSpawning;
-
-	NeighborSearch neighborSearch;
-};
-
-struct UpdateVariables{
-	int screenWidth = 1920;
-	int screenHeight = 1080;
-	float halfScreenWidth = screenWidth * 0.5f;
-	float halfScreenHeight = screenHeight * 0.5f;
-
-	float screenRatioX = 0.0f;
-	float screenRatioY = 0.0f;
-
-	glm::vec2 domainSize = { 3840.0f, 2160.0f };
-
-	float halfDomainWidth = domainSize.x * 0.5f;
-	float halfDomainHeight = domainSize.y * 0.5f;
-
-	bool fullscreenState = false;
-
-	bool exitGame = false;
-
-	int targetFPS = 144;
-
-	double G = 6.674e-11;
-	float gravityMultiplier = 1.0f;
-	bool gravityRampEnabled = false;
-	float gravityRampStartMult = 1.0f;
-	float gravityRampSeconds = 0.0f;
-	float gravityRampTime = 0.0f;
-	float softening = 2.5f;
-	float theta = 0.8f;
-	float timeStepMultiplier = 1.0f;
-	bool useSymplecticIntegrator = false;
-	float sphMaxVel = 250.0f;
-	float globalHeatConductivity = 0.045f;
-	float globalAmbientHeatRate = 1.0f;
-	float ambientTemp = 274.0f;
-
-	static float particleBaseMass;
-
-	int maxLeafParticles = 1;
-	float minLeafSize = 1.0f;
-
-	const float fixedDeltaTime = 0.045f;
-
-	bool isTimePlaying = true;
-
-	float timeFactor = 1.0f;
-	bool velocityDampingEnabled = true;
-	float velocityDampingPerSecond = 0.01f;
-
-	bool isGlobalTrailsEnabled = false;
-	bool isSelectedTrailsEnabled = false;
-	bool isLocalTrailsEnabled = false;
-	bool isPeriodicBoundaryEnabled = true;
-	bool isMultiThreadingEnabled = true;
-	bool isBarnesHutEnabled = true;
-	bool isDarkMatterEnabled = true;
-	bool isDensitySizeEnabled = false;
-	bool isForceSizeEnabled = false;
-	bool isShipGasEnabled = true;
-	bool isSPHEnabled = false;
-	bool sphGround = false;
-	bool isTempEnabled = false;
-	bool constraintsEnabled = false;
-	bool isOpticsEnabled = false;
-
-	bool isGPUEnabled = false;
-
-	bool isMergerEnabled = false;
-
-	bool longExposureFlag = false;
-	int longExposureDuration = 200;
-	int longExposureCurrent = 0;
-
-	bool isSpawningAllowed = true;
-
-	float particleTextureHalfSize = 16.0f;
-
-	int trailMaxLength = 48;
-
-	static ImVec4 colWindowBg;
-
-	//ImGui style colors
-	static ImVec4 colButton;
-	static ImVec4 colButtonHover;
-	static ImVec4 colButtonPress;
-
-	static ImVec4 colButtonActive;
-	static ImVec4 colButtonActiveHover;
-	static ImVec4 colButtonActivePress;
-
-	static ImVec4 colButtonRedActive;
-	static ImVec4 colButtonRedActiveHover;
-	static ImVec4 colButtonRedActivePress;
-
-	// ImGui slider colors
-	static ImVec4 colSliderGrab;
-	static ImVec4 colSliderGrabActive;
-	static ImVec4 colSliderBg;
-	static ImVec4 colSliderBgHover;
-	static ImVec4 colSliderBgActive;
-
-	// ImPlot style colors
-	static ImVec4 colPlotLine;
-	static ImVec4 colAxisText;
-	static ImVec4 colAxisGrid;
-	static ImVec4 colAxisBg;
-	static ImVec4 colFrameBg;
-	static ImVec4 colPlotBg;
-	static ImVec4 colPlotBorder;
-	static ImVec4 colLegendBg;
-
-	// Text colors
-	static ImVec4 colMenuInformation;
-
-	bool isRecording = false;
-
-	float particleSizeMultiplier = 1.0f;
-
-	bool isDragging = false;
-	bool isMouseNotHoveringUI = false;
-
-	bool drawQuadtree = false;
-	bool drawZCurves = false;
-
-	bool isGlowEnabled = false;
-
-	glm::vec2 mouseWorldPos = { 0.0f, 0.0f };
-
-	int threadsAmount = 4;
-	ImFont* robotoMediumFont = nullptr;
-
-	bool pauseAfterRecording = true;
-	bool cleanSceneAfterRecording = false;
-	float recordingTimeLimit = 0.0f; 
-
-	float globalConstraintStiffnessMult = 1.0f;
-	float globalConstraintResistance = 1.0f;
-
-	bool constraintAllSolids = false;
-	bool constraintSelected = false;
-	bool deleteAllConstraints = false;
-	bool deleteSelectedConstraints = false;
-	bool drawConstraints = false;
-	bool visualizeMesh = false;
-	bool unbreakableConstraints = false;
-	bool constraintStressColor = false;
-
-	bool constraintAfterDrawingFlag = false;
-	bool constraintAfterDrawing = false;
-
-	float constraintMaxStressColor = 0.0f;
-
-	bool pinFlag = false;
-	bool unPinFlag = false;
-
-	bool isBrushDrawing = false;
-	bool autoPausedForBrush = false;
-	bool wasTimePlayingBeforeBrush = false;
-	bool showBrushCursor = true;
-
-	Font customFont = { 0 };
-	int introFontSize = 48;
-
-	bool gridExists = true;
-
-	bool loadDropDownMenus = false;
-
-	bool exportPlyFlag = false;
-	bool exportPlySeqFlag = false;
-
-	int plyFrameNumber = 0;
-
-	bool toolSpawnHeavyParticle = false;
-	bool toolDrawParticles = true;
-	bool toolSpawnSmallGalaxy = false;
-	bool toolSpawnBigGalaxy = false;
-	bool toolSpawnStar = false;
-	bool toolSpawnBigBang = false;
-
-	bool toolErase = false;
-	bool toolRadialForce = false;
-	bool toolSpin = false;
-	bool toolMove = false;
-	bool toolRaiseTemp = false;
-	bool toolLowerTemp = false;
-
-	bool toolPointLight = false;
-	bool toolAreaLight = false;
-	bool toolConeLight = false;
-	bool toolCircle = false;
-	bool toolDrawShape = false;
-	bool toolLens = false;
-	bool toolWall = false;
-	bool toolMoveOptics = false;
-	bool toolEraseOptics = false;
-	bool toolSelectOptics = false;
-
-	bool isGravityFieldEnabled = false;
-	bool gravityFieldDMParticles = false;
 };
@@ -1,53 +1,9 @@
 #pragma once
 
-// C++ stdlib
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <istream>
-#include <ostream>
-#include <filesystem>
-#include <array>
-#include <algorithm>
-#include <memory>
-#include <limits> 
-#include <chrono>
-#include <regex>
-#include <variant>
-#include <thread>
-#include <bitset>
-#include <random>
-#include <stack>
-#include <execution>
+// Everything the simulation core builds with
+#include "pchCore.h"
 
-// C stdlib
-#include <cmath>
-#include <cstdint>
-#include <cstdio>
-
-// Runtime
-#if defined(_OPENMP)
-#if __has_include(<omp.h>)
-#include <omp.h>
-#elif defined(EMSCRIPTEN)
-extern "C" {
-void omp_set_num_threads(int);
-int omp_get_max_threads(void);
-}
-#else
-#error "OpenMP requested but <omp.h> not found."
-#endif
-#endif
-
-// Vendor
-#include <glm.hpp>
-
-#include <raylib.h>
-#include <raymath.h>
+// Rendering and UI
 #include <rlgl.h>
 #if defined(EMSCRIPTEN)
 #include <GLES3/gl3.h>
@@ -67,5 +23,3 @@ int omp_get_max_threads(void);
 #include <rlImGui.h>
 #include <rlImGuiColors.h>
 #endif
-
-#include <yaml-cpp/yaml.h>
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Particles/particle.h"
+#include "Particles/neighborSearch.h"
+
+#include "Physics/morton.h"
+
+// The particles and the per particle search state the physics pipeline steps. UpdateParameters adds the camera,
+// brush, selection and the rest of the UI state on top
+struct SimulationParameters {
+	std::vector<ParticlePhysics> pParticles;
+	std::vector<ParticleRendering> rParticles;
+
+	Morton morton;
+
+	NeighborSearch neighborSearch;
+};
+
+struct UpdateVariables{
+	int screenWidth = 1920;
+	int screenHeight = 1080;
+	float halfScreenWidth = screenWidth * 0.5f;
+	float halfScreenHeight = screenHeight * 0.5f;
+
+	float screenRatioX = 0.0f;
+	float screenRatioY = 0.0f;
+
+	glm::vec2 domainSize = { 3840.0f, 2160.0f };
+
+	float halfDomainWidth = domainSize.x * 0.5f;
+	float halfDomainHeight = domainSize.y * 0.5f;
+
+	bool fullscreenState = false;
+
+	bool exitGame = false;
+
+	int targetFPS = 144;
+
+	double G = 6.674e-11;
+	float gravityMultiplier = 1.0f;
+	bool gravityRampEnabled = false;
+	float gravityRampStartMult = 1.0f;
+	float gravityRampSeconds = 0.0f;
+	float gravityRampTime = 0.0f;
+	float softening = 2.5f;
+	float theta = 0.8f;
+
+	// Opens nodes by their estimated force error relative to each particle's last acceleration instead of by theta
+	bool isRelativeOpeningEnabled = false;
+	float openingAccuracy = 0.005f;
+
+	// Filled by the CPU tree walks every step for the stats window, 0 when another solver ran
+	float averageInteractions = 0.0f;
+	int maxInteractions = 0;
+
+	bool isGroupWalkEnabled = false;
+	bool isQuadrupoleEnabled = false;
+
+	bool isTreeRefitEnabled = false;
+	int treeRebuildInterval = 30;
+
+	float timeStepMultiplier = 1.0f;
+	bool useSymplecticIntegrator = false;
+
+	// Power of two block timesteps for gravity, up to 2^maxStepLevel substeps per frame
+	bool isBlockTimestepEnabled = false;
+	int maxStepLevel = 4;
+	float blockStepAccuracy = 0.1f;
+
+	float sphMaxVel = 250.0f;
+	float globalHeatConductivity = 0.045f;
+	int heatConductionInterval = 1;
+	float globalAmbientHeatRate = 1.0f;
+	float ambientTemp = 274.0f;
+
+	static float particleBaseMass;
+
+	int maxLeafParticles = 1;
+	float minLeafSize = 1.0f;
+
+	const float fixedDeltaTime = 0.045f;
+
+	bool isTimePlaying = true;
+
+	float timeFactor = 1.0f;
+	bool velocityDampingEnabled = true;
+	float velocityDampingPerSecond = 0.01f;
+
+	bool isGlobalTrailsEnabled = false;
+	bool isSelectedTrailsEnabled = false;
+	bool isLocalTrailsEnabled = false;
+	bool isPeriodicBoundaryEnabled = true;
+	bool isMultiThreadingEnabled = true;
+	bool isBarnesHutEnabled = true;
+	bool isDarkMatterEnabled = true;
+
+	// Galaxies get one analytic halo instead of dark matter particles. 0 NFW, 1 Plummer, 2 cored isothermal
+	bool isAnalyticHaloEnabled = false;
+	int haloProfile = 2;
+	bool freezeDarkMatterFlag = false;
+	bool deleteHalosFlag = false;
+	bool isDensitySizeEnabled = false;
+	bool isForceSizeEnabled = false;
+	bool isShipGasEnabled = true;
+	bool isSPHEnabled = false;
+	bool sphGround = false;
+	bool isDFSPHEnabled = false;
+	bool isTempEnabled = false;
+	bool constraintsEnabled = false;
+	bool isOpticsEnabled = false;
+
+	bool isGPUEnabled = false;
+
+	bool isFMMEnabled = false;
+	int fmmOrder = 6;
+
+	// Mesh long range plus truncated tree short range, only with looping space. The mesh has 2^pmGridLevel cells a side
+	bool isTreePMEnabled = false;
+	int pmGridLevel = 8;
+
+	// Gravity from the mesh alone, for previews of very large scenes. Periodic in looping space, isolated otherwise.
+	// TSC spreads each particle over 3x3 cells instead of 2x2, smoother forces for a bit more work
+	bool isPMEnabled = false;
+	bool isPMTSCEnabled = false;
+
+	bool isMergerEnabled = false;
+
+	bool longExposureFlag = false;
+	int longExposureDuration = 200;
+	int longExposureCurrent = 0;
+
+	bool isSpawningAllowed = true;
+
+	float particleTextureHalfSize = 16.0f;
+
+	int trailMaxLength = 48;
+
+	// Predicted orbits of the selected particles from a coarse simulation of the scene on a background thread
+	bool isFutureOrbitsEnabled = false;
+	int futureOrbitSteps = 600;
+	float futureOrbitStepScale = 4.0f;
+	float futureOrbitTheta = 1.2f;
+	int futureOrbitMaxBodies = 20000;
+	int futureOrbitThreads = 1;
+
+	bool isRecording = false;
+
+	float particleSizeMultiplier = 1.0f;
+
+	bool isDragging = false;
+	bool isMouseNotHoveringUI = false;
+
+	bool drawQuadtree = false;
+	bool drawZCurves = false;
+
+	bool isGlowEnabled = false;
+
+	glm::vec2 mouseWorldPos = { 0.0f, 0.0f };
+
+	int threadsAmount = 4;
+
+	bool pauseAfterRecording = true;
+	bool cleanSceneAfterRecording = false;
+	float recordingTimeLimit = 0.0f; 
+
+	float globalConstraintStiffnessMult = 1.0f;
+	float globalConstraintResistance = 1.0f;
+
+	bool constraintAllSolids = false;
+	bool constraintSelected = false;
+	bool deleteAllConstraints = false;
+	bool deleteSelectedConstraints = false;
+	bool drawConstraints = false;
+	bool visualizeMesh = false;
+	bool unbreakableConstraints = false;
+	bool constraintStressColor = false;
+
+	bool constraintAfterDrawingFlag = false;
+	bool constraintAfterDrawing = false;
+
+	float constraintMaxStressColor = 0.0f;
+
+	bool pinFlag = false;
+	bool unPinFlag = false;
+
+	bool isBrushDrawing = false;
+	bool autoPausedForBrush = false;
+	bool wasTimePlayingBeforeBrush = false;
+	bool showBrushCursor = true;
+
+	Font customFont = { 0 };
+	int introFontSize = 48;
+
+	bool gridExists = true;
+
+	bool loadDropDownMenus = false;
+
+	bool exportPlyFlag = false;
+	bool exportPlySeqFlag = false;
+
+	int plyFrameNumber = 0;
+
+	bool toolSpawnHeavyParticle = false;
+	bool toolDrawParticles = true;
+	bool toolSpawnSmallGalaxy = false;
+	bool toolSpawnBigGalaxy = false;
+	bool toolSpawnStar = false;
+	bool toolSpawnBigBang = false;
+
+	bool toolErase = false;
+	bool toolRadialForce = false;
+	bool toolSpin = false;
+	bool toolMove = false;
+	bool toolRaiseTemp = false;
+	bool toolLowerTemp = false;
+
+	bool toolPointLight = false;
+	bool toolAreaLight = false;
+	bool toolConeLight = false;
+	bool toolCircle = false;
+	bool toolDrawShape = false;
+	bool toolLens = false;
+	bool toolWall = false;
+	bool toolMoveOptics = false;
+	bool toolEraseOptics = false;
+	bool toolSelectOptics = false;
+
+	bool isGravityFieldEnabled = false;
+	bool gravityFieldDMParticles = false;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Physics/physics.h"
+#include "Physics/SPH.h"
+#include "Physics/light.h"
+#include "Physics/physicsPipeline.h"
+
+#include "simulationParameters.h"
+
+// Simulation state, defined in GalaxyEngineCore. The app keeps the UI, sound and capture state in globalLogic.cpp on
+// top of this, ge-headless uses these alone
+extern UpdateVariables myVar;
+extern Physics physics;
+extern SPH sph;
+extern Lighting lighting;
+extern PhysicsPipeline pipeline;
@@ -2,6 +2,8 @@
 
 #include "parameters.h"
 
+#include "UI/UI.h"
+
 void ParticleSubdivision::subdivideParticles(UpdateVariables& myVar, UpdateParameters& myParam) {
 
 	if (subdivideAll || subdivideSelected) {
@@ -21,7 +23,7 @@ void ParticleSubdivision::subdivideParticles(UpdateVariables& myVar, UpdateParam
 
 			ImGui::Begin("##SubdivisionWarning", nullptr, ImGuiWindowFlags_NoCollapse);
 
-			ImGui::PushFont(myVar.robotoMediumFont);
+			ImGui::PushFont(UI::robotoMediumFont);
 
 			std::string warning = "SUBDIVIDING FURTHER MIGHT HEAVILY SLOW DOWN PERFORMANCE";
 
@@ -37,9 +39,9 @@ void ParticleSubdivision::subdivideParticles(UpdateVariables& myVar, UpdateParam
 				confirmState = !confirmState;
 			}
 
-			ImGui::PushStyleColor(ImGuiCol_Button, UpdateVariables::colButtonRedActive);
-			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UpdateVariables::colButtonRedActiveHover);
-			ImGui::PushStyleColor(ImGuiCol_ButtonActive, UpdateVariables::colButtonRedActivePress);
+			ImGui::PushStyleColor(ImGuiCol_Button, UI::colButtonRedActive);
+			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UI::colButtonRedActiveHover);
+			ImGui::PushStyleColor(ImGuiCol_ButtonActive, UI::colButtonRedActivePress);
 			if (ImGui::Button("Quit", ImVec2(ImGui::GetContentRegionAvail().x, 40.0f))) {
 				quitState = !quitState;
 			}
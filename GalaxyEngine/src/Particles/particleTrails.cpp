@@ -154,6 +154,7 @@ void ParticleTrails::trailLogic(UpdateVariables& myVar, UpdateParameters& myPara
 		myParam.pParticles.clear();
 		myParam.rParticles.clear();
 		segments.clear();
+		myVar.deleteHalosFlag = true;
 	}
 }
 
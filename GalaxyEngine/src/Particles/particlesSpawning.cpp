@@ -15,7 +15,10 @@ void ParticlesSpawning::particlesInitialConditions(Physics& physics, UpdateVaria
 		};
 
 		if (myVar.isDragging && enablePathPrediction && myVar.gridExists) {
-			predictTrajectory(myParam.pParticles, myParam.myCamera, physics, myVar, slingshot);
+			predictTrajectory(myParam.myCamera, physics, myVar, slingshot);
+		}
+		else if (trajectoryPredictor.hasField()) {
+			trajectoryPredictor.stop();
 		}
 
 		if (IO::mouseReleased(0) && myVar.toolSpawnHeavyParticle && !IO::shortcutDown(KEY_LEFT_CONTROL) && !IO::shortcutDown(KEY_LEFT_ALT) && myVar.isDragging) {
@@ -60,7 +63,7 @@ void ParticlesSpawning::particlesInitialConditions(Physics& physics, UpdateVaria
 
 					particlesIterating = true;
 
-#pragma omp parallel for
+					// One relaxation pass after another, each spreads its cells over the pool
 					for (int i = 0; i < correctionSubsteps; i++) {
 						physics.buildGrid(myParam.pParticles, myParam.rParticles, physics, myVar.domainSize, correctionSubsteps);
 					}
@@ -80,7 +83,6 @@ void ParticlesSpawning::particlesInitialConditions(Physics& physics, UpdateVaria
 				}
 
 				if (particlesIterating) {
-#pragma omp parallel for
 					for (int i = 0; i < correctionSubsteps * 2; i++) {
 						physics.buildGrid(myParam.pParticles, myParam.rParticles, physics, myVar.domainSize, correctionSubsteps);
 					}
@@ -226,7 +228,14 @@ void ParticlesSpawning::particlesInitialConditions(Physics& physics, UpdateVaria
 
 			// DARK MATTER
 
-			if (myVar.isDarkMatterEnabled) {
+			if (myVar.isDarkMatterEnabled && myVar.isAnalyticHaloEnabled) {
+				int darkMatterCount = static_cast<int>(12000 * DMAmountMultiplier);
+				float particleMass = massMultiplierEnabled ? 141600000000.0f / DMAmountMultiplier : 141600000000.0f;
+
+				physics.analyticHalos.spawnForGalaxy(myParam.myCamera.mouseWorldPos, slingshot.norm * slingshot.length * 0.3f,
+					darkMatterCount * particleMass, 3.5f, 2000.0f, myVar);
+			}
+			else if (myVar.isDarkMatterEnabled) {
 				for (int i = 0; i < static_cast<int>(12000 * DMAmountMultiplier); i++) {
 					glm::vec2 galaxyCenter = myParam.myCamera.mouseWorldPos;
 
@@ -384,7 +393,14 @@ void ParticlesSpawning::particlesInitialConditions(Physics& physics, UpdateVaria
 			}
 
 			// DARK MATTER
-			if (myVar.isDarkMatterEnabled) {
+			if (myVar.isDarkMatterEnabled && myVar.isAnalyticHaloEnabled) {
+				int darkMatterCount = static_cast<int>(3600 * DMAmountMultiplier);
+				float particleMass = massMultiplierEnabled ? 141600000000.0f / DMAmountMultiplier : 141600000000.0f;
+
+				physics.analyticHalos.spawnForGalaxy(myParam.myCamera.mouseWorldPos, slingshot.norm * slingshot.length * 0.3f,
+					darkMatterCount * particleMass, 3.5f, 2000.0f, myVar);
+			}
+			else if (myVar.isDarkMatterEnabled) {
 				for (int i = 0; i < static_cast<int>(3600 * DMAmountMultiplier); i++) {
 					glm::vec2 galaxyCenter = myParam.myCamera.mouseWorldPos;
 
@@ -621,49 +637,37 @@ void ParticlesSpawning::particlesInitialConditions(Physics& physics, UpdateVaria
 	}
 }
 
-void ParticlesSpawning::predictTrajectory(const std::vector<ParticlePhysics>& pParticles,
-	SceneCamera& myCamera, Physics physics,
-	UpdateVariables& myVar, Slingshot& slingshot) {
+bool ParticlesSpawning::needsTree(const UpdateVariables& myVar) const {
+	return myVar.isDragging && enablePathPrediction && !trajectoryPredictor.hasField();
+}
+
+void ParticlesSpawning::predictTrajectory(SceneCamera& myCamera, const Physics& physics, UpdateVariables& myVar,
+	Slingshot& slingshot) {
 
 	if (!IsMouseButtonDown(0)) {
+		trajectoryPredictor.stop();
 		return;
 	}
 
-	std::vector<ParticlePhysics> currentParticles = pParticles;
-
-	ParticlePhysics predictedParticle(
-		glm::vec2(myCamera.mouseWorldPos),
-		glm::vec2{ slingshot.norm * slingshot.length },
-		heavyParticleInitMass * heavyParticleWeightMultiplier,
-
-		1.0f,
-		1.0f,
-		1.0f,
-		1.0f
-	);
-
-	currentParticles.push_back(predictedParticle);
-
-	int predictedIndex = static_cast<int>(currentParticles.size()) - 1;
-
-	std::vector<glm::vec2> predictedPath;
-
-	for (int step = 0; step < predictPathLength; ++step) {
-		ParticlePhysics& p = currentParticles[predictedIndex];
-
-		glm::vec2 netForce = physics.calculateForceFromGrid(currentParticles, myVar, p);
+	// The field stays frozen for the whole drag, only the launch changes while aiming
+	if (!trajectoryPredictor.hasField()) {
+		trajectoryPredictor.captureField(myVar, physics);
+	}
 
-		glm::vec2 acc;
-		acc = netForce / p.mass;
+	trajectoryPredictor.aim(myCamera.mouseWorldPos, slingshot.norm * slingshot.length,
+		heavyParticleInitMass * heavyParticleWeightMultiplier, predictPathLength);
 
-		p.vel += myVar.timeFactor * (1.5f * acc);
+	trajectoryPredictor.copyPath(predictedPath);
 
-		p.pos += p.vel * myVar.timeFactor;
+	for (size_t i = 1; i < predictedPath.size(); ++i) {
 
-		predictedPath.push_back(p.pos);
-	}
+		// Skips the jump where the path wraps around looping space
+		glm::vec2 segment = predictedPath[i] - predictedPath[i - 1];
+		if (myVar.isPeriodicBoundaryEnabled
+			&& (std::fabs(segment.x) > myVar.domainSize.x * 0.5f || std::fabs(segment.y) > myVar.domainSize.y * 0.5f)) {
+			continue;
+		}
 
-	for (size_t i = 1; i < predictedPath.size(); ++i) {
 		DrawLineV({ predictedPath[i - 1].x,  predictedPath[i - 1].y }, { predictedPath[i].x,  predictedPath[i].y }, WHITE);
 	}
 }
@@ -3,249 +3,400 @@
 
 extern UpdateVariables myVar;
 
-void SPH::computeViscCohesionForces(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
-	std::vector<glm::vec2>& sphForce, size_t& N) {
+void SPH::computeViscCohesionForces() {
 
 	const float h = radiusMultiplier;
 	const float h2 = h * h;
 
-#if defined(EMSCRIPTEN)
-	for (size_t i = 0; i < N; ++i) {
-#else
-#pragma omp parallel for
-	for (size_t i = 0; i < N; ++i) {
-#endif
+	const size_t N = fluid.size();
 
-		if (!rParticles[i].isSPH || rParticles[i].isPinned || rParticles[i].isBeingDrawn) continue;
+	// Each particle only sums into its own force. A pair counts from both sides, once with the viscosity and cohesion
+	// of either particle, and a pinned particle adds nothing from its own side
+	auto viscCohesionTask = [&](size_t i) {
 
-		auto& pi = pParticles[i];
+		const glm::vec2 posI = fluid.pos[i];
+		const glm::vec2 velI = fluid.vel[i];
+		const bool isPinnedI = fluid.isPinned[i];
+		const float mI = fluid.sphMass[i] * mass;
+		const float cohCoefI = cohesionCoefficient * fluid.cohesion[i];
+		const float viscCoefI = viscosity * fluid.visc[i] * mI / std::max(fluid.dens[i], 0.001f);
 
-		size_t cellIndex = getGridIndex(pi.pos);
-		auto neighborCells = getNeighborCells(cellIndex);
+		glm::vec2 force = { 0.0f, 0.0f };
 
-		for (auto neighCellIdx : neighborCells) {
-			if (neighCellIdx == kInvalidCell) continue;
-			auto it = grid.find(neighCellIdx);
-			if (it == grid.end()) continue;
-			auto& cell = it->second;
+		const uint32_t end = neighborList.start[i + 1];
+		for (uint32_t n = neighborList.start[i]; n < end; n++) {
+			const uint32_t j = neighborList.neighbors[n];
 
-			for (auto pjIdx : cell.particleIndices) {
+			glm::vec2 d = { fluid.pos[j].x - posI.x, fluid.pos[j].y - posI.y };
+			float   rSq = d.x * d.x + d.y * d.y;
+			if (rSq >= h2) continue;
 
-				if (!rParticles[pjIdx].isSPH || rParticles[pjIdx].isBeingDrawn) continue;
+			float r = sqrtf(std::max(rSq, 1e-6f));
+			glm::vec2 nr = { d.x / r, d.y / r };
 
-				if (pjIdx == i) continue;
-				auto& pj = pParticles[pjIdx];
+			float mJ = fluid.sphMass[j] * mass;
 
-				glm::vec2 d = { pj.pos.x - pi.pos.x, pj.pos.y - pi.pos.y };
-				float   rSq = d.x * d.x + d.y * d.y;
-				if (rSq >= h2) continue;
+			float lapW = smoothingKernelLaplacian(r, h);
+			float cohFactor = smoothingKernelCohesion(r, h);
 
-				float r = sqrtf(std::max(rSq, 1e-6f));
-				glm::vec2 nr = { d.x / r, d.y / r };
+			float viscScale = 0.0f;
+			float cohScale = 0.0f;
 
-				float mJ = pj.sphMass * mass;
+			if (!isPinnedI) {
+				viscScale += viscosity * fluid.visc[j] * mJ / std::max(fluid.dens[j], 0.001f);
+				cohScale += cohCoefI * mJ;
+			}
+
+			if (!fluid.isPinned[j]) {
+				viscScale += viscCoefI;
+				cohScale += cohesionCoefficient * fluid.cohesion[j] * mI;
+			}
+
+			viscScale *= lapW;
+			cohScale *= cohFactor;
+
+			force.x += viscScale * (fluid.vel[j].x - velI.x) + cohScale * nr.x;
+			force.y += viscScale * (fluid.vel[j].y - velI.y) + cohScale * nr.y;
+		}
+
+		fluid.force[i] += force;
+		};
+
+	parallel_for(0, N, clamp_thread_count(N, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1),
+		[&](size_t i, int) { viscCohesionTask(i); });
+}
+
+float SPH::prototypeStiffness(float spacing) {
+
+	const float h = radiusMultiplier;
+	const int reach = static_cast<int>(h / spacing);
+
+	glm::vec2 sumDensGrad = { 0.0f, 0.0f };
+	glm::vec2 sumPressGrad = { 0.0f, 0.0f };
+	float sumGradDot = 0.0f;
+
+	for (int y = -reach; y <= reach; y++) {
+		for (int x = -reach; x <= reach; x++) {
+			if (x == 0 && y == 0) continue;
 
-				float lapW = smoothingKernelLaplacian(r, h);
-				glm::vec2 viscF = {
-					viscosity * pj.visc * mJ / std::max(pj.dens, 0.001f) * lapW * (pj.vel.x - pi.vel.x),
-					viscosity * pj.visc * mJ / std::max(pj.dens, 0.001f) * lapW * (pj.vel.y - pi.vel.y)
-				};
+			glm::vec2 offset = { x * spacing, y * spacing };
+			float r = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+			if (r >= h) continue;
 
-				float cohCoef = cohesionCoefficient * pi.cohesion;
-				float cohFactor = smoothingKernelCohesion(r, h);
-				glm::vec2 cohF = { cohCoef * mJ * cohFactor * nr.x,
-									cohCoef * mJ * cohFactor * nr.y };
+			// From the neighbor to the prototype
+			glm::vec2 nrm = -offset / r;
 
-#pragma omp atomic
-				sphForce[i].x += viscF.x + cohF.x;
-#pragma omp atomic
-				sphForce[i].y += viscF.y + cohF.y;
-#pragma omp atomic
-				sphForce[pjIdx].x -= viscF.x + cohF.x;
-#pragma omp atomic
-				sphForce[pjIdx].y -= viscF.y + cohF.y;
+			float densGrad = smoothingKernelDerivative(r, h);
+			float pressGrad = spikyKernelDerivative(r, h);
+
+			sumDensGrad += densGrad * nrm;
+			sumPressGrad += pressGrad * nrm;
+			sumGradDot += densGrad * pressGrad;
+		}
+	}
+
+	return sumDensGrad.x * sumPressGrad.x + sumDensGrad.y * sumPressGrad.y + sumGradDot;
+}
+
+float SPH::computeDelta(float dt, float accelScale) {
+
+	// Fine enough that the lattice sums are close to their integrals
+	const float spacing = radiusMultiplier * 0.25f;
+
+	// A unit of pressure pushes a pair apart with 4 * m / restDens times the pressure kernel gradient, m being
+	// mass * sphMass and both sides of the pair counting, which the predictor turns into a move of
+	// dt * dt * accelScale / sphMass times that. The density changes by m / restDens times the density kernel gradient along the move. At rest the
+	// spacing squared is m / restDens^2, and the lattice sums go with one over it, which leaves only the global mass
+	float sensitivity = 4.0f * accelScale * dt * dt * mass * spacing * spacing * prototypeStiffness(spacing);
+
+	return sensitivity > 0.0f ? 1.0f / sensitivity : solverDelta;
+}
+
+void SPH::buildWallTables() {
+
+	const float h = radiusMultiplier;
+
+	// Midpoint rule over the strip past the wall, with the rows starting right at the wall so the tables and their
+	// slopes are smooth in the distance
+	const int cellsPerSide = 96;
+	const float stepAcross = 2.0f * h / cellsPerSide;
+
+	wallDensity.assign(wallSamples + 1, 0.0f);
+	wallPush.assign(wallSamples + 1, 0.0f);
+
+	for (int k = 0; k < wallSamples; k++) {
+		const float dst = h * static_cast<float>(k) / wallSamples;
+		const float stepDepth = (h - dst) / (cellsPerSide / 2);
+
+		float density = 0.0f;
+		float push = 0.0f;
+
+		for (int y = 0; y < cellsPerSide / 2; y++) {
+			const float depth = dst + (y + 0.5f) * stepDepth;
+
+			for (int x = 0; x < cellsPerSide; x++) {
+				const float across = -h + (x + 0.5f) * stepAcross;
+				const float r = std::sqrt(across * across + depth * depth);
+				if (r >= h) continue;
+
+				density += smoothingKernel(r, h);
+
+				// Inward part of the pressure pair force from this bit of wall
+				push -= spikyKernelDerivative(r, h) * depth / r;
 			}
 		}
+
+		wallDensity[k] = density * stepAcross * stepDepth;
+		wallPush[k] = push * stepAcross * stepDepth;
 	}
+
+	wallRadius = h;
+}
+
+std::array<float, 4> SPH::wallDistances(glm::vec2 pos, size_t i, glm::vec2 domainSize) const {
+
+	// Half a rest spacing behind the line the walls clamp positions to
+	const float spacing = std::sqrt(fluid.sphMass[i] * mass) / fluid.restDens[i];
+	const float wall = radiusMultiplier - 0.5f * spacing;
+
+	return { pos.x - wall, domainSize.x - wall - pos.x, pos.y - wall, domainSize.y - wall - pos.y };
 }
 
-void SPH::PCISPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt) {
+void SPH::updateNeighbors(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles) {
 
-	size_t N = pParticles.size();
+	// The tree build reorders pParticles every frame, but while the fluid is the same particles they are copied back
+	// into the same slots and the last step's neighbor lists can be kept if nothing moved past the skin. Otherwise the
+	// fluid is copied out in the order of its cells, cells is built over it on the way, and the lists are rebuilt
+	const bool isReused = neighborSkin > 0.0f && fluid.regather(pParticles, rParticles) &&
+		neighborList.holds(fluid.pos, radiusMultiplier, neighborSkin);
 
-	if (sphForce.size() != N) {
-		sphForce.assign(N, { 0.0f, 0.0f });
+	if (!isReused) {
+		fluid.gather(pParticles, rParticles, cells, radiusMultiplier + neighborSkin);
+		neighborList.build(fluid.pos, cells, radiusMultiplier, neighborSkin);
 	}
-	else {
-		std::fill(sphForce.begin(), sphForce.end(), glm::vec2{ 0.0f, 0.0f });
+}
+
+glm::vec2 SPH::pressureForce(size_t i, const std::vector<glm::vec2>& positions, const std::vector<float>& densities,
+	glm::vec2 domainSize, bool sphGround) {
+
+	const glm::vec2 posI = positions[i];
+	const float pressI = fluid.press[i];
+	const float densI = densities[i];
+	const float sphMassI = fluid.sphMass[i];
+
+	glm::vec2 force = { 0.0f, 0.0f };
+
+	const uint32_t end = neighborList.start[i + 1];
+	for (uint32_t n = neighborList.start[i]; n < end; n++) {
+		const uint32_t j = neighborList.neighbors[n];
+
+		glm::vec2 dr = { posI.x - positions[j].x,
+					   posI.y - positions[j].y };
+		float   rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
+		if (rr < 1e-5f || rr >= radiusMultiplier) continue;
+
+		float gradW = spikyKernelDerivative(rr, radiusMultiplier);
+		glm::vec2 nrm = { dr.x / rr, dr.y / rr };
+		float   avgP = 0.5f * (pressI + fluid.press[j]);
+		float   avgD = 0.5f * (densI + densities[j]);
+
+		float   mag = -(sphMassI * mass + fluid.sphMass[j] * mass) * avgP / std::max(avgD, 0.01f);
+
+		// Mass ratio mag limiter
+		float massRatio = std::max(sphMassI, fluid.sphMass[j]) / std::min(sphMassI, fluid.sphMass[j]);
+		float scale = std::min(1.0f, 8.0f / massRatio);
+
+		mag *= 2.0f * scale;
+
+		force.x += mag * gradW * nrm.x;
+		force.y += mag * gradW * nrm.y;
 	}
 
-	for (size_t i = 0; i < N; ++i) {
-		pParticles[i].press = 0.0f;
-		pParticles[i].pressF = { 0.0f, 0.0f };
+	if (sphGround) {
+		const std::array<float, 4> walls = wallDistances(posI, i, domainSize);
+		const float restDensI = fluid.restDens[i];
+		const float wallScale = 4.0f * pressI * restDensI * restDensI / std::max(densI, 0.01f);
+
+		// Left, right, top and bottom, each pushing back into the domain
+		const glm::vec2 inward[4] = { { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f } };
+		for (int w = 0; w < 4; w++) {
+			if (walls[w] < radiusMultiplier) {
+				force += wallScale * wallLookup(wallPush, walls[w]) * inward[w];
+			}
+		}
+	}
+
+	return force;
+}
+
+void SPH::PCISPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt,
+	float accelScale, glm::vec2 domainSize, bool sphGround) {
+
+	updateNeighbors(pParticles, rParticles);
+
+	const size_t N = fluid.size();
+
+	computeViscCohesionForces();
+
+	if (dt > 0.0f) {
+		solverDelta = computeDelta(dt, accelScale);
 	}
 
-	computeViscCohesionForces(pParticles, rParticles, sphForce, N);
+	// The prototype's sums at every slot's rest spacing. Slots of one material share it, and a scene has few materials
+	prototypeCache.clear();
+	for (size_t i = 0; i < N; i++) {
+		const float spacing = std::sqrt(fluid.sphMass[i] * mass) / fluid.restDens[i];
+
+		auto it = std::find_if(prototypeCache.begin(), prototypeCache.end(),
+			[&](const std::pair<float, float>& entry) { return entry.first == spacing; });
+
+		if (it == prototypeCache.end()) {
+			prototypeCache.push_back({ spacing, prototypeStiffness(spacing) });
+			it = prototypeCache.end() - 1;
+		}
+
+		fluid.protoStiff[i] = it->second;
+	}
+
+	if (sphGround && wallRadius != radiusMultiplier) {
+		buildWallTables();
+	}
 
 	float rhoError = 0.0f;
 	iter = 0;
 
+	const int thread_count = clamp_thread_count(N, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+
 	do {
 
 		float maxRhoErr = 0.0f;
-		//std::fill(sphForce.begin(), sphForce.end(), glm::vec2{ 0.0f, 0.0f });
-		//computeViscCohesionForces(pParticles, rParticles, sphForce, N);
-		//sphForce = baseSphForce;
-
-#if defined(EMSCRIPTEN)
-		const int thread_count = clamp_thread_count(N, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
-		parallel_for(0, N, thread_count, [&](size_t i, int) {
-#else
-#pragma omp parallel for
-		for (size_t i = 0; i < N; ++i) {
-#endif
-
-			if (rParticles[i].isSPH && !rParticles[i].isBeingDrawn) {
-				auto& p = pParticles[i];
-				p.predVel = p.vel + dt * 1.5f * (sphForce[i] / p.sphMass);
-				p.predPos = { p.pos.x + p.predVel.x * dt, p.pos.y + p.predVel.y * dt };
+
+		// Everything but SPH is in the prediction too, otherwise the pressure never learns about the weight of the fluid
+		auto predictTask = [&](size_t i) {
+			glm::vec2 acc = fluid.acc[i] + (fluid.force[i] + fluid.pressForce[i]) / fluid.sphMass[i];
+
+			if (sphGround) {
+				acc.y += verticalGravity;
 			}
-#if defined(EMSCRIPTEN)
-		});
-#endif
 
-		grid.clear();
-		grid.reserve(N);
-		for (size_t i = 0; i < N; ++i) {
-			size_t idx = getGridIndex(pParticles[i].predPos);
-			grid[idx].particleIndices.push_back(i);
+			fluid.predVel[i] = fluid.vel[i] + dt * accelScale * acc;
+			fluid.predPos[i] = { fluid.pos[i].x + fluid.predVel[i].x * dt, fluid.pos[i].y + fluid.predVel[i].y * dt };
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { predictTask(i); });
+
+		// Predicted positions move little within a step, so the fluid's slots are still close to their cell order
+		if (!neighborList.holds(fluid.predPos, radiusMultiplier, neighborSkin)) {
+			predCells.build(fluid.predPos, radiusMultiplier + neighborSkin);
+			neighborList.build(fluid.predPos, predCells, radiusMultiplier, neighborSkin);
 		}
 
-#if defined(EMSCRIPTEN)
-		std::vector<float> thread_max(static_cast<size_t>(thread_count), 0.0f);
-		parallel_for(0, N, thread_count, [&](size_t i, int tid) {
-#else
-#pragma omp parallel for reduction(max:maxRhoErr)
-		for (size_t i = 0; i < N; ++i) {
-#endif
-
-			if (rParticles[i].isSPH && !rParticles[i].isBeingDrawn) {
-				auto& pi = pParticles[i];
-				pi.predDens = 0.0f;
-
-				size_t cellIndex = getGridIndex(pi.predPos);
-				auto neighborCells = getNeighborCells(cellIndex);
-
-				for (auto neighIdx : neighborCells) {
-					if (neighIdx == kInvalidCell) continue;
-					auto it = grid.find(neighIdx);
-					if (it == grid.end()) continue;
-					for (auto pjIdx : it->second.particleIndices) {
-
-						if (!rParticles[pjIdx].isSPH || rParticles[pjIdx].isBeingDrawn) continue;
-
-						auto& pj = pParticles[pjIdx];
-						glm::vec2 dr = { pi.predPos.x - pj.predPos.x,
-									   pi.predPos.y - pj.predPos.y };
-						float   rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
-						if (rr >= radiusMultiplier) continue;
-						float mJ = pj.sphMass * mass;
-						float rho0 = 0.5f * (pi.restDens + pj.restDens);
-
-						pi.predDens += mJ * smoothingKernel(rr, radiusMultiplier) / rho0;
+		auto densityTask = [&](size_t i) {
+			const glm::vec2 predPosI = fluid.predPos[i];
+			const float restDensI = fluid.restDens[i];
+
+			// Lists exclude the particle itself, its own share is added here
+			const float selfDens = fluid.sphMass[i] * mass * smoothingKernel(0.0f, radiusMultiplier) / restDensI;
+			float predDens = selfDens;
+
+			// The prototype's sums over the actual neighbors, with each neighbor weighted by its mass over the slot's
+			float sumDensGradX = 0.0f;
+			float sumDensGradY = 0.0f;
+			float sumPressGradX = 0.0f;
+			float sumPressGradY = 0.0f;
+			float sumGradDot = 0.0f;
+
+			const uint32_t end = neighborList.start[i + 1];
+#pragma omp simd reduction(+:predDens, sumDensGradX, sumDensGradY, sumPressGradX, sumPressGradY, sumGradDot)
+			for (uint32_t n = neighborList.start[i]; n < end; n++) {
+				const uint32_t j = neighborList.neighbors[n];
+
+				glm::vec2 dr = { predPosI.x - fluid.predPos[j].x,
+							   predPosI.y - fluid.predPos[j].y };
+				float   rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
+				float mJ = fluid.sphMass[j] * mass;
+				float rho0 = 0.5f * (restDensI + fluid.restDens[j]);
+
+				// Pairs in the skin land on the kernel's zero
+				predDens += mJ * smoothingKernel(rr, radiusMultiplier) / rho0;
+
+				float weight = fluid.sphMass[j] / fluid.sphMass[i];
+				float invR = rr > 1e-5f ? weight / rr : 0.0f;
+				float densGrad = smoothingKernelDerivative(rr, radiusMultiplier);
+				float pressGrad = spikyKernelDerivative(rr, radiusMultiplier);
+
+				sumDensGradX += densGrad * dr.x * invR;
+				sumDensGradY += densGrad * dr.y * invR;
+				sumPressGradX += pressGrad * dr.x * invR;
+				sumPressGradY += pressGrad * dr.y * invR;
+				sumGradDot += weight * weight * densGrad * pressGrad;
+			}
+
+			if (sphGround) {
+				const std::array<float, 4> walls = wallDistances(predPosI, i, domainSize);
+				for (int w = 0; w < 4; w++) {
+					if (walls[w] < radiusMultiplier) {
+						predDens += restDensI * wallLookup(wallDensity, walls[w]);
 					}
 				}
+			}
 
-				float err = pi.predDens - pi.restDens;
-				pi.pressTmp = delta * err;
+			fluid.predDens[i] = predDens;
 
-				if (pi.pressTmp < 0.0f)
-					pi.pressTmp = 0.0f;
+			float err = predDens - restDensI;
 
-#if defined(EMSCRIPTEN)
-				thread_max[static_cast<size_t>(tid)] = std::max(thread_max[static_cast<size_t>(tid)], std::abs(err));
-#else
-				maxRhoErr = std::max(maxRhoErr, std::abs(err));
-#endif
+			if (selfDens >= restDensI) {
+				// Out of reach, the pressure follows the predicted density and doesn't hold up the iterations
+				fluid.pressTmp[i] = std::max(delta * err, 0.0f);
+				fluid.press[i] = fluid.pressTmp[i] * fluid.stiff[i] * stiffMultiplier;
 
-				pi.press += pi.pressTmp * pi.stiff * stiffMultiplier;
+				return 0.0f;
 			}
-#if defined(EMSCRIPTEN)
-		});
+
+			// The prototype's neighbors sit at rest. Closer ones, in a collapsing pair or packed into a corner, move the
+			// density many times more per unit of pressure, and the prototype's delta would overshoot there by as much
+			float stiffness = sumDensGradX * sumPressGradX + sumDensGradY * sumPressGradY + sumGradDot;
+			float slotDelta = stiffness > fluid.protoStiff[i] ? solverDelta * fluid.protoStiff[i] / stiffness : solverDelta;
+
+			// The correction can be negative so a later iteration can take back an overshoot, only the pressure itself
+			// stays positive
+			fluid.pressTmp[i] = slotDelta * err * fluid.stiff[i] * stiffMultiplier;
+			fluid.press[i] = std::max(fluid.press[i] + fluid.pressTmp[i], 0.0f);
+
+			// Relative, and only compression counts. Pressure never goes negative, so it can't fix an underdense surface
+			return std::max(err, 0.0f) / restDensI;
+			};
+
+		std::vector<float> thread_max(static_cast<size_t>(thread_count), 0.0f);
+		parallel_for(0, N, thread_count, [&](size_t i, int tid) {
+			thread_max[static_cast<size_t>(tid)] = std::max(thread_max[static_cast<size_t>(tid)], densityTask(i));
+			});
 		for (float value : thread_max) {
 			maxRhoErr = std::max(maxRhoErr, value);
 		}
-#endif
-
-#if defined(EMSCRIPTEN)
-		for (size_t i = 0; i < N; ++i) {
-#else
-#pragma omp parallel for
-		for (size_t i = 0; i < N; ++i) {
-#endif
-
-			if (!rParticles[i].isSPH || rParticles[i].isBeingDrawn) continue;
-
-			auto& pi = pParticles[i];
-			size_t cellIndex = getGridIndex(pi.predPos);
-			auto neighborCells = getNeighborCells(cellIndex);
-
-			for (auto neighIdx : neighborCells) {
-				if (neighIdx == kInvalidCell) continue;
-				auto it = grid.find(neighIdx);
-				if (it == grid.end()) continue;
-				for (auto pjIdx : it->second.particleIndices) {
-					if (pjIdx == i) continue;
-
-					if (!rParticles[pjIdx].isSPH || rParticles[pjIdx].isBeingDrawn) continue;
-					auto& pj = pParticles[pjIdx];
-					glm::vec2 dr = { pi.predPos.x - pj.predPos.x,
-								   pi.predPos.y - pj.predPos.y };
-					float   rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
-					if (rr < 1e-5f || rr >= radiusMultiplier) continue;
-
-					float gradW = spikyKernelDerivative(rr, radiusMultiplier);
-					glm::vec2 nrm = { dr.x / rr, dr.y / rr };
-					float   avgP = 0.5f * (pi.press + pj.press);
-					float   avgD = 0.5f * (pi.predDens + pj.predDens);
-
-					float   mag = -(pi.sphMass * mass + pj.sphMass * mass) * avgP / std::max(avgD, 0.01f);
-
-					// Mass ratio mag limiter
-					float massRatio = std::max(pi.sphMass, pj.sphMass) / std::min(pi.sphMass, pj.sphMass);
-					float scale = std::min(1.0f, 8.0f / massRatio);
-
-					mag *= scale;
-
-					glm::vec2 pF = { mag * gradW * nrm.x,
-								   mag * gradW * nrm.y };
-
-#pragma omp atomic
-					sphForce[i].x += pF.x;
-#pragma omp atomic
-					sphForce[i].y += pF.y;
-#pragma omp atomic
-					sphForce[pjIdx].x -= pF.x;
-#pragma omp atomic
-					sphForce[pjIdx].y -= pF.y;
-				}
-			}
-		}
+
+		// Gather only like the viscosity. The pair force is symmetric, so both sides of a pair add the same to it. The
+		// pressure force is recomputed from the whole pressure every iteration and replaces the last one
+		auto pressureTask = [&](size_t i) {
+			fluid.pressForce[i] = pressureForce(i, fluid.predPos, fluid.predDens, domainSize, sphGround);
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { pressureTask(i); });
 
 		rhoError = maxRhoErr;
 		++iter;
 
-	} while (iter < maxIter/* && rhoError > densTolerance*/); // I'm keeping that condition commented because I might need it int the future
+	} while (iter < maxIter && rhoError > densTolerance);
 
-#if defined(EMSCRIPTEN)
-	parallel_for(0, N, clamp_thread_count(N, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1), [&](size_t i, int) {
-#else
-#pragma omp parallel for
-	for (size_t i = 0; i < N; ++i) {
-#endif
-		auto& p = pParticles[i];
+	applyPressureForces(pParticles, rParticles);
+}
+
+void SPH::applyPressureForces(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles) {
 
-		p.pressF = sphForce[i] / p.sphMass;
+	fluid.scatter(pParticles);
+
+	auto applyTask = [&](size_t i) {
+		auto& p = pParticles[i];
 
 		if (!rParticles[i].isPinned) {
 			p.acc += p.pressF;
@@ -253,21 +404,313 @@ void SPH::PCISPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleR
 		else {
 			p.acc *= 0.0f;
 		}
-#if defined(EMSCRIPTEN)
-	});
-#endif
+		};
+
+	parallel_for(0, pParticles.size(), clamp_thread_count(pParticles.size(), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1),
+		[&](size_t i, int) { applyTask(i); });
+}
+
+
+void SPH::DFSPH(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, float& dt,
+	float accelScale, glm::vec2 domainSize, bool sphGround) {
+
+	updateNeighbors(pParticles, rParticles);
+
+	const size_t N = fluid.size();
+	const float h = radiusMultiplier;
+
+	computeViscCohesionForces();
+
+	if (sphGround && wallRadius != radiusMultiplier) {
+		buildWallTables();
+	}
+
+	// Left, right, top and bottom
+	const glm::vec2 inward[4] = { { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f } };
+
+	// Gradient of the density the walls add at a slot's position, it points into the walls
+	auto wallGradient = [&](size_t i) {
+		glm::vec2 grad = { 0.0f, 0.0f };
+
+		if (sphGround) {
+			const std::array<float, 4> walls = wallDistances(fluid.pos[i], i, domainSize);
+			for (int w = 0; w < 4; w++) {
+				if (walls[w] < h) {
+					grad += fluid.restDens[i] * wallSlope(wallDensity, walls[w]) * inward[w];
+				}
+			}
+		}
+
+		return grad;
+		};
+
+	const int thread_count = clamp_thread_count(N, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+
+	// Density of the current positions, kept in predDens since dens is what the viscosity was tuned with, and the
+	// stiffness factor: the density over how strongly a unit of pressure changes it. Slots that can't reach their rest
+	// density get no factor and the equation of state pressure instead
+	auto factorTask = [&](size_t i) {
+		const glm::vec2 posI = fluid.pos[i];
+		const float restDensI = fluid.restDens[i];
+		const float mI = fluid.sphMass[i] * mass;
+		const float selfDens = mI * smoothingKernel(0.0f, h) / restDensI;
+
+		float dens = selfDens;
+		glm::vec2 grad = wallGradient(i);
+		float gradSq = 0.0f;
+
+		const uint32_t end = neighborList.start[i + 1];
+		for (uint32_t n = neighborList.start[i]; n < end; n++) {
+			const uint32_t j = neighborList.neighbors[n];
+
+			glm::vec2 dr = { posI.x - fluid.pos[j].x, posI.y - fluid.pos[j].y };
+			float rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
+			if (rr >= h) continue;
+
+			float mJ = fluid.sphMass[j] * mass;
+			float rho0 = 0.5f * (restDensI + fluid.restDens[j]);
+
+			dens += mJ * smoothingKernel(rr, h) / rho0;
+
+			if (rr < 1e-5f) continue;
+
+			glm::vec2 gradW = smoothingKernelDerivative(rr, h) / rr * dr;
+
+			grad += mJ / rho0 * gradW;
+			gradSq += mJ * mI / (rho0 * rho0) * (gradW.x * gradW.x + gradW.y * gradW.y);
+		}
+
+		if (sphGround) {
+			const std::array<float, 4> walls = wallDistances(posI, i, domainSize);
+			for (int w = 0; w < 4; w++) {
+				if (walls[w] < h) {
+					dens += restDensI * wallLookup(wallDensity, walls[w]);
+				}
+			}
+		}
+
+		fluid.predDens[i] = dens;
+
+		const bool isSolved = selfDens < restDensI;
+		const float sensitivity = grad.x * grad.x + grad.y * grad.y + gradSq;
+
+		fluid.densFactor[i] = isSolved && !fluid.isPinned[i] && sensitivity > 1e-12f ? dens / sensitivity : 0.0f;
+
+		if (fluid.densFactor[i] == 0.0f) {
+			fluid.densKappa[i] = 0.0f;
+			fluid.divKappa[i] = 0.0f;
+		}
+
+		fluid.press[i] = isSolved ? 0.0f : std::max(delta * (dens - restDensI), 0.0f) * fluid.stiff[i] * stiffMultiplier;
+
+		return isSolved ? 0 : 1;
+		};
+
+	int64_t stateCount = 0;
+	int64_t solvedCount = 0;
+
+	std::vector<int64_t> thread_state(static_cast<size_t>(thread_count), 0);
+	parallel_for(0, N, thread_count, [&](size_t i, int tid) {
+		thread_state[static_cast<size_t>(tid)] += factorTask(i);
+		});
+	for (int64_t value : thread_state) {
+		stateCount += value;
+	}
+
+	for (size_t i = 0; i < N; i++) {
+		solvedCount += fluid.densFactor[i] > 0.0f;
+	}
+
+	// The equation of state pressure is a force like the viscosity, pairs with it on neither side add nothing
+	if (stateCount > 0) {
+		auto stateTask = [&](size_t i) {
+			fluid.force[i] += pressureForce(i, fluid.pos, fluid.predDens, domainSize, sphGround);
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { stateTask(i); });
+	}
+
+	// Rate the density of slot i changes at with the velocities in predVel
+	auto densityRate = [&](size_t i) {
+		const glm::vec2 posI = fluid.pos[i];
+		const glm::vec2 velI = fluid.predVel[i];
+		const float restDensI = fluid.restDens[i];
+
+		glm::vec2 wallGrad = wallGradient(i);
+		float rate = wallGrad.x * velI.x + wallGrad.y * velI.y;
+
+		const uint32_t end = neighborList.start[i + 1];
+		for (uint32_t n = neighborList.start[i]; n < end; n++) {
+			const uint32_t j = neighborList.neighbors[n];
+
+			glm::vec2 dr = { posI.x - fluid.pos[j].x, posI.y - fluid.pos[j].y };
+			float rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
+			if (rr < 1e-5f || rr >= h) continue;
+
+			float mJ = fluid.sphMass[j] * mass;
+			float rho0 = 0.5f * (restDensI + fluid.restDens[j]);
+			float gradW = smoothingKernelDerivative(rr, h) / rr;
+
+			glm::vec2 dv = velI - fluid.predVel[j];
+			rate += mJ / rho0 * gradW * (dv.x * dr.x + dv.y * dr.y);
+		}
+
+		return rate;
+		};
+
+	// Gather only like the viscosity. Moves predVel by the pressures in pressTmp, and keeps the sum of the moves in
+	// pressForce. A pair pushes with the pressure of both sides, a wall with the slot's own
+	auto correctTask = [&](size_t i) {
+		if (fluid.isPinned[i]) {
+			return;
+		}
+
+		const glm::vec2 posI = fluid.pos[i];
+		const float restDensI = fluid.restDens[i];
+		const float kappaI = fluid.pressTmp[i] / fluid.predDens[i];
+
+		glm::vec2 push = kappaI * wallGradient(i);
+
+		const uint32_t end = neighborList.start[i + 1];
+		for (uint32_t n = neighborList.start[i]; n < end; n++) {
+			const uint32_t j = neighborList.neighbors[n];
+
+			glm::vec2 dr = { posI.x - fluid.pos[j].x, posI.y - fluid.pos[j].y };
+			float rr = sqrtf(dr.x * dr.x + dr.y * dr.y);
+			if (rr < 1e-5f || rr >= h) continue;
+
+			float mJ = fluid.sphMass[j] * mass;
+			float rho0 = 0.5f * (restDensI + fluid.restDens[j]);
+			float gradW = smoothingKernelDerivative(rr, h) / rr;
+
+			push += mJ / rho0 * (kappaI + fluid.pressTmp[j] / fluid.predDens[j]) * gradW * dr;
+		}
+
+		fluid.predVel[i] -= dt * push;
+		fluid.pressForce[i] -= dt * push;
+		};
+
+	auto correct = [&]() {
+		parallel_for(0, N, thread_count, [&](size_t i, int) { correctTask(i); });
+		};
+
+	// How far past its rest density the velocities in predVel would compress slot i within the step, from the current
+	// density for the density solve and from no change at all for the divergence one
+	auto densityError = [&](size_t i, bool isDensity) {
+		float err = dt * densityRate(i);
+		if (isDensity) {
+			err += fluid.predDens[i] - fluid.restDens[i];
+		}
+
+		return err;
+		};
+
+	// Jacobi iterations on kappa, the pressure over density. Each iteration adds a part of the pressure that would take
+	// a slot's error back and pushes predVel by it. Only compression counts, and like in PCISPH a pressure can be taken
+	// back but never goes negative. Slots that are still compressed start from the last step's pressure, which keeps
+	// deep water standing on what held it up before. The others start from zero, carrying a pressure over into a
+	// slot that is pulling apart throws it outward
+	auto solve = [&](std::vector<float>& kappa, bool isDensity) {
+
+		auto warmTask = [&](size_t i) {
+			if (fluid.densFactor[i] > 0.0f && densityError(i, isDensity) <= 0.0f) {
+				kappa[i] = 0.0f;
+			}
+
+			fluid.pressTmp[i] = kappa[i];
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { warmTask(i); });
+
+		correct();
+
+		auto errorTask = [&](size_t i) {
+			const float factor = fluid.densFactor[i];
+
+			if (factor == 0.0f) {
+				fluid.pressTmp[i] = 0.0f;
+				return 0.0f;
+			}
+
+			const float err = densityError(i, isDensity);
+
+			float total = std::max(kappa[i] + dfsphRelaxation * err * factor / (dt * dt), 0.0f);
+			fluid.pressTmp[i] = total - kappa[i];
+			kappa[i] = total;
+
+			return std::max(err, 0.0f) / fluid.restDens[i];
+			};
+
+		int solveIter = 0;
+		float avgErr = 0.0f;
+
+		do {
+			float sumErr = 0.0f;
+
+			std::vector<float> thread_sum(static_cast<size_t>(thread_count), 0.0f);
+			parallel_for(0, N, thread_count, [&](size_t i, int tid) {
+				thread_sum[static_cast<size_t>(tid)] += errorTask(i);
+				});
+			for (float value : thread_sum) {
+				sumErr += value;
+			}
+
+			correct();
+
+			avgErr = sumErr / static_cast<float>(std::max<int64_t>(solvedCount, 1));
+			++solveIter;
+
+		} while (solveIter < maxIter && avgErr > densTolerance);
+
+		return solveIter;
+		};
+
+	const glm::vec2 gravity = { 0.0f, sphGround ? verticalGravity : 0.0f };
+
+	if (dt > 0.0f && solvedCount > 0) {
+
+		auto startTask = [&](size_t i) {
+			fluid.predVel[i] = fluid.vel[i];
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { startTask(i); });
+
+		// The divergence solve stands in for the one at the end of the last step, the velocities are the same
+		solve(fluid.divKappa, false);
+
+		// Everything but the pressure, what the integrator will add on top of it
+		auto advectTask = [&](size_t i) {
+			if (!fluid.isPinned[i]) {
+				fluid.predVel[i] += dt * accelScale * (fluid.acc[i] + gravity + fluid.force[i] / fluid.sphMass[i]);
+			}
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { advectTask(i); });
+
+		iter = solve(fluid.densKappa, true);
+
+		// The velocity change of both solves as the force the integrator turns back into it. Pressures are kappa
+		// times density
+		auto forceTask = [&](size_t i) {
+			fluid.pressForce[i] *= fluid.sphMass[i] / (dt * accelScale);
+
+			if (fluid.densFactor[i] > 0.0f) {
+				fluid.press[i] = fluid.densKappa[i] * fluid.predDens[i];
+			}
+			};
+
+		parallel_for(0, N, thread_count, [&](size_t i, int) { forceTask(i); });
+	}
+	else {
+		iter = 0;
+	}
+
+	applyPressureForces(pParticles, rParticles);
 }
 
 void SPH::groundModeBoundary(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, glm::vec2 domainSize) {
 
-#if defined(EMSCRIPTEN)
-	const size_t count = pParticles.size();
-	const int thread_count = clamp_thread_count(count, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
-	parallel_for(0, count, thread_count, [&](size_t i, int) {
-#else
-#pragma omp parallel for
-	for (size_t i = 0; i < pParticles.size(); ++i) {
-#endif
+	auto boundaryTask = [&](size_t i) {
 		if (!rParticles[i].isPinned) {
 			auto& p = pParticles[i];
 			p.acc.y += verticalGravity;
@@ -293,7 +736,9 @@ void SPH::groundModeBoundary(std::vector<ParticlePhysics>& pParticles, std::vect
 				p.pos.y = domainSize.y - radiusMultiplier;
 			}
 		}
-#if defined(EMSCRIPTEN)
-	});
-#endif
+		};
+
+	const size_t count = pParticles.size();
+	const int thread_count = clamp_thread_count(count, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+	parallel_for(0, count, thread_count, [&](size_t i, int) { boundaryTask(i); });
 }
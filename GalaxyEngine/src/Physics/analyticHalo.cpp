@@ -0,0 +1,360 @@
+#include "Physics/analyticHalo.h"
+#include "Physics/physics.h"
+#include "UX/parallel_for.h"
+
+float AnalyticHalo::shapeOf(Profile profileType, float x) {
+
+	switch (profileType) {
+	case Profile::NFW:
+		return shape<Profile::NFW>(x);
+	case Profile::Plummer:
+		return shape<Profile::Plummer>(x);
+	default:
+		return shape<Profile::Isothermal>(x);
+	}
+}
+
+float AnalyticHalo::enclosedFraction(float r) const {
+
+	float total = shapeOf(profile, cutoffRadius / scaleRadius);
+	if (total <= 0.0f) {
+		return 0.0f;
+	}
+
+	return shapeOf(profile, std::min(r, cutoffRadius) / scaleRadius) / total;
+}
+
+void AnalyticHalo::fitScaleRadius(float halfMassRadius) {
+
+	halfMassRadius = std::clamp(halfMassRadius, 1e-3f * cutoffRadius, cutoffRadius);
+
+	// The enclosed fraction at the half mass radius falls as the scale radius grows, bisect it in log space
+	float low = std::log(1e-4f * cutoffRadius);
+	float high = std::log(10.0f * cutoffRadius);
+
+	for (int iteration = 0; iteration < 60; iteration++) {
+		float middle = 0.5f * (low + high);
+		scaleRadius = std::exp(middle);
+
+		if (enclosedFraction(halfMassRadius) > 0.5f) {
+			low = middle;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	scaleRadius = std::exp(0.5f * (low + high));
+}
+
+// Nearest periodic copy of d, the same wrap the tree walk uses
+static inline glm::vec2 wrapOffset(glm::vec2 d, const UpdateVariables& myVar) {
+
+	if (myVar.isPeriodicBoundaryEnabled) {
+		d.x -= myVar.domainSize.x * ((d.x > myVar.halfDomainWidth) - (d.x < -myVar.halfDomainWidth));
+		d.y -= myVar.domainSize.y * ((d.y > myVar.halfDomainHeight) - (d.y < -myVar.halfDomainHeight));
+	}
+
+	return d;
+}
+
+// One pass over the particles per halo. The profile is a template parameter so the loop body has no branches left
+// and vectorizes. The pool takes blocks, each vectorized on its own with its part of the reaction summed at the end.
+// posAt and massAt read particle i, addAcc(i, ax, ay) takes the halo's pull on it
+template <AnalyticHalo::Profile profileType, typename PosAt, typename MassAt, typename AddAcc>
+static glm::dvec2 haloPull(const AnalyticHalo& halo, int64_t count, const UpdateVariables& myVar, PosAt&& posAt,
+	MassAt&& massAt, AddAcc&& addAcc) {
+
+	const float G = static_cast<float>(myVar.G);
+	const float softeningSq = myVar.softening * myVar.softening;
+
+	const float invScale = 1.0f / halo.scaleRadius;
+	const float cutoff = halo.cutoffRadius;
+	const float massScale = G * halo.mass / AnalyticHalo::shape<profileType>(cutoff * invScale);
+
+	const bool periodic = myVar.isPeriodicBoundaryEnabled;
+	const float domainX = myVar.domainSize.x;
+	const float domainY = myVar.domainSize.y;
+	const float halfX = myVar.halfDomainWidth;
+	const float halfY = myVar.halfDomainHeight;
+
+	constexpr int64_t blockSize = 4096;
+	const int64_t blocks = (count + blockSize - 1) / blockSize;
+
+	std::vector<glm::dvec2> blockReaction(static_cast<size_t>(blocks));
+
+	parallel_for(0, static_cast<size_t>(blocks), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1,
+		[&](size_t block, int) {
+
+		const int64_t begin = static_cast<int64_t>(block) * blockSize;
+		const int64_t end = std::min(begin + blockSize, count);
+
+		double reactionX = 0.0;
+		double reactionY = 0.0;
+
+#pragma omp simd reduction(+:reactionX, reactionY)
+		for (int64_t i = begin; i < end; i++) {
+			const glm::vec2 pos = posAt(i);
+			const float mass = massAt(i);
+
+			float dx = halo.pos.x - pos.x;
+			float dy = halo.pos.y - pos.y;
+
+			if (periodic) {
+				dx -= domainX * static_cast<float>((dx > halfX) - (dx < -halfX));
+				dy -= domainY * static_cast<float>((dy > halfY) - (dy < -halfY));
+			}
+
+			float rSq = dx * dx + dy * dy;
+			float x = std::min(std::sqrt(rSq), cutoff) * invScale;
+
+			float softenedSq = std::max(rSq + softeningSq, 1e-12f);
+			float strength = massScale * AnalyticHalo::shape<profileType>(x) / (softenedSq * sqrt(softenedSq));
+
+			float ax = dx * strength;
+			float ay = dy * strength;
+
+			addAcc(i, ax, ay);
+
+			reactionX -= static_cast<double>(mass * ax);
+			reactionY -= static_cast<double>(mass * ay);
+		}
+
+		blockReaction[block] = { reactionX, reactionY };
+		});
+
+	glm::dvec2 reaction = { 0.0, 0.0 };
+	for (const glm::dvec2& value : blockReaction) {
+		reaction += value;
+	}
+
+	return reaction;
+}
+
+template <typename PosAt, typename MassAt, typename AddAcc>
+static glm::dvec2 haloPullOf(const AnalyticHalo& halo, int64_t count, const UpdateVariables& myVar, PosAt&& posAt,
+	MassAt&& massAt, AddAcc&& addAcc) {
+
+	switch (halo.profile) {
+	case AnalyticHalo::Profile::NFW:
+		return haloPull<AnalyticHalo::Profile::NFW>(halo, count, myVar, posAt, massAt, addAcc);
+	case AnalyticHalo::Profile::Plummer:
+		return haloPull<AnalyticHalo::Profile::Plummer>(halo, count, myVar, posAt, massAt, addAcc);
+	default:
+		return haloPull<AnalyticHalo::Profile::Isothermal>(halo, count, myVar, posAt, massAt, addAcc);
+	}
+}
+
+void AnalyticHalos::addGravity(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	const UpdateVariables& myVar) {
+
+	for (AnalyticHalo& halo : halos) {
+		glm::dvec2 reaction = haloPullOf(halo, static_cast<int64_t>(pParticles.size()), myVar,
+			[&](int64_t i) { return pParticles[i].pos; },
+			[&](int64_t i) { return pParticles[i].mass; },
+			[&](int64_t i, float ax, float ay) {
+				float active = Physics::isGravityFrozen(rParticles[i], myVar) ? 0.0f : 1.0f;
+				pParticles[i].acc.x += ax * active;
+				pParticles[i].acc.y += ay * active;
+			});
+
+		halo.acc = glm::vec2(reaction / static_cast<double>(halo.mass));
+	}
+}
+
+void AnalyticHalos::computeReaction(const std::vector<ParticlePhysics>& pParticles, const UpdateVariables& myVar) {
+
+	for (AnalyticHalo& halo : halos) {
+		glm::dvec2 reaction = haloPullOf(halo, static_cast<int64_t>(pParticles.size()), myVar,
+			[&](int64_t i) { return pParticles[i].pos; },
+			[&](int64_t i) { return pParticles[i].mass; },
+			[](int64_t, float, float) {});
+
+		halo.acc = glm::vec2(reaction / static_cast<double>(halo.mass));
+	}
+}
+
+glm::vec2 AnalyticHalos::accelerationAt(glm::vec2 pos, const UpdateVariables& myVar) const {
+
+	glm::vec2 acc = { 0.0f, 0.0f };
+
+	const float softeningSq = myVar.softening * myVar.softening;
+
+	for (const AnalyticHalo& halo : halos) {
+		glm::vec2 d = wrapOffset(halo.pos - pos, myVar);
+
+		float rSq = d.x * d.x + d.y * d.y;
+		float softenedSq = std::max(rSq + softeningSq, 1e-12f);
+
+		float enclosed = halo.mass * halo.enclosedFraction(sqrt(rSq));
+		acc += d * (static_cast<float>(myVar.G) * enclosed / (softenedSq * sqrt(softenedSq)));
+	}
+
+	return acc;
+}
+
+void AnalyticHalos::addMutualPull(const UpdateVariables& myVar) {
+
+	const float softeningSq = myVar.softening * myVar.softening;
+
+	for (size_t a = 0; a < halos.size(); a++) {
+		for (size_t b = a + 1; b < halos.size(); b++) {
+			glm::vec2 d = wrapOffset(halos[b].pos - halos[a].pos, myVar);
+
+			float rSq = d.x * d.x + d.y * d.y;
+			float r = sqrt(rSq);
+			float softenedSq = std::max(rSq + softeningSq, 1e-12f);
+
+			// Each halo pulls the other with the mass of its own profile inside their distance
+			float invCube = static_cast<float>(myVar.G) / (softenedSq * sqrt(softenedSq));
+			halos[a].acc += d * (invCube * halos[b].mass * halos[b].enclosedFraction(r));
+			halos[b].acc -= d * (invCube * halos[a].mass * halos[a].enclosedFraction(r));
+		}
+	}
+
+}
+
+void AnalyticHalos::step(float kickStep, float driftStep, float damping, const UpdateVariables& myVar) {
+
+	const float accelScale = Physics::accelScale(myVar);
+
+	for (AnalyticHalo& halo : halos) {
+		halo.vel += kickStep * accelScale * halo.acc;
+		halo.vel *= damping;
+		halo.pos += halo.vel * driftStep;
+
+		if (myVar.isPeriodicBoundaryEnabled) {
+			halo.pos.x -= myVar.domainSize.x * std::floor(halo.pos.x / myVar.domainSize.x);
+			halo.pos.y -= myVar.domainSize.y * std::floor(halo.pos.y / myVar.domainSize.y);
+		}
+	}
+}
+
+void AnalyticHalos::spawnForGalaxy(glm::vec2 pos, glm::vec2 vel, float mass, float coreRadius, float outerRadius,
+	const UpdateVariables& myVar) {
+
+	AnalyticHalo halo;
+	halo.pos = pos;
+	halo.vel = vel;
+	halo.mass = mass;
+	halo.cutoffRadius = outerRadius;
+	halo.profile = static_cast<AnalyticHalo::Profile>(std::clamp(myVar.haloProfile, 0, 2));
+
+	// Half of the spawned particles fall inside log(1 + r^2 / core^2) = log(1 + outer^2 / core^2) / 2
+	float ratio = outerRadius / coreRadius;
+	float halfMassRadius = coreRadius * sqrt(sqrt(1.0f + ratio * ratio) - 1.0f);
+
+	halo.fitScaleRadius(halfMassRadius);
+
+	halos.push_back(halo);
+}
+
+void AnalyticHalos::freezeDarkMatter(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
+	const UpdateVariables& myVar) {
+
+	bool isAnySelected = false;
+	for (size_t i = 0; i < rParticles.size(); i++) {
+		if (rParticles[i].isDarkMatter && rParticles[i].isSelected) {
+			isAnySelected = true;
+			break;
+		}
+	}
+
+	std::vector<uint32_t> members;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(rParticles.size()); i++) {
+		if (rParticles[i].isDarkMatter && (!isAnySelected || rParticles[i].isSelected)) {
+			members.push_back(i);
+		}
+	}
+
+	if (members.empty()) {
+		return;
+	}
+
+	// The componentwise median sits in the core, offsets from it stay right when the halo crosses a looping border
+	std::vector<float> xs(members.size());
+	std::vector<float> ys(members.size());
+	for (size_t k = 0; k < members.size(); k++) {
+		xs[k] = pParticles[members[k]].pos.x;
+		ys[k] = pParticles[members[k]].pos.y;
+	}
+
+	size_t middle = members.size() / 2;
+	std::nth_element(xs.begin(), xs.begin() + middle, xs.end());
+	std::nth_element(ys.begin(), ys.begin() + middle, ys.end());
+	glm::vec2 reference = { xs[middle], ys[middle] };
+
+	double totalMass = 0.0;
+	glm::dvec2 weightedOffset = { 0.0, 0.0 };
+	glm::dvec2 momentum = { 0.0, 0.0 };
+
+	for (uint32_t i : members) {
+		double m = pParticles[i].mass;
+		totalMass += m;
+		weightedOffset += glm::dvec2(wrapOffset(pParticles[i].pos - reference, myVar)) * m;
+		momentum += glm::dvec2(pParticles[i].vel) * m;
+	}
+
+	if (totalMass <= 0.0) {
+		return;
+	}
+
+	AnalyticHalo halo;
+	halo.pos = reference + glm::vec2(weightedOffset / totalMass);
+	halo.vel = glm::vec2(momentum / totalMass);
+	halo.mass = static_cast<float>(totalMass);
+	halo.profile = static_cast<AnalyticHalo::Profile>(std::clamp(myVar.haloProfile, 0, 2));
+
+	// Mass weighted radii, the cutoff holds 99% of the mass so a few strays don't stretch the halo
+	std::vector<std::pair<float, float>> radii;
+	radii.reserve(members.size());
+	for (uint32_t i : members) {
+		radii.push_back({ glm::length(wrapOffset(pParticles[i].pos - halo.pos, myVar)), pParticles[i].mass });
+	}
+	std::sort(radii.begin(), radii.end());
+
+	float halfMassRadius = radii.back().first;
+	float cutoffRadius = radii.back().first;
+	double runningMass = 0.0;
+	bool isHalfFound = false;
+
+	for (const std::pair<float, float>& radius : radii) {
+		runningMass += radius.second;
+
+		if (!isHalfFound && runningMass >= 0.5 * totalMass) {
+			halfMassRadius = radius.first;
+			isHalfFound = true;
+		}
+
+		if (runningMass >= 0.99 * totalMass) {
+			cutoffRadius = radius.first;
+			break;
+		}
+	}
+
+	halo.cutoffRadius = std::max(cutoffRadius, 1.0f);
+	halo.fitScaleRadius(halfMassRadius);
+
+	halos.push_back(halo);
+
+	std::vector<uint8_t> isRemoved(pParticles.size(), 0);
+	for (uint32_t i : members) {
+		isRemoved[i] = 1;
+	}
+
+	size_t write = 0;
+	for (size_t read = 0; read < pParticles.size(); read++) {
+		if (isRemoved[read]) {
+			continue;
+		}
+
+		if (write != read) {
+			pParticles[write] = std::move(pParticles[read]);
+			rParticles[write] = std::move(rParticles[read]);
+		}
+		write++;
+	}
+
+	pParticles.resize(write);
+	rParticles.resize(write);
+}
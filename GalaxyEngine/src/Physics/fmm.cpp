@@ -0,0 +1,506 @@
+#include "Physics/fmm.h"
+#include "Physics/physics.h"
+#include "UX/parallel_for.h"
+
+namespace {
+
+	constexpr int maxCoeffs = FMM::coeffCount(FMM::maxOrder);
+
+	struct FmmTables {
+		double invFactorial[FMM::maxOrder + 1];
+		double binomial[FMM::maxOrder + 1][FMM::maxOrder + 1];
+
+		// a! / (k! (a - 2k)!), the terms of d^a/dx^a g(x^2 + c)
+		double hermite[FMM::maxOrder + 1][FMM::maxOrder / 2 + 1];
+
+		FmmTables() {
+			double factorial[FMM::maxOrder + 1];
+			factorial[0] = 1.0;
+			for (int i = 1; i <= FMM::maxOrder; i++) {
+				factorial[i] = factorial[i - 1] * i;
+			}
+
+			for (int i = 0; i <= FMM::maxOrder; i++) {
+				invFactorial[i] = 1.0 / factorial[i];
+
+				for (int k = 0; k <= FMM::maxOrder; k++) {
+					binomial[i][k] = k <= i ? factorial[i] / (factorial[k] * factorial[i - k]) : 0.0;
+				}
+
+				for (int k = 0; k <= FMM::maxOrder / 2; k++) {
+					hermite[i][k] = 2 * k <= i ? factorial[i] / (factorial[k] * factorial[i - 2 * k]) : 0.0;
+				}
+			}
+		}
+	};
+
+	const FmmTables tables;
+
+	inline void powers(double x, int order, double* out) {
+		out[0] = 1.0;
+		for (int i = 1; i <= order; i++) {
+			out[i] = out[i - 1] * x;
+		}
+	}
+
+	// Partial derivatives d^(a+b) / dx^a dy^b of 1 / sqrt(x^2 + y^2 + softening^2) for every a + b <= order.
+	// With s = x^2 + y^2 + softening^2 the x and y parts separate, so each derivative is a double sum over the
+	// derivatives of s^(-1/2)
+	void kernelDerivatives(double x, double y, double softeningSq, int order, double* derivatives) {
+
+		double s = x * x + y * y + softeningSq;
+		double invS = 1.0 / s;
+
+		double g[FMM::maxOrder + 1];
+		g[0] = 1.0 / std::sqrt(s);
+		for (int n = 1; n <= order; n++) {
+			g[n] = g[n - 1] * -(2.0 * n - 1.0) * 0.5 * invS;
+		}
+
+		double px[FMM::maxOrder + 1];
+		double py[FMM::maxOrder + 1];
+		powers(2.0 * x, order, px);
+		powers(2.0 * y, order, py);
+
+		for (int n = 0; n <= order; n++) {
+			for (int b = 0; b <= n; b++) {
+				int a = n - b;
+
+				double sum = 0.0;
+				for (int k = 0; 2 * k <= a; k++) {
+					for (int l = 0; 2 * l <= b; l++) {
+						sum += tables.hermite[a][k] * tables.hermite[b][l] * px[a - 2 * k] * py[b - 2 * l] * g[n - k - l];
+					}
+				}
+
+				derivatives[FMM::coeffIndex(a, b)] = sum;
+			}
+		}
+	}
+
+	inline glm::vec2 wrapPeriodic(glm::vec2 d, const UpdateVariables& myVar) {
+		if (myVar.isPeriodicBoundaryEnabled) {
+			d.x -= myVar.domainSize.x * ((d.x > myVar.halfDomainWidth) - (d.x < -myVar.halfDomainWidth));
+			d.y -= myVar.domainSize.y * ((d.y > myVar.halfDomainHeight) - (d.y < -myVar.halfDomainHeight));
+		}
+		return d;
+	}
+
+	// Direct sum of the source cell's particles onto the target cell's particles. Coincident particles are masked out
+	// like in the group walk, which also drops self interaction
+	void particleToParticle(std::vector<ParticlePhysics>& pParticles, const UpdateVariables& myVar, const FmmCell& target,
+		const FmmCell& source) {
+
+		const float G = static_cast<float>(myVar.G);
+		const float softeningSq = myVar.softening * myVar.softening;
+
+		const bool periodic = myVar.isPeriodicBoundaryEnabled;
+		const float domainWidth = myVar.domainSize.x;
+		const float domainHeight = myVar.domainSize.y;
+		const float halfWidth = myVar.halfDomainWidth;
+		const float halfHeight = myVar.halfDomainHeight;
+
+		const ParticlePhysics* particles = pParticles.data();
+
+		const int64_t sourceStart = source.startIndex;
+		const int64_t sourceEnd = source.endIndex;
+
+		for (uint32_t i = target.startIndex; i < target.endIndex; i++) {
+			const float px = particles[i].pos.x;
+			const float py = particles[i].pos.y;
+
+			float ax = 0.0f;
+			float ay = 0.0f;
+
+#pragma omp simd reduction(+:ax, ay)
+			for (int64_t j = sourceStart; j < sourceEnd; j++) {
+				float dx = particles[j].pos.x - px;
+				float dy = particles[j].pos.y - py;
+
+				if (periodic) {
+					dx -= domainWidth * ((dx > halfWidth) - (dx < -halfWidth));
+					dy -= domainHeight * ((dy > halfHeight) - (dy < -halfHeight));
+				}
+
+				float invDistance = 1.0f / std::sqrt(dx * dx + dy * dy + softeningSq);
+				float strength = particles[j].mass * invDistance * invDistance * invDistance;
+
+				bool coincident = std::fabs(dx) < 0.001f && std::fabs(dy) < 0.001f;
+				strength = coincident ? 0.0f : strength;
+
+				ax += dx * strength;
+				ay += dy * strength;
+			}
+
+			pParticles[i].acc += glm::vec2(ax, ay) * G;
+		}
+	}
+
+	void multipoleToLocal(const double* multipole, double* local, glm::vec2 r, float softeningSq, int order) {
+
+		double derivatives[maxCoeffs];
+		kernelDerivatives(r.x, r.y, softeningSq, order, derivatives);
+
+		for (int m = 0; m <= order; m++) {
+			for (int mb = 0; mb <= m; mb++) {
+				int ma = m - mb;
+
+				double sum = 0.0;
+				for (int n = 0; n <= order - m; n++) {
+					double sign = (n & 1) ? -1.0 : 1.0;
+
+					for (int nb = 0; nb <= n; nb++) {
+						int na = n - nb;
+						sum += sign * multipole[FMM::coeffIndex(na, nb)] * derivatives[FMM::coeffIndex(ma + na, mb + nb)];
+					}
+				}
+
+				local[FMM::coeffIndex(ma, mb)] += sum * tables.invFactorial[ma] * tables.invFactorial[mb];
+			}
+		}
+	}
+}
+
+void FMM::buildCells() {
+
+	cells.clear();
+	levelStarts.clear();
+
+	if (globalNodes.empty()) {
+		return;
+	}
+
+	const Node& rootNode = globalNodes[0];
+	cells.push_back({ 0, UINT32_MAX, rootNode.startIndex, rootNode.endIndex, 0, 0, 0, {}, 0.0f, 0.0f });
+
+	for (uint32_t i = 0; i < cells.size(); i++) {
+		const Node& node = globalNodes[cells[i].node];
+
+		if (levelStarts.size() <= static_cast<size_t>(cells[i].level)) {
+			levelStarts.push_back(i);
+		}
+
+		if (node.endIndex - node.startIndex <= leafMaxParticles || !node.hasChildren()) {
+			continue;
+		}
+
+		uint32_t firstChild = static_cast<uint32_t>(cells.size());
+		int level = cells[i].level + 1;
+
+		// Quadrant order, so the children's particle ranges follow each other
+		for (int q = 0; q < 4; q++) {
+			uint32_t childIdx = node.subGrids[q & 1][(q & 2) >> 1];
+
+			if (childIdx == UINT32_MAX) {
+				continue;
+			}
+
+			const Node& child = globalNodes[childIdx];
+
+			if (child.endIndex == child.startIndex) {
+				continue;
+			}
+
+			cells.push_back({ childIdx, i, child.startIndex, child.endIndex, 0, 0, level, {}, 0.0f, 0.0f });
+		}
+
+		cells[i].firstChild = firstChild;
+		cells[i].childCount = static_cast<uint32_t>(cells.size()) - firstChild;
+	}
+
+	levelStarts.push_back(static_cast<uint32_t>(cells.size()));
+
+	for (FmmCell& cell : cells) {
+		const Node& node = globalNodes[cell.node];
+
+		cell.mass = node.gridMass;
+		cell.center = node.gridMass > 0.0f ? node.centerOfMass : node.pos + glm::vec2(node.size * 0.5f);
+	}
+}
+
+void FMM::buildFrontier() {
+
+	frontier.clear();
+	frontierClass.assign(cells.size(), 2);
+
+	if (cells.empty()) {
+		return;
+	}
+
+	const int threads = threadPool.size();
+
+	// Around 16 tasks per thread, like the tree build
+	const uint32_t particleCount = cells[0].endIndex - cells[0].startIndex;
+	const uint32_t taskCutoff = std::max(leafMaxParticles, particleCount / static_cast<uint32_t>(threads * 16));
+
+	std::vector<uint32_t> stack;
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		uint32_t c = stack.back();
+		stack.pop_back();
+
+		const FmmCell& cell = cells[c];
+
+		if (cell.isLeaf() || cell.endIndex - cell.startIndex <= taskCutoff) {
+			frontier.push_back(c);
+			frontierClass[c] = 1;
+			continue;
+		}
+
+		frontierClass[c] = 0;
+
+		for (uint32_t k = 0; k < cell.childCount; k++) {
+			stack.push_back(cell.firstChild + k);
+		}
+	}
+}
+
+void FMM::upwardPass(const std::vector<ParticlePhysics>& pParticles, int order) {
+
+	const int coeffs = coeffCount(order);
+
+	multipoles.assign(cells.size() * coeffs, 0.0);
+
+	// Deepest level first, every cell of a level is independent
+	for (int64_t level = static_cast<int64_t>(levelStarts.size()) - 2; level >= 0; level--) {
+
+		parallel_for(levelStarts[level], levelStarts[level + 1], [&](size_t c, int) {
+			FmmCell& cell = cells[c];
+			double* multipole = &multipoles[c * coeffs];
+
+			double xp[maxOrder + 1];
+			double yp[maxOrder + 1];
+
+			if (cell.isLeaf()) {
+				float radiusSq = 0.0f;
+
+				for (uint32_t j = cell.startIndex; j < cell.endIndex; j++) {
+					glm::vec2 r = pParticles[j].pos - cell.center;
+					radiusSq = std::max(radiusSq, r.x * r.x + r.y * r.y);
+
+					powers(r.x, order, xp);
+					powers(r.y, order, yp);
+
+					double mass = pParticles[j].mass;
+
+					for (int n = 0; n <= order; n++) {
+						for (int b = 0; b <= n; b++) {
+							int a = n - b;
+							multipole[coeffIndex(a, b)] += mass * xp[a] * tables.invFactorial[a] * yp[b] * tables.invFactorial[b];
+						}
+					}
+				}
+
+				cell.radius = std::sqrt(radiusSq);
+				return;
+			}
+
+			float radius = 0.0f;
+
+			for (uint32_t k = 0; k < cell.childCount; k++) {
+				const FmmCell& child = cells[cell.firstChild + k];
+				const double* childMultipole = &multipoles[(cell.firstChild + k) * coeffs];
+
+				glm::vec2 s = child.center - cell.center;
+				radius = std::max(radius, std::sqrt(s.x * s.x + s.y * s.y) + child.radius);
+
+				powers(s.x, order, xp);
+				powers(s.y, order, yp);
+
+				for (int n = 0; n <= order; n++) {
+					for (int b = 0; b <= n; b++) {
+						int a = n - b;
+
+						double sum = 0.0;
+						for (int kb = 0; kb <= b; kb++) {
+							for (int ka = 0; ka <= a; ka++) {
+								sum += childMultipole[coeffIndex(ka, kb)]
+									* xp[a - ka] * tables.invFactorial[a - ka] * yp[b - kb] * tables.invFactorial[b - kb];
+							}
+						}
+
+						multipole[coeffIndex(a, b)] += sum;
+					}
+				}
+			}
+
+			cell.radius = radius;
+			});
+	}
+}
+
+void FMM::dualWalk(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, int order, uint32_t target) {
+
+	const int coeffs = coeffCount(order);
+	const float softeningSq = myVar.softening * myVar.softening;
+
+	std::vector<std::pair<uint32_t, uint32_t>> stack;
+	stack.reserve(256);
+	stack.push_back({ target, 0 });
+
+	while (!stack.empty()) {
+		auto [a, b] = stack.back();
+		stack.pop_back();
+
+		const FmmCell& cellA = cells[a];
+		const FmmCell& cellB = cells[b];
+
+		if (cellB.mass <= 0.0f) {
+			continue;
+		}
+
+		if (a == b) {
+			if (cellA.isLeaf()) {
+				particleToParticle(pParticles, myVar, cellA, cellA);
+			}
+			else {
+				for (uint32_t i = 0; i < cellA.childCount; i++) {
+					for (uint32_t j = 0; j < cellA.childCount; j++) {
+						stack.push_back({ cellA.firstChild + i, cellA.firstChild + j });
+					}
+				}
+			}
+			continue;
+		}
+
+		glm::vec2 r = wrapPeriodic(cellA.center - cellB.center, myVar);
+		float distance = std::sqrt(r.x * r.x + r.y * r.y);
+
+		if (cellA.radius + cellB.radius < openingRatio * distance) {
+			multipoleToLocal(&multipoles[b * coeffs], &locals[a * coeffs], r, softeningSq, order);
+		}
+		else if (cellA.isLeaf() && cellB.isLeaf()) {
+			particleToParticle(pParticles, myVar, cellA, cellB);
+		}
+		else if (cellB.isLeaf() || (!cellA.isLeaf() && cellA.radius > cellB.radius)) {
+			for (uint32_t i = 0; i < cellA.childCount; i++) {
+				stack.push_back({ cellA.firstChild + i, b });
+			}
+		}
+		else {
+			for (uint32_t j = 0; j < cellB.childCount; j++) {
+				stack.push_back({ a, cellB.firstChild + j });
+			}
+		}
+	}
+}
+
+void FMM::downwardPass(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, int order) {
+
+	const int coeffs = coeffCount(order);
+	const double G = myVar.G;
+
+	// Shallowest level first so every parent's local is complete before it is shifted down
+	for (size_t level = 0; level + 1 < levelStarts.size(); level++) {
+
+		parallel_for(levelStarts[level], levelStarts[level + 1], [&](size_t c, int) {
+			const FmmCell& cell = cells[c];
+
+			if (frontierClass[c] == 0) {
+				return;
+			}
+
+			double* local = &locals[c * coeffs];
+
+			double xp[maxOrder + 1];
+			double yp[maxOrder + 1];
+
+			if (frontierClass[c] == 2) {
+				const double* parentLocal = &locals[static_cast<size_t>(cell.parent) * coeffs];
+
+				glm::vec2 t = cell.center - cells[cell.parent].center;
+				powers(t.x, order, xp);
+				powers(t.y, order, yp);
+
+				for (int k = 0; k <= order; k++) {
+					for (int kb = 0; kb <= k; kb++) {
+						int ka = k - kb;
+
+						double sum = 0.0;
+						for (int m = k; m <= order; m++) {
+							for (int mb = kb; mb <= m; mb++) {
+								int ma = m - mb;
+
+								if (ma < ka) {
+									continue;
+								}
+
+								sum += parentLocal[coeffIndex(ma, mb)]
+									* tables.binomial[ma][ka] * tables.binomial[mb][kb] * xp[ma - ka] * yp[mb - kb];
+							}
+						}
+
+						local[coeffIndex(ka, kb)] += sum;
+					}
+				}
+			}
+
+			if (!cell.isLeaf()) {
+				return;
+			}
+
+			for (uint32_t i = cell.startIndex; i < cell.endIndex; i++) {
+				glm::vec2 y = pParticles[i].pos - cell.center;
+				powers(y.x, order, xp);
+				powers(y.y, order, yp);
+
+				double gx = 0.0;
+				double gy = 0.0;
+
+				for (int m = 1; m <= order; m++) {
+					for (int mb = 0; mb <= m; mb++) {
+						int ma = m - mb;
+						double coeff = local[coeffIndex(ma, mb)];
+
+						if (ma > 0) {
+							gx += coeff * ma * xp[ma - 1] * yp[mb];
+						}
+						if (mb > 0) {
+							gy += coeff * mb * xp[ma] * yp[mb - 1];
+						}
+					}
+				}
+
+				pParticles[i].acc += glm::vec2(static_cast<float>(G * gx), static_cast<float>(G * gy));
+			}
+			});
+	}
+}
+
+void FMM::computeGravity(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	UpdateVariables& myVar, int order) {
+
+	order = std::clamp(order, 1, maxOrder);
+
+	const int threads = myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1;
+
+	// The near and far field passes both add onto acc
+	parallel_for(0, pParticles.size(), threads, [&](size_t i, int) {
+		pParticles[i].acc = { 0.0f, 0.0f };
+		});
+
+	buildCells();
+
+	if (cells.empty()) {
+		return;
+	}
+
+	buildFrontier();
+
+	upwardPass(pParticles, order);
+
+	locals.assign(cells.size() * coeffCount(order), 0.0);
+
+	parallel_for(0, frontier.size(), threads, [&](size_t t, int) {
+		dualWalk(pParticles, myVar, order, frontier[t]);
+		});
+
+	downwardPass(pParticles, myVar, order);
+
+	parallel_for(0, pParticles.size(), threads, [&](size_t i, int) {
+		if (Physics::isGravityFrozen(rParticles[i], myVar)) {
+			pParticles[i].acc = { 0.0f, 0.0f };
+		}
+		});
+}
@@ -0,0 +1,431 @@
+#include "Physics/futurePreview.h"
+
+#include "Physics/physics.h"
+#include "Physics/physicsPipeline.h"
+
+#include "UX/parallel_for.h"
+
+#include "parameters.h"
+
+struct FuturePreview::Snapshot {
+
+	// Bodies of the decimated scene and, per body, the track it feeds or -1
+	std::vector<ParticlePhysics> bodies;
+	std::vector<int32_t> tracks;
+	std::vector<uint8_t> isPinned;
+
+	std::vector<Color> colors;
+
+	AnalyticHalos halos;
+
+	// The walk only reads plain settings from here, with the preview's theta and its timestep in timeFactor
+	UpdateVariables settings;
+
+	int steps = 0;
+	int threads = 1;
+
+	explicit Snapshot(const UpdateVariables& myVar) : settings(myVar) {
+	}
+};
+
+// Scratch of one run. Bodies are kept in tree order, tracks and pins are moved along with them
+struct PreviewRun {
+	std::vector<ParticlePhysics> bodies;
+	std::vector<int32_t> tracks;
+	std::vector<uint8_t> isPinned;
+
+	std::vector<ParticlePhysics> sortedBodies;
+	std::vector<int32_t> sortedTracks;
+	std::vector<uint8_t> sortedPinned;
+
+	Morton morton;
+	std::vector<Node> nodes;
+	std::vector<GravityNode> gravity;
+	std::vector<glm::vec2> acc;
+
+	// threads caps the key sort like the force loop, the rest of the build runs on the calling thread
+	void buildTree(int threads) {
+		glm::vec3 bb = PhysicsPipeline::boundingBox(bodies);
+
+		morton.computeSortedKeys(bodies, bb, threads);
+
+		const std::vector<MortonEntry>& entries = morton.entries;
+		const uint32_t count = static_cast<uint32_t>(entries.size());
+
+		// Copies instead of resizing, constructing a particle takes a new id from globalId
+		if (sortedBodies.size() != count) {
+			sortedBodies = bodies;
+		}
+		sortedTracks.resize(count);
+		sortedPinned.resize(count);
+
+		for (uint32_t k = 0; k < count; k++) {
+			uint32_t index = entries[k].index;
+			sortedBodies[k] = bodies[index];
+			sortedTracks[k] = tracks[index];
+			sortedPinned[k] = isPinned[index];
+		}
+
+		bodies.swap(sortedBodies);
+		tracks.swap(sortedTracks);
+		isPinned.swap(sortedPinned);
+
+		nodes.clear();
+		Quadtree::buildSubtree(entries, { { bb.x, bb.y }, bb.z, 0, count, 0, UINT32_MAX, 0 }, nodes);
+		Quadtree::computeMasses(bodies, nodes);
+
+		gravity.resize(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++) {
+			gravity[i] = Quadtree::toGravityNode(nodes[i]);
+		}
+	}
+};
+
+FuturePreview::~FuturePreview() {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		snapshot.reset();
+
+		// Runs can take seconds, this makes the one in flight give up
+		latest.store(++requested, std::memory_order_release);
+	}
+
+	threadPool.wait(task);
+}
+
+void FuturePreview::update(const UpdateParameters& myParam, const UpdateVariables& myVar, const Physics& physics) {
+
+	if (!myVar.isFutureOrbitsEnabled || myParam.pParticlesSelected.empty()) {
+		if (isActive) {
+			cancel();
+		}
+		return;
+	}
+
+	std::vector<uint32_t> selection;
+	selection.reserve(myParam.pParticlesSelected.size());
+	for (const ParticlePhysics& pParticle : myParam.pParticlesSelected) {
+		selection.push_back(pParticle.id);
+	}
+
+	// New, deleted or loaded particles and selection changes make the running prediction wrong, so it's replaced
+	bool isSceneChanged = !isActive || myParam.pParticles.size() != sceneParticles || selection != sceneSelection;
+
+	bool isRefreshDue = false;
+	if (!isSceneChanged && myVar.timeFactor > 0.0f) {
+		std::lock_guard<std::mutex> lock(mutex);
+		isRefreshDue = isFinished;
+	}
+
+	if (isSceneChanged || isRefreshDue) {
+		start(myParam, myVar, physics, std::move(selection), !isSceneChanged);
+	}
+}
+
+void FuturePreview::start(const UpdateParameters& myParam, const UpdateVariables& myVar, const Physics& physics,
+	std::vector<uint32_t>&& selection, bool isRefresh) {
+
+	const std::vector<ParticlePhysics>& pParticles = myParam.pParticles;
+	const std::vector<ParticleRendering>& rParticles = myParam.rParticles;
+
+	// Counted from the scene itself, the selection list can be stale for a frame after deleting or loading
+	size_t selectedCount = 0;
+	for (const ParticleRendering& rParticle : rParticles) {
+		selectedCount += rParticle.isSelected ? 1 : 0;
+	}
+
+	const size_t maxBodies = static_cast<size_t>(std::max(myVar.futureOrbitMaxBodies, 1));
+	const size_t trackCount = std::min(selectedCount, maxBodies);
+	const size_t others = pParticles.size() - trackCount;
+
+	// The remaining budget goes to the unselected particles. The scene is in Morton order after the tree build, so
+	// stride consecutive ones are close by and get merged into one body at their center of mass, which keeps the mass
+	// and the momentum where they were
+	const size_t budget = maxBodies - trackCount;
+	const size_t stride = budget > 0 ? std::max<size_t>(1, (others + budget - 1) / budget) : 0;
+
+	std::shared_ptr<Snapshot> newSnapshot = std::make_shared<Snapshot>(myVar);
+	newSnapshot->bodies.reserve(trackCount + (stride > 0 ? others / stride + 1 : 0));
+
+	// Copied rather than constructed, so no new id is taken from globalId
+	auto addBody = [&](const ParticlePhysics& pParticle, int32_t track, bool isPinned) {
+		newSnapshot->bodies.push_back(pParticle);
+		newSnapshot->bodies.back().neighborIds.clear();
+		newSnapshot->tracks.push_back(track);
+		newSnapshot->isPinned.push_back(isPinned);
+		};
+
+	size_t groupFirst = 0;
+	size_t groupCount = 0;
+	double groupMass = 0.0;
+	glm::dvec2 groupPos = { 0.0, 0.0 };
+	glm::dvec2 groupMomentum = { 0.0, 0.0 };
+	bool isGroupPinned = false;
+
+	auto flushGroup = [&]() {
+		if (groupCount == 0) {
+			return;
+		}
+
+		addBody(pParticles[groupFirst], -1, isGroupPinned);
+
+		ParticlePhysics& body = newSnapshot->bodies.back();
+		if (groupMass > 0.0) {
+			body.pos = glm::vec2(groupPos / groupMass);
+			body.vel = glm::vec2(groupMomentum / groupMass);
+		}
+		body.mass = static_cast<float>(groupMass);
+
+		groupCount = 0;
+		groupMass = 0.0;
+		groupPos = { 0.0, 0.0 };
+		groupMomentum = { 0.0, 0.0 };
+		isGroupPinned = false;
+		};
+
+	for (size_t i = 0; i < pParticles.size(); i++) {
+		if (rParticles[i].isSelected && newSnapshot->colors.size() < trackCount) {
+			addBody(pParticles[i], static_cast<int32_t>(newSnapshot->colors.size()), rParticles[i].isPinned);
+			newSnapshot->colors.push_back(rParticles[i].color);
+			continue;
+		}
+
+		if (stride == 0) {
+			continue;
+		}
+
+		if (groupCount == 0) {
+			groupFirst = i;
+		}
+
+		double mass = pParticles[i].mass;
+		groupMass += mass;
+		groupPos += glm::dvec2(pParticles[i].pos) * mass;
+		groupMomentum += glm::dvec2(pParticles[i].vel) * mass;
+		isGroupPinned = isGroupPinned || rParticles[i].isPinned;
+
+		if (++groupCount == stride) {
+			flushGroup();
+		}
+	}
+
+	flushGroup();
+
+	newSnapshot->halos = physics.analyticHalos;
+
+	UpdateVariables& settings = newSnapshot->settings;
+	settings.isQuadrupoleEnabled = false;
+	settings.isRelativeOpeningEnabled = false;
+	settings.theta = myVar.futureOrbitTheta;
+	settings.halfDomainWidth = myVar.domainSize.x * 0.5f;
+	settings.halfDomainHeight = myVar.domainSize.y * 0.5f;
+
+	// Paused scenes still get a preview, at the step they would run with
+	settings.timeFactor = myVar.fixedDeltaTime * myVar.timeStepMultiplier * myVar.futureOrbitStepScale;
+
+	newSnapshot->steps = std::max(myVar.futureOrbitSteps, 1);
+	newSnapshot->threads = std::max(myVar.futureOrbitThreads, 1);
+
+	sceneParticles = pParticles.size();
+	sceneSelection = std::move(selection);
+	isActive = true;
+
+	bool shouldStart = false;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		snapshot = std::move(newSnapshot);
+		latest.store(++requested, std::memory_order_release);
+		isFinished = false;
+
+		building.assign(snapshot->colors.size(), {});
+		buildingColors = snapshot->colors;
+
+		// Old tracks of another scene or selection would point the wrong way
+		if (!isRefresh) {
+			finished.clear();
+			finishedColors.clear();
+		}
+
+		shouldStart = !isRunning;
+		isRunning = true;
+	}
+
+	if (shouldStart) {
+		threadPool.run(task, [this]() { workerLoop(); });
+	}
+}
+
+void FuturePreview::cancel() {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	snapshot.reset();
+	latest.store(++requested, std::memory_order_release);
+	isFinished = false;
+
+	building.clear();
+	finished.clear();
+	buildingColors.clear();
+	finishedColors.clear();
+
+	isActive = false;
+	sceneParticles = 0;
+	sceneSelection.clear();
+}
+
+void FuturePreview::draw(const UpdateVariables& myVar) {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Until the first run finishes, the tracks grow on screen
+	const std::vector<std::vector<glm::vec2>>& tracks = finished.empty() ? building : finished;
+	const std::vector<Color>& colors = finished.empty() ? buildingColors : finishedColors;
+
+	const float maxSegmentSq = 0.25f * (myVar.domainSize.x * myVar.domainSize.x + myVar.domainSize.y * myVar.domainSize.y);
+
+	for (size_t t = 0; t < tracks.size(); t++) {
+		const std::vector<glm::vec2>& track = tracks[t];
+
+		Color color = colors[t];
+
+		for (size_t i = 1; i < track.size(); i++) {
+
+			// Fades out toward the end of the prediction, where it's least accurate
+			color.a = static_cast<unsigned char>(200.0f * (1.0f - static_cast<float>(i) / static_cast<float>(track.size())) + 30.0f);
+
+			// Segments that wrapped around the looping borders would cross the whole domain
+			glm::vec2 d = track[i] - track[i - 1];
+			if (d.x * d.x + d.y * d.y > maxSegmentSq) {
+				continue;
+			}
+
+			DrawLineV({ track[i - 1].x, track[i - 1].y }, { track[i].x, track[i].y }, color);
+		}
+	}
+}
+
+void FuturePreview::workerLoop() {
+
+	uint64_t done = 0;
+
+	PreviewRun run;
+
+	std::vector<std::vector<glm::vec2>> chunk;
+
+	while (true) {
+		std::shared_ptr<const Snapshot> current;
+		uint64_t generation = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			// Nothing new to run, the next start() queues the task again
+			if (!snapshot || requested == done) {
+				isRunning = false;
+				return;
+			}
+
+			current = snapshot;
+			generation = requested;
+			done = requested;
+		}
+
+		// Works on its own copy, the walk wants mutable settings
+		UpdateVariables settings = current->settings;
+		AnalyticHalos halos = current->halos;
+
+		run.bodies = current->bodies;
+		run.tracks = current->tracks;
+		run.isPinned = current->isPinned;
+
+		const float accelScale = Physics::accelScale(settings);
+		const float step = settings.timeFactor;
+		const int64_t count = static_cast<int64_t>(run.bodies.size());
+
+		chunk.assign(current->colors.size(), {});
+
+		bool isCancelled = false;
+
+		for (int s = 0; s < current->steps && !isCancelled; s += chunkSteps) {
+			for (std::vector<glm::vec2>& track : chunk) {
+				track.clear();
+			}
+
+			int chunkEnd = std::min(s + chunkSteps, current->steps);
+			for (int k = s; k < chunkEnd; k++) {
+				if (latest.load(std::memory_order_relaxed) != generation) {
+					isCancelled = true;
+					break;
+				}
+
+				run.buildTree(current->threads);
+				run.acc.resize(run.bodies.size());
+
+				parallel_for(0, count, current->threads, [&](int64_t i, int) {
+					const ParticlePhysics& body = run.bodies[i];
+
+					if (run.isPinned[i] || body.mass <= 0.0f) {
+						run.acc[i] = { 0.0f, 0.0f };
+						return;
+					}
+
+					glm::vec2 acc = Physics::calculateForceFromNodes(run.gravity, settings, run.bodies,
+						static_cast<uint32_t>(i)) / body.mass;
+
+					if (!halos.halos.empty()) {
+						acc += halos.accelerationAt(body.pos, settings);
+					}
+
+					run.acc[i] = acc;
+					});
+
+				// Same kick and drift as the scene integrator
+				for (int64_t i = 0; i < count; i++) {
+					ParticlePhysics& body = run.bodies[i];
+
+					body.vel += step * accelScale * run.acc[i];
+					body.pos += body.vel * step;
+
+					if (settings.isPeriodicBoundaryEnabled) {
+						body.pos.x -= settings.domainSize.x * std::floor(body.pos.x / settings.domainSize.x);
+						body.pos.y -= settings.domainSize.y * std::floor(body.pos.y / settings.domainSize.y);
+					}
+
+					if (run.tracks[i] >= 0) {
+						chunk[run.tracks[i]].push_back(body.pos);
+					}
+				}
+
+				// Halos pull each other but not back on the decimated bodies, close enough for a preview
+				for (AnalyticHalo& halo : halos.halos) {
+					halo.acc = { 0.0f, 0.0f };
+				}
+				halos.addMutualPull(settings);
+				halos.step(step, step, 1.0f, settings);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (latest.load(std::memory_order_acquire) != generation) {
+				break;
+			}
+
+			for (size_t t = 0; t < chunk.size(); t++) {
+				building[t].insert(building[t].end(), chunk[t].begin(), chunk[t].end());
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (latest.load(std::memory_order_acquire) == generation && !isCancelled) {
+			finished = std::move(building);
+			finishedColors = std::move(buildingColors);
+			building.assign(finished.size(), {});
+			buildingColors = finishedColors;
+			isFinished = true;
+		}
+	}
+}
@@ -0,0 +1,320 @@
+#include "Physics/gravityKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GE_KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GE_KERNEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// The app is built for the baseline ISA, so the AVX2 path is compiled for it on its own and only called after the
+// CPU check. MSVC accepts AVX2 intrinsics without this
+#if defined(GE_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define GE_TARGET_AVX2
+#endif
+
+static void accumulateScalar(const GravitySources& sources, int begin, float px, float py, float softeningSq,
+	bool maskCoincident, float& ax, float& ay) {
+
+	for (int c = begin; c < sources.count; c++) {
+		float dx = sources.x[c] - px;
+		float dy = sources.y[c] - py;
+
+		float mask = (maskCoincident && std::fabs(dx) < 0.001f && std::fabs(dy) < 0.001f) ? 0.0f : 1.0f;
+
+		float invDistance = 1.0f / std::sqrt(dx * dx + dy * dy + softeningSq + (1.0f - mask));
+		float strength = mask * sources.mass[c] * invDistance * invDistance * invDistance;
+
+		ax += dx * strength;
+		ay += dy * strength;
+	}
+}
+
+#if defined(GE_KERNEL_X86)
+
+static inline float horizontalSum(__m128 v) {
+	__m128 shuffled = _mm_movehl_ps(v, v);
+	__m128 sums = _mm_add_ps(v, shuffled);
+	shuffled = _mm_shuffle_ps(sums, sums, 1);
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+static void accumulateSSE(const GravitySources& sources, float px, float py, float softeningSq,
+	bool maskCoincident, float& ax, float& ay) {
+
+	const __m128 targetX = _mm_set1_ps(px);
+	const __m128 targetY = _mm_set1_ps(py);
+	const __m128 softening = _mm_set1_ps(softeningSq);
+	const __m128 threshold = _mm_set1_ps(0.001f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 threeHalves = _mm_set1_ps(1.5f);
+
+	__m128 sumX = _mm_setzero_ps();
+	__m128 sumY = _mm_setzero_ps();
+
+	int c = 0;
+	for (; c + 4 <= sources.count; c += 4) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(sources.x + c), targetX);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(sources.y + c), targetY);
+
+		__m128 coincident = _mm_setzero_ps();
+		if (maskCoincident) {
+			coincident = _mm_and_ps(_mm_cmplt_ps(_mm_and_ps(dx, absMask), threshold),
+				_mm_cmplt_ps(_mm_and_ps(dy, absMask), threshold));
+		}
+
+		__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), softening);
+		distanceSq = _mm_add_ps(distanceSq, _mm_and_ps(coincident, one));
+
+		// One Newton step takes the 12 bit estimate to about 22 bits
+		__m128 invDistance = _mm_rsqrt_ps(distanceSq);
+		invDistance = _mm_mul_ps(invDistance, _mm_sub_ps(threeHalves,
+			_mm_mul_ps(_mm_mul_ps(half, distanceSq), _mm_mul_ps(invDistance, invDistance))));
+		invDistance = _mm_andnot_ps(coincident, invDistance);
+
+		__m128 invDistance3 = _mm_mul_ps(_mm_mul_ps(invDistance, invDistance), invDistance);
+		__m128 strength = _mm_mul_ps(_mm_loadu_ps(sources.mass + c), invDistance3);
+
+		sumX = _mm_add_ps(sumX, _mm_mul_ps(dx, strength));
+		sumY = _mm_add_ps(sumY, _mm_mul_ps(dy, strength));
+	}
+
+	ax += horizontalSum(sumX);
+	ay += horizontalSum(sumY);
+
+	accumulateScalar(sources, c, px, py, softeningSq, maskCoincident, ax, ay);
+}
+
+GE_TARGET_AVX2 static inline float horizontalSum256(__m256 v) {
+	__m128 sums = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	__m128 shuffled = _mm_movehl_ps(sums, sums);
+	sums = _mm_add_ps(sums, shuffled);
+	shuffled = _mm_shuffle_ps(sums, sums, 1);
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+GE_TARGET_AVX2 static void accumulateAVX2(const GravitySources& sources, float px, float py, float softeningSq,
+	bool maskCoincident, float& ax, float& ay) {
+
+	const __m256 targetX = _mm256_set1_ps(px);
+	const __m256 targetY = _mm256_set1_ps(py);
+	const __m256 softening = _mm256_set1_ps(softeningSq);
+	const __m256 threshold = _mm256_set1_ps(0.001f);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 threeHalves = _mm256_set1_ps(1.5f);
+
+	__m256 sumX = _mm256_setzero_ps();
+	__m256 sumY = _mm256_setzero_ps();
+
+	int c = 0;
+	for (; c + 8 <= sources.count; c += 8) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(sources.x + c), targetX);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(sources.y + c), targetY);
+
+		__m256 coincident = _mm256_setzero_ps();
+		if (maskCoincident) {
+			coincident = _mm256_and_ps(_mm256_cmp_ps(_mm256_and_ps(dx, absMask), threshold, _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_and_ps(dy, absMask), threshold, _CMP_LT_OQ));
+		}
+
+		__m256 distanceSq = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, softening));
+		distanceSq = _mm256_add_ps(distanceSq, _mm256_and_ps(coincident, one));
+
+		__m256 invDistance = _mm256_rsqrt_ps(distanceSq);
+		invDistance = _mm256_mul_ps(invDistance, _mm256_fnmadd_ps(_mm256_mul_ps(half, distanceSq),
+			_mm256_mul_ps(invDistance, invDistance), threeHalves));
+		invDistance = _mm256_andnot_ps(coincident, invDistance);
+
+		__m256 invDistance3 = _mm256_mul_ps(_mm256_mul_ps(invDistance, invDistance), invDistance);
+		__m256 strength = _mm256_mul_ps(_mm256_loadu_ps(sources.mass + c), invDistance3);
+
+		sumX = _mm256_fmadd_ps(dx, strength, sumX);
+		sumY = _mm256_fmadd_ps(dy, strength, sumY);
+	}
+
+	ax += horizontalSum256(sumX);
+	ay += horizontalSum256(sumY);
+
+	accumulateScalar(sources, c, px, py, softeningSq, maskCoincident, ax, ay);
+}
+
+static bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+
+	__cpuid(info, 1);
+	bool hasFMA = (info[2] & (1 << 12)) != 0;
+	bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+	bool hasAVX = (info[2] & (1 << 28)) != 0;
+
+	if (!hasFMA || !hasOSXSave || !hasAVX) {
+		return false;
+	}
+
+	// The OS has to save the YMM registers on context switches
+	if ((_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	// Can run from a static initializer, before libgcc has filled in the CPU model
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+#if defined(GE_KERNEL_NEON)
+
+static void accumulateNEON(const GravitySources& sources, float px, float py, float softeningSq,
+	bool maskCoincident, float& ax, float& ay) {
+
+	const float32x4_t targetX = vdupq_n_f32(px);
+	const float32x4_t targetY = vdupq_n_f32(py);
+	const float32x4_t softening = vdupq_n_f32(softeningSq);
+	const float32x4_t threshold = vdupq_n_f32(0.001f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+
+	float32x4_t sumX = vdupq_n_f32(0.0f);
+	float32x4_t sumY = vdupq_n_f32(0.0f);
+
+	int c = 0;
+	for (; c + 4 <= sources.count; c += 4) {
+		float32x4_t dx = vsubq_f32(vld1q_f32(sources.x + c), targetX);
+		float32x4_t dy = vsubq_f32(vld1q_f32(sources.y + c), targetY);
+
+		uint32x4_t coincident = vdupq_n_u32(0);
+		if (maskCoincident) {
+			coincident = vandq_u32(vcltq_f32(vabsq_f32(dx), threshold), vcltq_f32(vabsq_f32(dy), threshold));
+		}
+
+		float32x4_t distanceSq = vfmaq_f32(vfmaq_f32(softening, dy, dy), dx, dx);
+		distanceSq = vaddq_f32(distanceSq, vreinterpretq_f32_u32(vandq_u32(coincident, vreinterpretq_u32_f32(one))));
+
+		// The NEON estimate is only 8 bits, so it takes two steps
+		float32x4_t invDistance = vrsqrteq_f32(distanceSq);
+		invDistance = vmulq_f32(invDistance, vrsqrtsq_f32(vmulq_f32(distanceSq, invDistance), invDistance));
+		invDistance = vmulq_f32(invDistance, vrsqrtsq_f32(vmulq_f32(distanceSq, invDistance), invDistance));
+		invDistance = vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(invDistance), coincident));
+
+		float32x4_t invDistance3 = vmulq_f32(vmulq_f32(invDistance, invDistance), invDistance);
+		float32x4_t strength = vmulq_f32(vld1q_f32(sources.mass + c), invDistance3);
+
+		sumX = vfmaq_f32(sumX, dx, strength);
+		sumY = vfmaq_f32(sumY, dy, strength);
+	}
+
+	ax += vaddvq_f32(sumX);
+	ay += vaddvq_f32(sumY);
+
+	accumulateScalar(sources, c, px, py, softeningSq, maskCoincident, ax, ay);
+}
+
+#endif
+
+static void accumulateFallback(const GravitySources& sources, float px, float py, float softeningSq,
+	bool maskCoincident, float& ax, float& ay) {
+
+	accumulateScalar(sources, 0, px, py, softeningSq, maskCoincident, ax, ay);
+}
+
+using AccumulateFunc = void (*)(const GravitySources&, float, float, float, bool, float&, float&);
+
+static GravityKernel::Path widestPath() {
+#if defined(GE_KERNEL_X86)
+	return cpuHasAVX2() ? GravityKernel::Path::AVX2 : GravityKernel::Path::SSE;
+#elif defined(GE_KERNEL_NEON)
+	return GravityKernel::Path::NEON;
+#else
+	return GravityKernel::Path::Scalar;
+#endif
+}
+
+static AccumulateFunc pathFunc(GravityKernel::Path path) {
+	switch (path) {
+#if defined(GE_KERNEL_X86)
+	case GravityKernel::Path::SSE:
+		return accumulateSSE;
+	case GravityKernel::Path::AVX2:
+		return accumulateAVX2;
+#endif
+#if defined(GE_KERNEL_NEON)
+	case GravityKernel::Path::NEON:
+		return accumulateNEON;
+#endif
+	default:
+		return accumulateFallback;
+	}
+}
+
+static GravityKernel::Path currentPath = widestPath();
+static AccumulateFunc currentFunc = pathFunc(currentPath);
+
+void GravityKernel::accumulate(const GravitySources& sources, float px, float py, float softeningSq,
+	bool maskCoincident, float& ax, float& ay) {
+
+	currentFunc(sources, px, py, softeningSq, maskCoincident, ax, ay);
+}
+
+GravityKernel::Path GravityKernel::path() {
+	return currentPath;
+}
+
+const char* GravityKernel::pathName(Path path) {
+	switch (path) {
+	case Path::SSE:
+		return "SSE";
+	case Path::AVX2:
+		return "AVX2";
+	case Path::NEON:
+		return "NEON";
+	default:
+		return "Scalar";
+	}
+}
+
+bool GravityKernel::isSupported(Path path) {
+	switch (path) {
+	case Path::Scalar:
+		return true;
+#if defined(GE_KERNEL_X86)
+	case Path::SSE:
+		return true;
+	case Path::AVX2:
+		return cpuHasAVX2();
+#endif
+#if defined(GE_KERNEL_NEON)
+	case Path::NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+bool GravityKernel::setPath(Path path) {
+	if (!isSupported(path)) {
+		return false;
+	}
+
+	currentPath = path;
+	currentFunc = pathFunc(path);
+	return true;
+}
@@ -1,15 +1,15 @@
 #include "Physics/morton.h"
-#include <execution>
+#include "UX/parallel_for.h"
 
 uint64_t Morton::scaleToGrid(float pos, float minVal, float maxVal) {
     if (maxVal <= minVal) return 0;
     float clamped = std::clamp(pos, minVal, maxVal);
-    float normalized = (clamped - minVal) / (maxVal - minVal);
-    return static_cast<uint64_t>(normalized * 262143.0f);
+    double normalized = static_cast<double>(clamped - minVal) / static_cast<double>(maxVal - minVal);
+    return static_cast<uint64_t>(normalized * 4294967295.0);
 }
 
 uint64_t Morton::spreadBits(uint64_t x) {
-    x &= 0x3FFFF;                     // keep only 18 bits
+    x &= 0xFFFFFFFFULL;               // keep only 32 bits
     x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
     x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
     x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
@@ -23,56 +23,130 @@ uint64_t Morton::morton2D(uint64_t x, uint64_t y) {
         | (static_cast<uint64_t>(spreadBits(y)) << 1);
 }
 
-void Morton::computeMortonKeys(std::vector<ParticlePhysics>& pParticles,
-    glm::vec3& posSize)
+void Morton::computeSortedKeys(const std::vector<ParticlePhysics>& pParticles, const glm::vec3& posSize, int threads)
 {
     const float maxX = posSize.x + std::max(posSize.z, 1e-6f);
     const float maxY = posSize.y + std::max(posSize.z, 1e-6f);
 
-    for (auto& pParticle : pParticles) {
-        uint64_t ix = scaleToGrid(pParticle.pos.x, posSize.x, maxX);
-        uint64_t iy = scaleToGrid(pParticle.pos.y, posSize.y, maxY);
-        pParticle.mortonKey = morton2D(ix, iy);
-    }
+    entries.resize(pParticles.size());
+
+    parallel_for(0, pParticles.size(), threads, [&](size_t i, int) {
+        uint64_t ix = scaleToGrid(pParticles[i].pos.x, posSize.x, maxX);
+        uint64_t iy = scaleToGrid(pParticles[i].pos.y, posSize.y, maxY);
+        entries[i] = { morton2D(ix, iy), static_cast<uint32_t>(i) };
+        });
+
+    radixSort(entries, scratch, threads);
 }
 
-void Morton::sortParticlesByMortonKey(
-    std::vector<ParticlePhysics>& pParticles,
-    std::vector<ParticleRendering>& rParticles)
+void Morton::reorderParticles(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles)
 {
-    std::vector<size_t> indices(pParticles.size());
+    const size_t count = pParticles.size();
 
-#if defined(_OPENMP)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < indices.size(); i++) {
-        indices[i] = i;
+    // Grow by copying so the default constructor doesn't hand out new particle ids
+    if (pSorted.size() < count) {
+        pSorted.insert(pSorted.end(), pParticles.begin() + pSorted.size(), pParticles.end());
+    }
+    else {
+        pSorted.resize(count);
     }
 
-#if defined(EMSCRIPTEN)
-    std::sort(indices.begin(), indices.end(),
-        [&](size_t a, size_t b) {
-            return pParticles[a].mortonKey < pParticles[b].mortonKey;
-        });
-#else
-    std::sort(std::execution::par, indices.begin(), indices.end(),
-        [&](size_t a, size_t b) {
-            return pParticles[a].mortonKey < pParticles[b].mortonKey;
+    if (rSorted.size() < count) {
+        rSorted.insert(rSorted.end(), rParticles.begin() + rSorted.size(), rParticles.end());
+    }
+    else {
+        rSorted.resize(count);
+    }
+
+    parallel_for(0, count, [&](size_t i, int) {
+        uint32_t src = entries[i].index;
+        pSorted[i] = std::move(pParticles[src]);
+        rSorted[i] = std::move(rParticles[src]);
         });
-#endif
-
-    std::vector<ParticlePhysics> pSorted(pParticles.size());
-    std::vector<ParticleRendering> rSorted(rParticles.size());
-
-#if defined(_OPENMP)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < indices.size(); i++) {
-        size_t src_idx = indices[i];
-        pSorted[i] = std::move(pParticles[src_idx]);
-        rSorted[i] = std::move(rParticles[src_idx]);
+
+    std::swap(pParticles, pSorted);
+    std::swap(rParticles, rSorted);
+}
+
+// LSD radix sort, 8 bits per pass. Every thread histograms its own contiguous chunk and scatters it in order,
+// so the sort stays stable across passes
+void Morton::radixSort(std::vector<MortonEntry>& entries, std::vector<MortonEntry>& scratch, int threads)
+{
+    constexpr int radixBits = 8;
+    constexpr int buckets = 1 << radixBits;
+    constexpr size_t minChunk = 16384;
+
+    const size_t count = entries.size();
+    if (count < 2) {
+        return;
     }
 
-    pParticles = std::move(pSorted);
-    rParticles = std::move(rSorted);
+    scratch.resize(count);
+
+    const int chunks = std::max(1, std::min(threads, static_cast<int>(count / minChunk)));
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+
+    std::vector<std::array<size_t, buckets>> offsets(chunks);
+
+    MortonEntry* src = entries.data();
+    MortonEntry* dst = scratch.data();
+
+    for (int shift = 0; shift < 64; shift += radixBits) {
+
+        parallel_for(0, static_cast<size_t>(chunks), chunks, [&](size_t c, int) {
+            std::array<size_t, buckets>& histogram = offsets[c];
+            histogram.fill(0);
+
+            size_t begin = c * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            for (size_t i = begin; i < end; i++) {
+                histogram[(src[i].key >> shift) & (buckets - 1)]++;
+            }
+            });
+
+        // All keys share this digit, nothing to move
+        bool sameDigit = false;
+        for (int b = 0; b < buckets; b++) {
+            size_t total = 0;
+            for (int c = 0; c < chunks; c++) {
+                total += offsets[c][b];
+            }
+            if (total == count) {
+                sameDigit = true;
+                break;
+            }
+            if (total != 0) {
+                break;
+            }
+        }
+
+        if (sameDigit) {
+            continue;
+        }
+
+        size_t running = 0;
+        for (int b = 0; b < buckets; b++) {
+            for (int c = 0; c < chunks; c++) {
+                size_t bucketCount = offsets[c][b];
+                offsets[c][b] = running;
+                running += bucketCount;
+            }
+        }
+
+        parallel_for(0, static_cast<size_t>(chunks), chunks, [&](size_t c, int) {
+            std::array<size_t, buckets>& offset = offsets[c];
+
+            size_t begin = c * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            for (size_t i = begin; i < end; i++) {
+                dst[offset[(src[i].key >> shift) & (buckets - 1)]++] = src[i];
+            }
+            });
+
+        std::swap(src, dst);
+    }
+
+    if (src != entries.data()) {
+        std::swap(entries, scratch);
+    }
 }
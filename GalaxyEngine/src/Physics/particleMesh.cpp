@@ -0,0 +1,470 @@
+#include "Physics/particleMesh.h"
+#include "Physics/physics.h"
+#include "UX/parallel_for.h"
+
+void TreePMSplit::setScale(float newScale) {
+
+	if (newScale == scale && !longFactor.empty()) {
+		return;
+	}
+
+	scale = newScale;
+	cutoff = cutoffInScales * scale;
+	cutoffSq = cutoff * cutoff;
+
+	const double step = static_cast<double>(cutoff) / (tableSize - 1);
+	invTableStep = static_cast<float>(1.0 / step);
+
+	longFactor.resize(tableSize);
+
+	// (erf(u) - 2u / sqrt(pi) e^-u^2) / r^3 with u = r / 2rs. Both terms cancel to third order at r = 0, where the
+	// limit is 1 / (6 sqrt(pi) rs^3)
+	const double sqrtPi = std::sqrt(3.14159265358979323846);
+	const double rs = scale;
+
+	longFactor[0] = static_cast<float>(1.0 / (6.0 * sqrtPi * rs * rs * rs));
+
+	for (int i = 1; i < tableSize; i++) {
+		double r = i * step;
+		double u = r / (2.0 * rs);
+
+		double value;
+		if (u < 1e-2) {
+			value = (1.0 - 0.6 * u * u) / (6.0 * sqrtPi * rs * rs * rs);
+		}
+		else {
+			value = (std::erf(u) - 2.0 * u / sqrtPi * std::exp(-u * u)) / (r * r * r);
+		}
+
+		longFactor[i] = static_cast<float>(value);
+	}
+}
+
+void ParticleMesh::resize(int level, glm::vec2 domain, bool isolated) {
+
+	level = std::clamp(level, 3, 12);
+
+	if (level != gridLevel || isolated != isIsolated) {
+		gridLevel = level;
+		gridSize = 1 << level;
+		isIsolated = isolated;
+		fftSize = isolated ? gridSize * 2 : gridSize;
+
+		const size_t cells = static_cast<size_t>(fftSize) * fftSize;
+		field.assign(cells, { 0.0, 0.0 });
+		accGrid.assign(cells, { 0.0f, 0.0f });
+
+		const int bits = isolated ? level + 1 : level;
+
+		bitReverse.resize(fftSize);
+		for (int i = 0; i < fftSize; i++) {
+			uint32_t reversed = 0;
+			for (int b = 0; b < bits; b++) {
+				reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+			}
+			bitReverse[i] = reversed;
+		}
+
+		roots.resize(fftSize / 2);
+		for (int i = 0; i < fftSize / 2; i++) {
+			double angle = -2.0 * 3.14159265358979323846 * i / fftSize;
+			roots[i] = { std::cos(angle), std::sin(angle) };
+		}
+
+		kernelSpectrum.clear();
+	}
+
+	domainSize = domain;
+	cellSize = domain / static_cast<float>(gridSize);
+}
+
+// First cell of the assignment stencil along one axis of the cell centered grid, and the weights from there on.
+// g is the position in cells minus half a cell
+template <int order>
+static inline int stencilAxis(float g, float* weight) {
+
+	if constexpr (order == 2) {
+		float f = std::floor(g);
+		float t = g - f;
+
+		weight[0] = 1.0f - t;
+		weight[1] = t;
+
+		return static_cast<int>(f);
+	}
+	else {
+		float f = std::floor(g + 0.5f);
+		float t = g - f;
+
+		weight[0] = 0.5f * (0.5f - t) * (0.5f - t);
+		weight[1] = 0.75f - t * t;
+		weight[2] = 0.5f * (0.5f + t) * (0.5f + t);
+
+		return static_cast<int>(f) - 1;
+	}
+}
+
+// Periodic grids wrap the stencil. Padded grids deposit on a gridSize + 4 square shifted by two cells, which holds
+// every stencil of a particle inside the domain, and clamp the rest to its border
+template <int order>
+static void depositOrder(const std::vector<ParticlePhysics>& pParticles, glm::vec2 cellSize, int gridSize, bool isolated, float* grid,
+	int64_t begin, int64_t end) {
+
+	const int side = isolated ? gridSize + 4 : gridSize;
+	const int mask = gridSize - 1;
+
+	for (int64_t i = begin; i < end; i++) {
+		float wx[order];
+		float wy[order];
+
+		int x0 = stencilAxis<order>(pParticles[i].pos.x / cellSize.x - 0.5f, wx);
+		int y0 = stencilAxis<order>(pParticles[i].pos.y / cellSize.y - 0.5f, wy);
+
+		int xs[order];
+		int ys[order];
+
+		if (isolated) {
+			x0 = std::clamp(x0 + 2, 0, side - order);
+			y0 = std::clamp(y0 + 2, 0, side - order);
+		}
+
+		for (int k = 0; k < order; k++) {
+			xs[k] = isolated ? x0 + k : (x0 + k) & mask;
+			ys[k] = isolated ? y0 + k : (y0 + k) & mask;
+		}
+
+		float m = pParticles[i].mass;
+
+		for (int ky = 0; ky < order; ky++) {
+			float* row = grid + static_cast<size_t>(ys[ky]) * side;
+			float rowMass = m * wy[ky];
+
+			for (int kx = 0; kx < order; kx++) {
+				row[xs[kx]] += rowMass * wx[kx];
+			}
+		}
+	}
+}
+
+template <int order>
+static glm::vec2 interpolateOrder(const std::vector<glm::vec2>& accGrid, glm::vec2 pos, glm::vec2 cellSize, int fftSize) {
+
+	const int mask = fftSize - 1;
+
+	float wx[order];
+	float wy[order];
+
+	int x0 = stencilAxis<order>(pos.x / cellSize.x - 0.5f, wx);
+	int y0 = stencilAxis<order>(pos.y / cellSize.y - 0.5f, wy);
+
+	glm::vec2 acc = { 0.0f, 0.0f };
+
+	for (int ky = 0; ky < order; ky++) {
+		const glm::vec2* row = accGrid.data() + static_cast<size_t>((y0 + ky) & mask) * fftSize;
+
+		glm::vec2 rowAcc = { 0.0f, 0.0f };
+		for (int kx = 0; kx < order; kx++) {
+			rowAcc += row[(x0 + kx) & mask] * wx[kx];
+		}
+
+		acc += rowAcc * wy[ky];
+	}
+
+	return acc;
+}
+
+void ParticleMesh::deposit(const std::vector<ParticlePhysics>& pParticles) {
+
+	const int side = isIsolated ? gridSize + 4 : gridSize;
+	const int offset = isIsolated ? 2 : 0;
+	const int fftMask = fftSize - 1;
+
+	const size_t sideCells = static_cast<size_t>(side) * side;
+	const int64_t count = static_cast<int64_t>(pParticles.size());
+
+	const int threads = threadPool.size();
+
+	threadMass.resize(sideCells * threads);
+
+	// One grid per slice. Contiguous slices keep each grid's writes local to the cells its particles sit in when the
+	// particles are sorted
+	parallel_for(0, static_cast<size_t>(threads), threads, [&](size_t slice, int) {
+		float* grid = threadMass.data() + sideCells * slice;
+		std::fill(grid, grid + sideCells, 0.0f);
+
+		int64_t begin = count * static_cast<int64_t>(slice) / threads;
+		int64_t end = count * static_cast<int64_t>(slice + 1) / threads;
+
+		if (assignmentOrder == 3) {
+			depositOrder<3>(pParticles, cellSize, gridSize, isIsolated, grid, begin, end);
+		}
+		else {
+			depositOrder<2>(pParticles, cellSize, gridSize, isIsolated, grid, begin, end);
+		}
+		});
+
+	if (isIsolated) {
+		std::fill(field.begin(), field.end(), std::complex<double>(0.0, 0.0));
+	}
+
+	parallel_for(0, static_cast<size_t>(side), [&](size_t y, int) {
+		size_t fieldRow = static_cast<size_t>((static_cast<int>(y) - offset) & fftMask) * fftSize;
+
+		for (int x = 0; x < side; x++) {
+			size_t c = static_cast<size_t>(y) * side + x;
+
+			double total = 0.0;
+			for (int t = 0; t < threads; t++) {
+				total += threadMass[sideCells * t + c];
+			}
+
+			field[fieldRow + ((x - offset) & fftMask)] = { total, 0.0 };
+		}
+		});
+}
+
+void ParticleMesh::fftLine(std::complex<double>* data, size_t stride, bool inverse, std::complex<double>* scratch) const {
+
+	const int n = fftSize;
+
+	for (int i = 0; i < n; i++) {
+		scratch[bitReverse[i]] = data[i * stride];
+	}
+
+	for (int length = 2; length <= n; length <<= 1) {
+		const int half = length >> 1;
+		const int rootStep = n / length;
+
+		for (int start = 0; start < n; start += length) {
+			for (int k = 0; k < half; k++) {
+				std::complex<double> w = roots[k * rootStep];
+				if (inverse) {
+					w = std::conj(w);
+				}
+
+				std::complex<double> a = scratch[start + k];
+				std::complex<double> b = scratch[start + k + half] * w;
+
+				scratch[start + k] = a + b;
+				scratch[start + k + half] = a - b;
+			}
+		}
+	}
+
+	for (int i = 0; i < n; i++) {
+		data[i * stride] = scratch[i];
+	}
+}
+
+void ParticleMesh::fft2D(std::complex<double>* data, bool inverse) {
+
+	const int n = fftSize;
+
+	const int thread_count = clamp_thread_count(static_cast<size_t>(n), threadPool.size());
+
+	fftScratch.resize(static_cast<size_t>(thread_count));
+	for (std::vector<std::complex<double>>& scratch : fftScratch) {
+		scratch.resize(n);
+	}
+
+	parallel_for(0, static_cast<size_t>(n), thread_count, [&](size_t y, int tid) {
+		fftLine(data + y * n, 1, inverse, fftScratch[tid].data());
+		});
+
+	parallel_for(0, static_cast<size_t>(n), thread_count, [&](size_t x, int tid) {
+		fftLine(data + x, n, inverse, fftScratch[tid].data());
+		});
+}
+
+void ParticleMesh::solvePeriodic(double G, bool isLongRange, float softening) {
+
+	const int n = gridSize;
+	const double pi = 3.14159265358979323846;
+
+	const double kUnitX = 2.0 * pi / domainSize.x;
+	const double kUnitY = 2.0 * pi / domainSize.y;
+	const double rs = split.scale;
+	const double epsilon = softening;
+
+	fft2D(field.data(), false);
+
+	// acc_k = -i k phi_k with phi_k = -G rho_k 2 pi erfc(k rs) / k for the long range part, or 2 pi e^(-k epsilon) / k
+	// for the Plummer softened potential. Dividing by the window twice undoes the smoothing of the deposit and of the
+	// interpolation. Both real components go back in one transform as ax + i ay
+	parallel_for(0, static_cast<size_t>(n), [&](size_t row, int) {
+		const int y = static_cast<int>(row);
+		int my = y < n / 2 ? y : y - n;
+		double ky = my * kUnitY;
+
+		double sy = 0.5 * ky * domainSize.y / n;
+		double sincY = sy != 0.0 ? std::sin(sy) / sy : 1.0;
+
+		for (int x = 0; x < n; x++) {
+			int mx = x < n / 2 ? x : x - n;
+			double kx = mx * kUnitX;
+
+			std::complex<double>& cell = field[static_cast<size_t>(y) * n + x];
+
+			double kSq = kx * kx + ky * ky;
+			if (kSq == 0.0) {
+				cell = { 0.0, 0.0 };
+				continue;
+			}
+
+			double sx = 0.5 * kx * domainSize.x / n;
+			double sincX = sx != 0.0 ? std::sin(sx) / sx : 1.0;
+
+			double window = std::pow(sincX * sincY, assignmentOrder);
+
+			double k = std::sqrt(kSq);
+			double filter = isLongRange ? std::erfc(k * rs) : std::exp(-k * epsilon);
+			double green = G * 2.0 * pi * filter / (k * window * window);
+
+			// The Nyquist row and column have no sign to differentiate with, they're left out
+			double dx = mx == -n / 2 ? 0.0 : kx;
+			double dy = my == -n / 2 ? 0.0 : ky;
+
+			std::complex<double> rho = cell;
+			std::complex<double> ax = std::complex<double>(0.0, dx * green) * rho;
+			std::complex<double> ay = std::complex<double>(0.0, dy * green) * rho;
+
+			cell = ax + std::complex<double>(0.0, 1.0) * ay;
+		}
+		});
+
+	fft2D(field.data(), true);
+
+	storeAcceleration(1.0 / (static_cast<double>(domainSize.x) * domainSize.y));
+}
+
+void ParticleMesh::solveIsolated(double G, float softening) {
+
+	const int n = fftSize;
+	const size_t cells = static_cast<size_t>(n) * n;
+
+	// The force of a unit mass at every offset the padded grid can hold, -d / (r^2 + epsilon^2)^1.5 for the offset d
+	// from the source. Being real, fx + i fy convolves both components at once
+	if (kernelSpectrum.size() != cells || kernelCellSize != cellSize || kernelSoftening != softening) {
+		kernelSpectrum.resize(cells);
+
+		const double epsilonSq = static_cast<double>(softening) * softening;
+
+		parallel_for(0, static_cast<size_t>(n), [&](size_t row, int) {
+			const int y = static_cast<int>(row);
+			double dy = (y < n / 2 ? y : y - n) * static_cast<double>(cellSize.y);
+
+			for (int x = 0; x < n; x++) {
+				double dx = (x < n / 2 ? x : x - n) * static_cast<double>(cellSize.x);
+
+				double rSq = dx * dx + dy * dy;
+				std::complex<double>& value = kernelSpectrum[static_cast<size_t>(y) * n + x];
+
+				if (rSq == 0.0) {
+					value = { 0.0, 0.0 };
+					continue;
+				}
+
+				double softenedSq = rSq + epsilonSq;
+				double invCube = 1.0 / (softenedSq * std::sqrt(softenedSq));
+
+				value = { -dx * invCube, -dy * invCube };
+			}
+			});
+
+		fft2D(kernelSpectrum.data(), false);
+
+		kernelCellSize = cellSize;
+		kernelSoftening = softening;
+	}
+
+	fft2D(field.data(), false);
+
+	parallel_for(0, cells, [&](size_t c, int) {
+		field[c] *= kernelSpectrum[c] * G;
+		});
+
+	fft2D(field.data(), true);
+
+	storeAcceleration(1.0 / static_cast<double>(cells));
+}
+
+void ParticleMesh::storeAcceleration(double normalization) {
+
+	parallel_for(0, field.size(), [&](size_t c, int) {
+		accGrid[c] = glm::vec2(field[c].real() * normalization, field[c].imag() * normalization);
+		});
+}
+
+glm::vec2 ParticleMesh::interpolate(glm::vec2 pos) const {
+
+	if (gridSize == 0) {
+		return { 0.0f, 0.0f };
+	}
+
+	if (assignmentOrder == 3) {
+		return interpolateOrder<3>(accGrid, pos, cellSize, fftSize);
+	}
+
+	return interpolateOrder<2>(accGrid, pos, cellSize, fftSize);
+}
+
+void ParticleMesh::applyAcceleration(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	const UpdateVariables& myVar, bool isAdding) const {
+
+	parallel_for(0, pParticles.size(), [&](size_t i, int) {
+		ParticlePhysics& pParticle = pParticles[i];
+
+		if (Physics::isGravityFrozen(rParticles[i], myVar)) {
+			if (!isAdding) {
+				pParticle.acc = { 0.0f, 0.0f };
+			}
+			return;
+		}
+
+		glm::vec2 acc = interpolate(pParticle.pos);
+		pParticle.acc = isAdding ? pParticle.acc + acc : acc;
+		});
+}
+
+void ParticleMesh::prepareSplit(const UpdateVariables& myVar) {
+
+	assignmentOrder = myVar.isPMTSCEnabled ? 3 : 2;
+
+	resize(myVar.pmGridLevel, myVar.domainSize, false);
+
+	// 1.25 cells keeps the mesh force isotropic. The cutoff can't reach past half the box or the nearest image
+	// walk would miss pairs
+	float scale = 1.25f * std::max(cellSize.x, cellSize.y);
+	scale = std::min(scale, 0.5f * std::min(domainSize.x, domainSize.y) / TreePMSplit::cutoffInScales);
+
+	split.setScale(scale);
+}
+
+void ParticleMesh::computeLongRange(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	UpdateVariables& myVar) {
+
+	deposit(pParticles);
+
+	solvePeriodic(myVar.G, true, 0.0f);
+
+	applyAcceleration(pParticles, rParticles, myVar, true);
+}
+
+void ParticleMesh::computeGravity(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	UpdateVariables& myVar) {
+
+	assignmentOrder = myVar.isPMTSCEnabled ? 3 : 2;
+
+	resize(myVar.pmGridLevel, myVar.domainSize, !myVar.isPeriodicBoundaryEnabled);
+
+	deposit(pParticles);
+
+	if (isIsolated) {
+		solveIsolated(myVar.G, myVar.softening);
+	}
+	else {
+		solvePeriodic(myVar.G, false, myVar.softening);
+	}
+
+	applyAcceleration(pParticles, rParticles, myVar, false);
+}
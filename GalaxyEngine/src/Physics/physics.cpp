@@ -1,78 +1,455 @@
 #include "Physics/physics.h"
+#include "Physics/gravityKernel.h"
+#include "Physics/materialsSPH.h"
+#include "Physics/particleMesh.h"
+#include "UX/parallel_for.h"
 
-glm::vec2 Physics::calculateForceFromGrid(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, ParticlePhysics& pParticle) {
+// Far field correction from a node's quadrupole. d points from the particle to the node's center of mass and
+// invDistance is the softened 1/|d|. Returns the extra force for a particle whose G * mass is gMass
+static inline glm::vec2 quadrupoleForce(const GravityQuadrupole& q, glm::vec2 d, float invDistance, float gMass) {
+	float invDistanceSq = invDistance * invDistance;
+	float invDistance5 = invDistanceSq * invDistanceSq * invDistance;
+
+	glm::vec2 qd = { q.xx * d.x + q.xy * d.y, q.xy * d.x + q.yy * d.y };
+	float dqd = d.x * qd.x + d.y * qd.y;
+
+	return gMass * invDistance5 * (2.5f * dqd * invDistanceSq * d - qd);
+}
+
+// Opening test of the walks. Without a tolerance it's the usual size / distance < theta. With one, a node is taken when
+// the error of its monopole, about G * M * size^2 / distance^4, stays under accTolerance * G, which is the wanted
+// fraction of the particle's last acceleration. Dense cores, where accelerations are large, then take far nodes early
+// while the outskirts open more of them. The test is capped at theta = 1 so a particle never takes a node it sits in
+static inline bool acceptNode(float sizeSq, float nodeMass, float distanceSq, float thetaSq, float accTolerance) {
+
+	if (accTolerance > 0.0f) {
+		return sizeSq < distanceSq && nodeMass * sizeSq < accTolerance * distanceSq * distanceSq;
+	}
+
+	return sizeSq < thetaSq * distanceSq;
+}
+
+// accTolerance for a particle whose last acceleration was prevAcc. 0 falls back to theta, which is also what particles
+// without a last acceleration use, like the ones spawned this frame
+static inline float openingTolerance(const UpdateVariables& myVar, float prevAcc) {
+
+	if (!myVar.isRelativeOpeningEnabled || prevAcc <= 0.0f || myVar.G <= 0.0) {
+		return 0.0f;
+	}
+
+	return myVar.openingAccuracy * prevAcc / static_cast<float>(myVar.G);
+}
+
+// Shared tree walk. positionAt(i) returns the position of particle i, so the same walk runs on the particles the tree
+// was built from or on a probe outside of it. The short range version for TreePM skips every subtree that lies past the split cutoff and
+// takes the mesh's long range part out of each pair force. interactions counts the nodes and particles taken.
+// treeNodes can point to a copy of gravityNodes if myVar has quadrupoles off, those come from gravityNodeQuads
+template <bool isShortRange = false, typename PositionAt>
+static glm::vec2 walkGrid(PositionAt positionAt, UpdateVariables& myVar, glm::vec2 pos, float mass, float accTolerance,
+	uint32_t& interactions, const TreePMSplit* split = nullptr, const std::vector<GravityNode>* treeNodes = &gravityNodes) {
 
 	glm::vec2 totalForce = { 0.0f, 0.0f };
 
 	uint32_t gridIdx = 0;
-	const uint32_t nodeCount = static_cast<uint32_t>(globalNodes.size());
+	const uint32_t nodeCount = static_cast<uint32_t>(treeNodes->size());
+	const GravityNode* nodes = treeNodes->data();
+
+	const float thetaSq = myVar.theta * myVar.theta;
+	const float softeningSq = myVar.softening * myVar.softening;
+	const bool useQuadrupole = myVar.isQuadrupoleEnabled;
 
 	while (gridIdx < nodeCount) {
-		Node& grid = globalNodes[gridIdx];
+		const GravityNode& grid = nodes[gridIdx];
+
+		const bool isLeaf = grid.isLeaf();
+		const uint32_t skip = isLeaf ? 1 : grid.nextOrParticle + 1;
 
 		if (grid.gridMass <= 0.0f) {
-			gridIdx += grid.next + 1;
+			gridIdx += skip;
 			continue;
 		}
 
-		glm::vec2 d = grid.centerOfMass - pParticle.pos;
+		glm::vec2 d = grid.centerOfMass - pos;
 
 		if (myVar.isPeriodicBoundaryEnabled) {
 			d.x -= myVar.domainSize.x * ((d.x > myVar.halfDomainWidth) - (d.x < -myVar.halfDomainWidth));
 			d.y -= myVar.domainSize.y * ((d.y > myVar.halfDomainHeight) - (d.y < -myVar.halfDomainHeight));
 		}
 
-		float distanceSq = d.x * d.x + d.y * d.y + myVar.softening * myVar.softening;
+		float distanceSq = d.x * d.x + d.y * d.y + softeningSq;
 
-		bool isSubgridsEmty = true;
-		for (int i = 0; i < 2; ++i) {
-			for (int j = 0; j < 2; ++j) {
-				uint32_t idx = grid.subGrids[i][j];
-				if (idx != UINT32_MAX) {
-					isSubgridsEmty = false;
-					break;
-				}
+		float pairDistance = 0.0f;
+		if constexpr (isShortRange) {
+			pairDistance = sqrt(d.x * d.x + d.y * d.y);
+
+			// The center of mass is inside the node's box, so nothing in it is further than the box diagonal
+			float extent = sqrt(2.0f * grid.sizeSq);
+			if (pairDistance - extent > split->cutoff) {
+				gridIdx += skip;
+				continue;
 			}
-			if (!isSubgridsEmty) break;
 		}
 
-		if ((grid.size * grid.size < (myVar.theta * myVar.theta) * distanceSq) || isSubgridsEmty) {
+		if (isLeaf || acceptNode(grid.sizeSq, grid.gridMass, distanceSq, thetaSq, accTolerance)) {
 
-			if ((grid.endIndex - grid.startIndex) == 1 &&
-				fabs(pParticles[grid.startIndex].pos.x - pParticle.pos.x) < 0.001f &&
-				fabs(pParticles[grid.startIndex].pos.y - pParticle.pos.y) < 0.001f) {
+			if (isLeaf && grid.nextOrParticle != UINT32_MAX) {
+				glm::vec2 leafPos = positionAt(grid.nextOrParticle);
 
-				gridIdx += grid.next + 1;
-				continue;
+				if (fabs(leafPos.x - pos.x) < 0.001f && fabs(leafPos.y - pos.y) < 0.001f) {
+					gridIdx += skip;
+					continue;
+				}
 			}
 
+			interactions++;
+
 			float invDistance = 1.0f / sqrt(distanceSq);
-			float forceMagnitude = static_cast<float>(myVar.G) * pParticle.mass * grid.gridMass
+			float forceMagnitude = static_cast<float>(myVar.G) * mass * grid.gridMass
 				* invDistance * invDistance * invDistance;
+
+			if constexpr (isShortRange) {
+				forceMagnitude = pairDistance < split->cutoff
+					? forceMagnitude - static_cast<float>(myVar.G) * mass * grid.gridMass * split->longRange(pairDistance)
+					: 0.0f;
+			}
+
 				totalForce += d * forceMagnitude;
 
-			if (myVar.isTempEnabled) {
-				uint32_t count = grid.endIndex - grid.startIndex;
-				if (count > 0) {
-					float gridAverageTemp = grid.gridTemp / static_cast<float>(count);
-					float temperatureDifference = gridAverageTemp - pParticle.temp;
+			// Quadrupoles only matter for far nodes, which the short range walk never accepts
+			if (!isShortRange && useQuadrupole) {
+				totalForce += quadrupoleForce(gravityNodeQuads[gridIdx], d, invDistance, static_cast<float>(myVar.G) * mass);
+			}
+
+			gridIdx += skip;
+		}
+		else {
+			++gridIdx;
+		}
+	}
+
+	return totalForce;
+}
+
+glm::vec2 Physics::calculateForceFromGrid(std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar, ParticlePhysics& pParticle) {
+
+	uint32_t interactions = 0;
+
+	return walkGrid([&pParticles](uint32_t i) { return pParticles[i].pos; }, myVar, pParticle.pos, pParticle.mass,
+		openingTolerance(myVar, glm::length(pParticle.acc)), interactions);
+}
 
-					float distance = sqrt(distanceSq);
-					if (distance > 1e-8f) {
-						float heatTransfer = myVar.globalHeatConductivity * temperatureDifference / distance;
-						pParticle.temp += heatTransfer * myVar.timeFactor;
+glm::vec2 Physics::calculateForceFromGrid(const std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar,
+	uint32_t particleIndex) {
+
+	const ParticlePhysics& pParticle = pParticles[particleIndex];
+
+	uint32_t& interactions = particleInteractions[particleIndex];
+	interactions = 0;
+
+	return walkGrid([&pParticles](uint32_t i) { return pParticles[i].pos; }, myVar, pParticle.pos, pParticle.mass,
+		openingTolerance(myVar, glm::length(pParticle.acc)), interactions);
+}
+
+glm::vec2 Physics::calculateShortRangeForce(const std::vector<ParticlePhysics>& pParticles, UpdateVariables& myVar,
+	uint32_t particleIndex, const TreePMSplit& split) {
+
+	const ParticlePhysics& pParticle = pParticles[particleIndex];
+
+	uint32_t& interactions = particleInteractions[particleIndex];
+	interactions = 0;
+
+	return walkGrid<true>([&pParticles](uint32_t i) { return pParticles[i].pos; }, myVar, pParticle.pos,
+		pParticle.mass, openingTolerance(myVar, glm::length(pParticle.acc)), interactions, &split);
+}
+
+glm::vec2 Physics::calculateForceFromNodes(const std::vector<GravityNode>& nodes, UpdateVariables& myVar, glm::vec2 pos,
+	float mass) {
+
+	// The probe isn't in the tree, so no leaf is ever itself
+	auto outsidePosition = [](uint32_t) { return glm::vec2(std::numeric_limits<float>::infinity()); };
+
+	uint32_t interactions = 0;
+
+	return walkGrid(outsidePosition, myVar, pos, mass, 0.0f, interactions, nullptr, &nodes);
+}
+
+glm::vec2 Physics::calculateForceFromNodes(const std::vector<GravityNode>& nodes, UpdateVariables& myVar,
+	const std::vector<ParticlePhysics>& pParticles, uint32_t particleIndex) {
+
+	uint32_t interactions = 0;
+
+	return walkGrid([&pParticles](uint32_t i) { return pParticles[i].pos; }, myVar, pParticles[particleIndex].pos,
+		pParticles[particleIndex].mass, 0.0f, interactions, nullptr, &nodes);
+}
+
+void Physics::buildGravityGroups() {
+
+	gravityGroups.clear();
+
+	uint32_t gridIdx = 0;
+	const uint32_t nodeCount = static_cast<uint32_t>(globalNodes.size());
+
+	while (gridIdx < nodeCount) {
+		const Node& grid = globalNodes[gridIdx];
+
+		uint32_t count = grid.endIndex - grid.startIndex;
+
+		if (count <= groupMaxParticles || !grid.hasChildren()) {
+			if (count > 0) {
+				gravityGroups.push_back({ grid.startIndex, grid.endIndex });
+			}
+
+			gridIdx += grid.next + 1;
+		}
+		else {
+			++gridIdx;
+		}
+	}
+}
+
+// Walks the tree once against the group's bounding box and fills lists with what its particles interact with. The
+// gravity walk gathers masses (and quadrupoles) and the heat pass gathers temperatures from temps, with the same
+// opening rules
+template <bool isHeat>
+static void gatherGroupLists(const std::vector<ParticlePhysics>& pParticles, const float* temps, const UpdateVariables& myVar,
+	const GravityGroup& group, float accTolerance, GravityInteractionLists& lists) {
+
+	lists.clear();
+
+	glm::vec2 groupMin = pParticles[group.startIndex].pos;
+	glm::vec2 groupMax = groupMin;
+
+	for (uint32_t i = group.startIndex + 1; i < group.endIndex; i++) {
+		groupMin = glm::min(groupMin, pParticles[i].pos);
+		groupMax = glm::max(groupMax, pParticles[i].pos);
+	}
+
+	const glm::vec2 groupCenter = (groupMin + groupMax) * 0.5f;
+	const glm::vec2 groupHalfSize = (groupMax - groupMin) * 0.5f;
+
+	const float thetaSq = myVar.theta * myVar.theta;
+	const float softeningSq = myVar.softening * myVar.softening;
+	const bool useQuadrupole = !isHeat && myVar.isQuadrupoleEnabled;
+
+	const uint32_t nodeCount = static_cast<uint32_t>(gravityNodes.size());
+	const GravityNode* nodes = gravityNodes.data();
+
+	uint32_t gridIdx = 0;
+
+	while (gridIdx < nodeCount) {
+		const GravityNode& grid = nodes[gridIdx];
+
+		const bool isLeaf = grid.isLeaf();
+		const uint32_t skip = isLeaf ? 1 : grid.nextOrParticle + 1;
+
+		if (grid.gridMass <= 0.0f) {
+			gridIdx += skip;
+			continue;
+		}
+
+		glm::vec2 d = grid.centerOfMass - groupCenter;
+
+		if (myVar.isPeriodicBoundaryEnabled) {
+			d.x -= myVar.domainSize.x * ((d.x > myVar.halfDomainWidth) - (d.x < -myVar.halfDomainWidth));
+			d.y -= myVar.domainSize.y * ((d.y > myVar.halfDomainHeight) - (d.y < -myVar.halfDomainHeight));
+		}
+
+		// Periodic image of the node that sits next to the group
+		const glm::vec2 imageShift = groupCenter + d - grid.centerOfMass;
+
+		// Closest any particle of the group can be to the node's center of mass
+		float gapX = std::max(std::fabs(d.x) - groupHalfSize.x, 0.0f);
+		float gapY = std::max(std::fabs(d.y) - groupHalfSize.y, 0.0f);
+		float minDistanceSq = gapX * gapX + gapY * gapY + softeningSq;
+
+		bool acceptCell = !isLeaf && acceptNode(grid.sizeSq, grid.gridMass, minDistanceSq, thetaSq, accTolerance);
+
+		if (isLeaf && grid.nextOrParticle == UINT32_MAX) {
+			const Node& leaf = globalNodes[gridIdx];
+
+			// Same test as for internal nodes, leaf particles sit within leaf.size of each other
+			acceptCell = acceptNode(leaf.size * leaf.size, grid.gridMass, minDistanceSq, thetaSq, accTolerance);
+
+			if (!acceptCell) {
+				for (uint32_t j = leaf.startIndex; j < leaf.endIndex; j++) {
+					glm::vec2 pos = pParticles[j].pos + imageShift;
+
+					lists.partX.push_back(pos.x);
+					lists.partY.push_back(pos.y);
+
+					if constexpr (isHeat) {
+						lists.partTemp.push_back(temps[j]);
+					}
+					else {
+						lists.partMass.push_back(pParticles[j].mass);
 					}
 				}
 			}
+		}
+		else if (isLeaf) {
+			glm::vec2 pos = grid.centerOfMass + imageShift;
 
-			gridIdx += grid.next + 1;
+			lists.partX.push_back(pos.x);
+			lists.partY.push_back(pos.y);
+
+			if constexpr (isHeat) {
+				lists.partTemp.push_back(gravityNodeTemps[gridIdx]);
+			}
+			else {
+				lists.partMass.push_back(grid.gridMass);
+			}
+		}
+
+		if (acceptCell) {
+			glm::vec2 pos = grid.centerOfMass + imageShift;
+
+			lists.cellX.push_back(pos.x);
+			lists.cellY.push_back(pos.y);
+
+			if constexpr (isHeat) {
+				lists.cellTemp.push_back(gravityNodeTemps[gridIdx]);
+			}
+			else {
+				lists.cellMass.push_back(grid.gridMass);
+			}
+
+			if (useQuadrupole) {
+				const GravityQuadrupole& q = gravityNodeQuads[gridIdx];
+
+				lists.cellQXX.push_back(q.xx);
+				lists.cellQXY.push_back(q.xy);
+				lists.cellQYY.push_back(q.yy);
+			}
+		}
+
+		if (isLeaf || acceptCell) {
+			gridIdx += skip;
 		}
 		else {
 			++gridIdx;
 		}
 	}
+}
 
-	return totalForce;
+void Physics::calculateGroupForces(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	UpdateVariables& myVar, const GravityGroup& group, GravityInteractionLists& lists) {
+
+	// The least accelerated particle of the group sets the tolerance, so the shared lists are good enough for all of
+	// them. Their acc is still last step's, the group only overwrites it below
+	float minPrevAcc = 0.0f;
+	if (myVar.isRelativeOpeningEnabled) {
+		minPrevAcc = glm::length(pParticles[group.startIndex].acc);
+		for (uint32_t i = group.startIndex + 1; i < group.endIndex; i++) {
+			minPrevAcc = std::min(minPrevAcc, glm::length(pParticles[i].acc));
+		}
+	}
+
+	gatherGroupLists<false>(pParticles, nullptr, myVar, group, openingTolerance(myVar, minPrevAcc), lists);
+
+	const float G = static_cast<float>(myVar.G);
+	const float softeningSq = myVar.softening * myVar.softening;
+	const bool useQuadrupole = myVar.isQuadrupoleEnabled;
+
+	const int cellCount = static_cast<int>(lists.cellX.size());
+	const int partCount = static_cast<int>(lists.partX.size());
+
+	const GravitySources cells = { lists.cellX.data(), lists.cellY.data(), lists.cellMass.data(), cellCount };
+	const GravitySources particles = { lists.partX.data(), lists.partY.data(), lists.partMass.data(), partCount };
+
+	const float* cellX = lists.cellX.data();
+	const float* cellY = lists.cellY.data();
+	const float* cellQXX = lists.cellQXX.data();
+	const float* cellQXY = lists.cellQXY.data();
+	const float* cellQYY = lists.cellQYY.data();
+
+	for (uint32_t i = group.startIndex; i < group.endIndex; i++) {
+		if (isGravityFrozen(rParticles[i], myVar)) {
+			pParticles[i].acc = { 0.0f, 0.0f };
+			continue;
+		}
+
+		const float px = pParticles[i].pos.x;
+		const float py = pParticles[i].pos.y;
+
+		float ax = 0.0f;
+		float ay = 0.0f;
+
+		GravityKernel::accumulate(cells, px, py, softeningSq, false, ax, ay);
+
+		if (useQuadrupole) {
+#pragma omp simd reduction(+:ax, ay)
+			for (int c = 0; c < cellCount; c++) {
+				float dx = cellX[c] - px;
+				float dy = cellY[c] - py;
+				float invDistance = 1.0f / std::sqrt(dx * dx + dy * dy + softeningSq);
+				float invDistanceSq = invDistance * invDistance;
+				float invDistance5 = invDistanceSq * invDistanceSq * invDistance;
+
+				float qdx = cellQXX[c] * dx + cellQXY[c] * dy;
+				float qdy = cellQXY[c] * dx + cellQYY[c] * dy;
+				float dqd = dx * qdx + dy * qdy;
+
+				ax += invDistance5 * (2.5f * dqd * invDistanceSq * dx - qdx);
+				ay += invDistance5 * (2.5f * dqd * invDistanceSq * dy - qdy);
+			}
+		}
+
+		// Masks the particle itself and anything sitting on top of it, like the per particle walk does
+		GravityKernel::accumulate(particles, px, py, softeningSq, true, ax, ay);
+
+		pParticles[i].acc = glm::vec2(ax, ay) * G;
+		particleInteractions[i] = static_cast<uint32_t>(cellCount + partCount);
+	}
+}
+
+// sum((sourceTemp - temp) / r) over a list, with the same softening and coincident mask as the gravity kernel
+static inline float sumHeat(const float* x, const float* y, const float* sourceTemp, int count, float px, float py,
+	float temp, float softeningSq, bool maskCoincident) {
+
+	float heat = 0.0f;
+
+#pragma omp simd reduction(+:heat)
+	for (int c = 0; c < count; c++) {
+		float dx = x[c] - px;
+		float dy = y[c] - py;
+
+		float mask = (maskCoincident && std::fabs(dx) < 0.001f && std::fabs(dy) < 0.001f) ? 0.0f : 1.0f;
+
+		float invDistance = 1.0f / std::sqrt(dx * dx + dy * dy + softeningSq + (1.0f - mask));
+		heat += mask * (sourceTemp[c] - temp) * invDistance;
+	}
+
+	return heat;
+}
+
+void Physics::conductHeat(std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	const std::vector<float>& temps, const UpdateVariables& myVar, const GravityGroup& group,
+	GravityInteractionLists& lists, float heatStep) {
+
+	gatherGroupLists<true>(pParticles, temps.data(), myVar, group, 0.0f, lists);
+
+	const float softeningSq = myVar.softening * myVar.softening;
+	const float heatFactor = myVar.globalHeatConductivity * heatStep;
+
+	const int cellCount = static_cast<int>(lists.cellX.size());
+	const int partCount = static_cast<int>(lists.partX.size());
+
+	for (uint32_t i = group.startIndex; i < group.endIndex; i++) {
+		if (isGravityFrozen(rParticles[i], myVar)) {
+			continue;
+		}
+
+		const float px = pParticles[i].pos.x;
+		const float py = pParticles[i].pos.y;
+		const float temp = temps[i];
+
+		float heat = sumHeat(lists.cellX.data(), lists.cellY.data(), lists.cellTemp.data(), cellCount, px, py, temp,
+			softeningSq, false);
+		heat += sumHeat(lists.partX.data(), lists.partY.data(), lists.partTemp.data(), partCount, px, py, temp,
+			softeningSq, true);
+
+		pParticles[i].temp = temp + heat * heatFactor;
+	}
 }
 
 void Physics::temperatureCalculation(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar) {
@@ -165,7 +542,7 @@ void Physics::temperatureCalculation(std::vector<ParticlePhysics>& pParticles, s
 void Physics::createConstraints(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, bool& constraintCreateSpecialFlag,
 	UpdateVariables& myVar) {
 
-	bool shouldCreateConstraints = IO::shortcutPress(KEY_P) || myVar.constraintAllSolids || constraintCreateSpecialFlag || myVar.constraintSelected;
+	bool shouldCreateConstraints = myVar.constraintAllSolids || constraintCreateSpecialFlag || myVar.constraintSelected;
 
 	for (size_t i = 0; i < pParticles.size(); i++) {
 		ParticlePhysics& pi = pParticles[i];
@@ -271,6 +648,17 @@ void Physics::createConstraints(std::vector<ParticlePhysics>& pParticles, std::v
 	myVar.constraintSelected = false;
 }
 
+// Constraints sharing a particle run on different pool threads, so its position and acceleration are only touched
+// through these in the constraint loop. OpenMP atomics don't cover pool threads, and the web build has no OpenMP
+static inline glm::vec2 loadShared(glm::vec2& v) {
+	return { std::atomic_ref<float>(v.x).load(std::memory_order_relaxed), std::atomic_ref<float>(v.y).load(std::memory_order_relaxed) };
+}
+
+static inline void addShared(glm::vec2& v, glm::vec2 value) {
+	std::atomic_ref<float>(v.x).fetch_add(value.x, std::memory_order_relaxed);
+	std::atomic_ref<float>(v.y).fetch_add(value.y, std::memory_order_relaxed);
+}
+
 void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar) {
 
 	if (myVar.deleteAllConstraints) {
@@ -322,8 +710,7 @@ void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<
 
 		for (int step = 0; step < substeps; step++) {
 
-#pragma omp parallel for schedule(dynamic)
-			for (size_t i = 0; i < particleConstraints.size(); i++) {
+			parallel_for(0, particleConstraints.size(), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1, [&](size_t i, int) {
 				auto& constraint = particleConstraints[i];
 
 				auto it1 = NeighborSearch::idToIndex.find(constraint.id1);
@@ -331,7 +718,7 @@ void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<
 				if (it1 == NeighborSearch::idToIndex.end() ||
 					it2 == NeighborSearch::idToIndex.end()) {
 					constraint.isBroken = true;
-					continue;
+					return;
 				}
 
 				ParticlePhysics& pi = pParticles[it1->second];
@@ -353,7 +740,7 @@ void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<
 					pMatJ = matItJ->second;
 				}
 
-				glm::vec2 delta = pj.pos - pi.pos;
+				glm::vec2 delta = loadShared(pj.pos) - loadShared(pi.pos);
 
 				if (myVar.isPeriodicBoundaryEnabled) {
 					delta.x = fmod(delta.x + myVar.domainSize.x * 1.5f, myVar.domainSize.x) - myVar.domainSize.x * 0.5f;
@@ -361,7 +748,7 @@ void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<
 				}
 
 				float currentLength = glm::length(delta);
-				if (currentLength < 0.0001f) continue;
+				if (currentLength < 0.0001f) return;
 
 				glm::vec2 dir = delta / currentLength;
 				constraint.displacement = currentLength - constraint.restLength;
@@ -416,14 +803,8 @@ void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<
 					glm::vec2 dampForce = -globalConstraintDamping * glm::dot(relVel, dir) * dir * pi.mass;
 					glm::vec2 totalForce = springForce + dampForce;
 
-#pragma omp atomic
-					pi.acc.x += totalForce.x / pi.mass;
-#pragma omp atomic
-					pi.acc.y += totalForce.y / pi.mass;
-#pragma omp atomic
-					pj.acc.x -= totalForce.x / pj.mass;
-#pragma omp atomic
-					pj.acc.y -= totalForce.y / pj.mass;
+					addShared(pi.acc, totalForce / pi.mass);
+					addShared(pj.acc, -totalForce / pj.mass);
 
 					float correctionFactor = constraint.stiffness * stiffCorrectionRatio * myVar.globalConstraintStiffnessMult;
 					glm::vec2 correction = dir * constraint.displacement * correctionFactor;
@@ -431,16 +812,10 @@ void Physics::constraints(std::vector<ParticlePhysics>& pParticles, std::vector<
 					glm::vec2 correctionI = correction * (pj.mass / massSum);
 					glm::vec2 correctionJ = correction * (pi.mass / massSum);
 
-#pragma omp atomic
-					pi.pos.x += correctionI.x;
-#pragma omp atomic
-					pi.pos.y += correctionI.y;
-#pragma omp atomic
-					pj.pos.x -= correctionJ.x;
-#pragma omp atomic
-					pj.pos.y -= correctionJ.y;
+					addShared(pi.pos, correctionI);
+					addShared(pj.pos, -correctionJ);
 				}
-			}
+				});
 		}
 	}
 }
@@ -457,15 +832,16 @@ void Physics::pausedConstraints(std::vector<ParticlePhysics>& pParticles, std::v
 
 void Physics::mergerSolver(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar) {
 
-	std::unordered_set<uint32_t> particleIdsToDelete;
-	std::vector<size_t> indicesToDelete;
+	// Indexed by particle instead of a set of ids, nothing is removed until the end so indices stay valid
+	std::vector<uint8_t>& isMerged = mergedScratch.acquire(pParticles.size(), 0);
+	std::vector<size_t>& indicesToDelete = mergerDeleteScratch.acquire();
 
 	int originalSize = static_cast<int>(pParticles.size());
 	for (int i = originalSize - 1; i >= 0; i--) {
 		ParticlePhysics& p = pParticles[i];
 		ParticleRendering& r = rParticles[i];
 
-		if (r.isDarkMatter || particleIdsToDelete.count(p.id)) continue;
+		if (r.isDarkMatter || isMerged[i]) continue;
 
 		for (int j = static_cast<int>(p.neighborIds.size()) - 1; j >= 0; j--) {
 			uint32_t neighborId = p.neighborIds[j];
@@ -481,7 +857,7 @@ void Physics::mergerSolver(std::vector<ParticlePhysics>& pParticles, std::vector
 			ParticlePhysics& pn = pParticles[neighborIndex];
 			ParticleRendering& rn = rParticles[neighborIndex];
 
-			if (rn.isDarkMatter || particleIdsToDelete.count(pn.id)) continue;
+			if (rn.isDarkMatter || isMerged[neighborIndex]) continue;
 
 			glm::vec2 d = pn.pos - p.pos;
 			float distanceSq = glm::dot(d, d);
@@ -504,7 +880,7 @@ void Physics::mergerSolver(std::vector<ParticlePhysics>& pParticles, std::vector
 
 					r.previousSize = maxOriginalSize + (fullGrowthSize - maxOriginalSize) * growthFactor;
 
-					particleIdsToDelete.insert(pn.id);
+					isMerged[neighborIndex] = 1;
 					indicesToDelete.push_back(neighborIndex);
 				}
 				else {
@@ -519,7 +895,7 @@ void Physics::mergerSolver(std::vector<ParticlePhysics>& pParticles, std::vector
 
 					rn.previousSize = maxOriginalSize + (fullGrowthSize - maxOriginalSize) * growthFactor;
 
-					particleIdsToDelete.insert(p.id);
+					isMerged[i] = 1;
 					indicesToDelete.push_back(i);
 				}
 				break;
@@ -541,98 +917,48 @@ void Physics::mergerSolver(std::vector<ParticlePhysics>& pParticles, std::vector
 	}
 }
 
-void Physics::physicsUpdate(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar, bool& sphGround) {
-	const float accelScale = myVar.useSymplecticIntegrator ? 1.0f : 1.5f;
-	float dampingFactor = 1.0f;
-	if (myVar.velocityDampingEnabled && myVar.velocityDampingPerSecond > 0.0f && myVar.timeFactor > 0.0f) {
-		dampingFactor = std::exp(-myVar.velocityDampingPerSecond * myVar.timeFactor);
+float Physics::dampingFactor(const UpdateVariables& myVar, float step) {
+	if (myVar.velocityDampingEnabled && myVar.velocityDampingPerSecond > 0.0f && step > 0.0f) {
+		return std::exp(-myVar.velocityDampingPerSecond * step);
 	}
-	if (myVar.isPeriodicBoundaryEnabled) {
-
-#pragma omp parallel for schedule(dynamic)
-		for (size_t i = 0; i < pParticles.size(); i++) {
-
-			ParticlePhysics& pParticle = pParticles[i];
 
-			pParticle.prevVel = pParticle.vel;
-
-			pParticle.vel += myVar.timeFactor * accelScale * pParticle.acc;
-
-			// Max velocity for SPH
-			if (myVar.isSPHEnabled) {
-				const float sphMaxVelSq = myVar.sphMaxVel * myVar.sphMaxVel;
-				float vSq = pParticle.vel.x * pParticle.vel.x + pParticle.vel.y * pParticle.vel.y;
-				float prevVSq = pParticle.prevVel.x * pParticle.prevVel.x + pParticle.prevVel.y * pParticle.prevVel.y;
-				if (vSq > sphMaxVelSq) {
-					float invPrevLen = myVar.sphMaxVel / sqrtf(prevVSq);
-					float invLen = myVar.sphMaxVel / sqrtf(vSq);
-					pParticle.prevVel *= invPrevLen;
-					pParticle.vel *= invLen;
-				}
-			}
+	return 1.0f;
+}
 
-			pParticle.vel *= dampingFactor;
+void Physics::removeOutsideDomain(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles,
+	const UpdateVariables& myVar, bool sphGround) {
 
-			pParticle.pos += pParticle.vel * myVar.timeFactor;
+	if (myVar.isPeriodicBoundaryEnabled || sphGround) {
+		return;
+	}
 
-			if (!sphGround) {
-				if (pParticle.pos.x < 0.0f)
-					pParticle.pos.x += myVar.domainSize.x;
-				else if (pParticle.pos.x >= myVar.domainSize.x)
-					pParticle.pos.x -= myVar.domainSize.x;
+	for (size_t i = 0; i < pParticles.size(); ) {
+		if (pParticles[i].pos.x <= 0.0f || pParticles[i].pos.x >= myVar.domainSize.x || pParticles[i].pos.y <= 0.0f || pParticles[i].pos.y >= myVar.domainSize.y) {
+			std::swap(pParticles[i], pParticles.back());
+			std::swap(rParticles[i], rParticles.back());
 
-				if (pParticle.pos.y < 0.0f)
-					pParticle.pos.y += myVar.domainSize.y;
-				else if (pParticle.pos.y >= myVar.domainSize.y)
-					pParticle.pos.y -= myVar.domainSize.y;
-			}
+			pParticles.pop_back();
+			rParticles.pop_back();
+		}
+		else {
+			i++;
 		}
 	}
-	else {
-
-		for (size_t i = 0; i < pParticles.size(); ) {
-
-			ParticlePhysics& pParticle = pParticles[i];
-
-			pParticle.prevVel = pParticle.vel;
-
-			pParticle.vel += myVar.timeFactor * accelScale * pParticle.acc;
+}
 
-			// Max velocity for SPH
-			if (myVar.isSPHEnabled) {
-				const float sphMaxVelSq = myVar.sphMaxVel * myVar.sphMaxVel;
-				float vSq = pParticle.vel.x * pParticle.vel.x + pParticle.vel.y * pParticle.vel.y;
-				float prevVSq = pParticle.prevVel.x * pParticle.prevVel.x + pParticle.prevVel.y * pParticle.prevVel.y;
-				if (vSq > sphMaxVelSq) {
-					float invPrevLen = myVar.sphMaxVel / sqrtf(prevVSq);
-					float invLen = myVar.sphMaxVel / sqrtf(vSq);
-					pParticle.prevVel *= invPrevLen;
-					pParticle.vel *= invLen;
-				}
-			}
+void Physics::physicsUpdate(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles, UpdateVariables& myVar, bool& sphGround) {
+	const float damping = dampingFactor(myVar, myVar.timeFactor);
 
-			pParticle.vel *= dampingFactor;
+	parallel_for(0, pParticles.size(), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1, [&](size_t i, int) {
 
-			pParticle.pos += pParticle.vel * myVar.timeFactor;
+		ParticlePhysics& pParticle = pParticles[i];
 
-			if (!sphGround) {
-				if (pParticles[i].pos.x <= 0.0f || pParticles[i].pos.x >= myVar.domainSize.x || pParticles[i].pos.y <= 0.0f || pParticles[i].pos.y >= myVar.domainSize.y) {
-					std::swap(pParticles[i], pParticles.back());
-					std::swap(rParticles[i], rParticles.back());
+		pParticle.prevVel = pParticle.vel;
 
-					pParticles.pop_back();
-					rParticles.pop_back();
-				}
-				else {
-					i++;
-				}
-			}
-			else {
-				i++;
-			}
+		stepParticle(pParticle, myVar.timeFactor, myVar.timeFactor, damping, myVar, sphGround);
+		});
 
-		}
-	}
+	removeOutsideDomain(pParticles, rParticles, myVar, sphGround);
 }
 
 void Physics::collisions(ParticlePhysics& pParticleA, ParticlePhysics& pParticleB,
@@ -745,7 +1071,10 @@ void Physics::buildGrid(std::vector<ParticlePhysics>& pParticles, std::vector<Pa
 	int cellAmountY = static_cast<int>(domainSize.y / cellSize);
 
 	int totalCells = cellAmountX * cellAmountY;
-	std::vector<std::vector<size_t>> cellList(totalCells);
+
+	// Flat cell list built with a counting sort, cellStart[c] to cellStart[c + 1] are the particles of cell c
+	std::vector<uint32_t>& cellIds = spawnCellIdScratch.acquire(pParticles.size(), UINT32_MAX);
+	std::vector<uint32_t>& cellStart = spawnCellStartScratch.acquire(static_cast<size_t>(std::max(totalCells, 0)) + 1, 0);
 
 	for (size_t i = 0; i < pParticles.size(); ++i) {
 
@@ -762,10 +1091,30 @@ void Physics::buildGrid(std::vector<ParticlePhysics>& pParticles, std::vector<Pa
 			yIdx >= 0 && yIdx < cellAmountY) {
 
 			int cellId = xIdx + yIdx * cellAmountX;
-			cellList[cellId].push_back(i);
+			cellIds[i] = static_cast<uint32_t>(cellId);
+			cellStart[cellId + 1]++;
+		}
+	}
+
+	for (int c = 0; c < totalCells; c++) {
+		cellStart[c + 1] += cellStart[c];
+	}
+
+	std::vector<size_t>& cellParticles = spawnCellParticleScratch.acquireSized(cellStart[totalCells]);
+
+	// Fills in particle order using cellStart as the cursors, which leaves every cell's start where the next one
+	// begins, then shifts the starts back
+	for (size_t i = 0; i < pParticles.size(); ++i) {
+		if (cellIds[i] != UINT32_MAX) {
+			cellParticles[cellStart[cellIds[i]]++] = i;
 		}
 	}
 
+	for (int c = totalCells; c > 0; c--) {
+		cellStart[c] = cellStart[c - 1];
+	}
+	cellStart[0] = 0;
+
 	//std::vector<std::mutex> particleLocks(pParticles.size());
 
 
@@ -795,39 +1144,40 @@ void Physics::buildGrid(std::vector<ParticlePhysics>& pParticles, std::vector<Pa
 		};
 
 
-#pragma omp parallel for collapse(2) schedule(dynamic)
-	for (int y = 0; y < cellAmountY; ++y) {
-		for (int x = 0; x < cellAmountX; ++x) {
-			int baseId = x + y * cellAmountX;
-			auto& cell = cellList[baseId];
+	parallel_for(0, static_cast<size_t>(totalCells), [&](size_t c, int) {
+		const int baseId = static_cast<int>(c);
+		const int x = baseId % cellAmountX;
+		const int y = baseId / cellAmountX;
+		const size_t* cell = cellParticles.data() + cellStart[baseId];
+		const size_t cellCount = cellStart[baseId + 1] - cellStart[baseId];
 
-			for (int dx = -1; dx <= 1; ++dx) {
-				for (int dy = -1; dy <= 1; ++dy) {
-					int nx = x + dx, ny = y + dy;
-					if (nx < 0 || ny < 0 || nx >= cellAmountX || ny >= cellAmountY)
-						continue;
+		for (int dx = -1; dx <= 1; ++dx) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				int nx = x + dx, ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= cellAmountX || ny >= cellAmountY)
+					continue;
 
-					int neighborId = nx + ny * cellAmountX;
-					auto& other = cellList[neighborId];
+				int neighborId = nx + ny * cellAmountX;
+				const size_t* other = cellParticles.data() + cellStart[neighborId];
+				const size_t otherCount = cellStart[neighborId + 1] - cellStart[neighborId];
 
-					if (neighborId == baseId) {
+				if (neighborId == baseId) {
 
-						for (size_t i = 0; i < cell.size(); ++i) {
-							for (size_t j = i + 1; j < cell.size(); ++j) {
-								checkCollision(cell[i], cell[j]);
-							}
+					for (size_t i = 0; i < cellCount; ++i) {
+						for (size_t j = i + 1; j < cellCount; ++j) {
+							checkCollision(cell[i], cell[j]);
 						}
 					}
-					else {
+				}
+				else {
 
-						for (size_t i : cell) {
-							for (size_t j : other) {
-								checkCollision(i, j);
-							}
+					for (size_t i = 0; i < cellCount; ++i) {
+						for (size_t j = 0; j < otherCount; ++j) {
+							checkCollision(cell[i], other[j]);
 						}
 					}
 				}
 			}
 		}
-	}
+		});
 }
@@ -0,0 +1,597 @@
+#include "Physics/physicsPipeline.h"
+#include "UX/parallel_for.h"
+
+template <typename Func>
+static double timePhase(Func&& func) {
+	auto start = std::chrono::steady_clock::now();
+	func();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+glm::vec3 PhysicsPipeline::boundingBox(const std::vector<ParticlePhysics>& pParticles) {
+	glm::vec2 min = glm::vec2(std::numeric_limits<float>::max());
+	glm::vec2 max = glm::vec2(std::numeric_limits<float>::lowest());
+
+	for (const ParticlePhysics& particle : pParticles) {
+		min = glm::min(min, particle.pos);
+		max = glm::max(max, particle.pos);
+	}
+
+	float boundingBoxSize = glm::max(max.x - min.x, max.y - min.y);
+
+	glm::vec2 center = (min + max) * 0.5f;
+
+	glm::vec2 boundingBoxPos = center - boundingBoxSize * 0.5f;
+
+	return { boundingBoxPos.x, boundingBoxPos.y, boundingBoxSize };
+}
+
+void PhysicsPipeline::buildTree(UpdateVariables& myVar, SimulationParameters& simParam) {
+
+	if (!needsTree(myVar)) {
+		timings.treeBuild = 0.0;
+
+		// The particles move on without it, so a later refit has nothing to start from
+		treeRefit.particleIds.clear();
+		isTreeStale = true;
+
+		myVar.gridExists = !simParam.pParticles.empty();
+		return;
+	}
+
+	timings.treeBuild = timePhase([&]() {
+		if (myVar.isTreeRefitEnabled && treeRefit.stepsSinceBuild < myVar.treeRebuildInterval
+			&& treeRefit.refit(simParam.pParticles)) {
+			return;
+		}
+
+		rebuildTree(myVar, simParam);
+		});
+
+	isTreeStale = false;
+	myVar.gridExists = !globalNodes.empty();
+}
+
+bool PhysicsPipeline::needsTree(const UpdateVariables& myVar) const {
+
+	if (!myVar.isPMEnabled || myVar.isGPUEnabled) {
+		return true;
+	}
+
+	// conductHeat() runs on this frame's tree when its interval is up
+	return myVar.isTempEnabled && myVar.globalHeatConductivity > 0.0f
+		&& heatFramesPending + 1 >= std::max(myVar.heatConductionInterval, 1);
+}
+
+void PhysicsPipeline::requireTree(UpdateVariables& myVar, SimulationParameters& simParam) {
+
+	if (!isTreeStale) {
+		return;
+	}
+
+	timings.treeBuild += timePhase([&]() {
+		rebuildTree(myVar, simParam);
+		});
+
+	isTreeStale = false;
+}
+
+void PhysicsPipeline::refitTree(UpdateVariables& myVar, SimulationParameters& simParam) {
+
+	timings.treeBuild = timePhase([&]() {
+		if (!treeRefit.refit(simParam.pParticles)) {
+			rebuildTree(myVar, simParam);
+		}
+		});
+
+	myVar.gridExists = !globalNodes.empty();
+}
+
+void PhysicsPipeline::rebuildTree(UpdateVariables& myVar, SimulationParameters& simParam) {
+
+	bb = boundingBox(simParam.pParticles);
+
+	// A substep can fall back to a build within the frame, so the last tree counts toward the peak before it goes
+	frameArena.sample(&globalNodes);
+	globalNodes.clear();
+
+	Quadtree root(simParam.morton, simParam.pParticles, simParam.rParticles, bb);
+
+	if (myVar.isTreeRefitEnabled || usesBlockSteps(myVar)) {
+		treeRefit.recordBuild(simParam.pParticles);
+	}
+	else {
+		treeRefit.particleIds.clear();
+	}
+}
+
+void PhysicsPipeline::prepareNeighbors(UpdateVariables& myVar, SimulationParameters& simParam) {
+
+	timings.neighbors = timePhase([&]() {
+		for (ParticleRendering& rParticle : simParam.rParticles) {
+			rParticle.totalRadius = rParticle.size * myVar.particleTextureHalfSize * myVar.particleSizeMultiplier;
+		}
+
+		for (size_t i = 0; i < simParam.pParticles.size(); i++) {
+			simParam.pParticles[i].neighborIds.clear();
+		}
+
+		if (myVar.isMergerEnabled) {
+
+			// Heuristics for performance
+			constexpr float minCellSize = 2.0f;
+			constexpr float maxCellSize = 80.0f;
+
+			simParam.neighborSearch.cellSize = 0.0f;
+
+			for (size_t i = 0; i < simParam.pParticles.size(); ++i) {
+				auto& rP = simParam.rParticles[i];
+
+				if (rP.isDarkMatter) {
+					continue;
+				}
+
+				float candidate = rP.totalRadius * 2.0f;
+
+				simParam.neighborSearch.cellSize = std::max(simParam.neighborSearch.cellSize, candidate);
+			}
+
+			simParam.neighborSearch.cellSize = std::clamp(simParam.neighborSearch.cellSize, minCellSize, maxCellSize);
+		}
+		else {
+			simParam.neighborSearch.cellSize = 3.0f;
+		}
+
+		if (myVar.constraintsEnabled || myVar.drawConstraints || myVar.visualizeMesh || myVar.isBrushDrawing || myVar.isMergerEnabled) {
+			NeighborSearch::idToI(simParam.pParticles);
+			simParam.neighborSearch.neighborSearchHash(simParam.pParticles, simParam.rParticles);
+		}
+		});
+}
+
+void PhysicsPipeline::computeGravity(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics) {
+
+	std::vector<ParticlePhysics>& pParticles = simParam.pParticles;
+	const std::vector<ParticleRendering>& rParticles = simParam.rParticles;
+
+	timings.gravity = timePhase([&]() {
+		const bool usePM = myVar.isPMEnabled;
+		const bool useTreePM = !usePM && myVar.isTreePMEnabled && myVar.isPeriodicBoundaryEnabled;
+
+		physics.particleInteractions.resize(pParticles.size());
+
+		if (useTreePM) {
+			mesh.prepareSplit(myVar);
+		}
+
+		// The walk reads the particle's last acc for the relative opening criterion, so it's only overwritten after
+		auto gravityTask = [&](size_t i) {
+			ParticlePhysics& pParticle = pParticles[i];
+
+			if (Physics::isGravityFrozen(rParticles[i], myVar)) {
+				pParticle.acc = { 0.0f, 0.0f };
+				return;
+			}
+
+			glm::vec2 netForce = useTreePM
+				? physics.calculateShortRangeForce(pParticles, myVar, static_cast<uint32_t>(i), mesh.split)
+				: physics.calculateForceFromGrid(pParticles, myVar, static_cast<uint32_t>(i));
+			pParticle.acc = netForce / pParticle.mass;
+			};
+
+		if (usePM) {
+			mesh.computeGravity(pParticles, rParticles, myVar);
+		}
+		else if (myVar.isFMMEnabled && !useTreePM) {
+			fmm.computeGravity(pParticles, rParticles, myVar, myVar.fmmOrder);
+		}
+		else if (myVar.isGroupWalkEnabled && !useTreePM) {
+			physics.buildGravityGroups();
+
+			const size_t groupCount = physics.gravityGroups.size();
+
+			const int thread_count = clamp_thread_count(groupCount, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+			physics.interactionLists.resize(std::max(thread_count, 1));
+			parallel_for(0, groupCount, thread_count, [&](size_t g, int thread) {
+				physics.calculateGroupForces(pParticles, rParticles, myVar, physics.gravityGroups[g],
+					physics.interactionLists[thread]);
+				});
+		}
+		else {
+			const size_t count = pParticles.size();
+			const int thread_count = clamp_thread_count(count, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+			parallel_for(0, count, thread_count, [&](size_t i, int) { gravityTask(i); });
+
+			// The mesh adds the long range part on top of the short range part the walk wrote
+			if (useTreePM) {
+				mesh.computeLongRange(pParticles, rParticles, myVar);
+			}
+		}
+
+		if (usePM || (myVar.isFMMEnabled && !useTreePM)) {
+			myVar.averageInteractions = 0.0f;
+			myVar.maxInteractions = 0;
+		}
+		else {
+			countInteractions(myVar, simParam, physics);
+		}
+
+		physics.analyticHalos.addGravity(pParticles, rParticles, myVar);
+		});
+}
+
+void PhysicsPipeline::conductHeat(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics) {
+
+	timings.temperature = 0.0;
+
+	// The GPU gravity pass still exchanges heat in its own walk
+	if (!myVar.isTempEnabled || myVar.isGPUEnabled) {
+		heatFramesPending = 0;
+		heatTimePending = 0.0f;
+		return;
+	}
+
+	heatFramesPending++;
+	heatTimePending += myVar.timeFactor;
+
+	if (heatFramesPending < std::max(myVar.heatConductionInterval, 1)) {
+		return;
+	}
+
+	const float heatStep = heatTimePending;
+	heatFramesPending = 0;
+	heatTimePending = 0.0f;
+
+	if (heatStep <= 0.0f || myVar.globalHeatConductivity <= 0.0f) {
+		return;
+	}
+
+	timings.temperature = timePhase([&]() {
+		physics.buildGravityGroups();
+
+		std::vector<ParticlePhysics>& pParticles = simParam.pParticles;
+
+		const size_t groupCount = physics.gravityGroups.size();
+
+		const int thread_count = clamp_thread_count(groupCount, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+
+		// Groups write temperatures other groups read, so they all read a copy taken before the pass
+		std::vector<float>& temps = heatTempScratch.acquire();
+		temps.resize(pParticles.size());
+		parallel_for(0, pParticles.size(), thread_count, [&](size_t i, int) {
+			temps[i] = pParticles[i].temp;
+			});
+
+		physics.interactionLists.resize(std::max(thread_count, 1));
+		parallel_for(0, groupCount, thread_count, [&](size_t g, int thread) {
+			physics.conductHeat(pParticles, simParam.rParticles, temps, myVar, physics.gravityGroups[g],
+				physics.interactionLists[thread], heatStep);
+			});
+		});
+}
+
+void PhysicsPipeline::countInteractions(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics) {
+
+	struct Counts {
+		uint64_t total = 0;
+		uint32_t maxCount = 0;
+		uint32_t walked = 0;
+	};
+
+	const std::vector<uint32_t>& interactions = physics.particleInteractions;
+
+	const int thread_count = clamp_thread_count(interactions.size(), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+	std::vector<Counts> thread_counts(static_cast<size_t>(thread_count));
+	parallel_for(0, interactions.size(), thread_count, [&](size_t i, int tid) {
+		if (Physics::isGravityFrozen(simParam.rParticles[i], myVar)) {
+			return;
+		}
+
+		Counts& counts = thread_counts[static_cast<size_t>(tid)];
+		counts.total += interactions[i];
+		counts.maxCount = std::max(counts.maxCount, interactions[i]);
+		counts.walked++;
+		});
+
+	uint64_t total = 0;
+	uint32_t maxCount = 0;
+	uint32_t walked = 0;
+
+	for (const Counts& counts : thread_counts) {
+		total += counts.total;
+		maxCount = std::max(maxCount, counts.maxCount);
+		walked += counts.walked;
+	}
+
+	myVar.averageInteractions = walked > 0 ? static_cast<float>(static_cast<double>(total) / walked) : 0.0f;
+	myVar.maxInteractions = static_cast<int>(maxCount);
+}
+
+void PhysicsPipeline::addHaloGravity(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics) {
+
+	if (physics.analyticHalos.halos.empty()) {
+		return;
+	}
+
+	timings.gravity += timePhase([&]() {
+		physics.analyticHalos.addGravity(simParam.pParticles, simParam.rParticles, myVar);
+		});
+}
+
+void PhysicsPipeline::solveInteractions(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics, SPH& sph) {
+
+	timings.merger = 0.0;
+	if (myVar.isMergerEnabled) {
+		timings.merger = timePhase([&]() {
+			physics.mergerSolver(simParam.pParticles, simParam.rParticles, myVar);
+			});
+	}
+
+	timings.sph = 0.0;
+	if (myVar.isSPHEnabled) {
+		timings.sph = timePhase([&]() {
+			if (myVar.isDFSPHEnabled) {
+				sph.dfsphSolver(simParam.pParticles, simParam.rParticles, myVar.timeFactor, Physics::accelScale(myVar),
+					myVar.domainSize, myVar.sphGround);
+			}
+			else {
+				sph.pcisphSolver(simParam.pParticles, simParam.rParticles, myVar.timeFactor, Physics::accelScale(myVar),
+					myVar.domainSize, myVar.sphGround);
+			}
+			});
+	}
+
+	timings.constraints = timePhase([&]() {
+		physics.constraints(simParam.pParticles, simParam.rParticles, myVar);
+		});
+}
+
+static int blockStepLevel(glm::vec2 acc, float frameStep, const UpdateVariables& myVar) {
+
+	float accLength = glm::length(acc);
+
+	if (accLength <= 0.0f || frameStep <= 0.0f) {
+		return 0;
+	}
+
+	// The usual eta * sqrt(softening / |a|) criterion, rounded down to the next power of two step
+	float particleStep = myVar.blockStepAccuracy * sqrt(std::max(myVar.softening, 0.01f) / accLength);
+	int level = static_cast<int>(std::ceil(std::log2(frameStep / particleStep)));
+
+	return std::clamp(level, 0, myVar.maxStepLevel);
+}
+
+void PhysicsPipeline::integrateBlockSteps(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics) {
+
+	std::vector<ParticlePhysics>& pParticles = simParam.pParticles;
+	std::vector<ParticleRendering>& rParticles = simParam.rParticles;
+
+	const float frameStep = myVar.timeFactor;
+	const int maxLevel = std::clamp(myVar.maxStepLevel, 0, 16);
+	const int substeps = 1 << maxLevel;
+	const float substep = frameStep / static_cast<float>(substeps);
+
+	auto levelStep = [&](int level) { return frameStep / static_cast<float>(1 << level); };
+	auto levelStride = [&](int level) { return 1 << (maxLevel - level); };
+
+	const int threads = myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1;
+
+	// Forces at the frame start came from computeGravity, they close last frame's steps and open the new ones
+	parallel_for(0, pParticles.size(), threads, [&](size_t i, int) {
+		ParticlePhysics& pParticle = pParticles[i];
+
+		pParticle.prevVel = pParticle.vel;
+
+		if (isBlockKickPending) {
+			Physics::stepParticle(pParticle, levelStep(std::min(pParticle.stepLevel, maxLevel)) * 0.5f, 0.0f, 1.0f,
+				myVar, myVar.sphGround);
+		}
+
+		pParticle.stepLevel = blockStepLevel(pParticle.acc, frameStep, myVar);
+		});
+
+	// Halos always take the finest level, so their momentum exchange with the particles lines up with every substep
+	AnalyticHalos& analyticHalos = physics.analyticHalos;
+	analyticHalos.addMutualPull(myVar);
+	analyticHalos.step(analyticHalos.pendingKick, 0.0f, 1.0f, myVar);
+
+	// buildTree overwrites timings.treeBuild, so the frame's own build time is kept aside
+	double frameTree = timings.treeBuild;
+
+	// Substeps keep the frame's mesh and only redo the short range walk, like the long range step of GADGET style codes.
+	// With the mesh alone they just sample it again
+	const bool usePM = myVar.isPMEnabled && mesh.gridSize > 0;
+	const bool useTreePM = !usePM && myVar.isTreePMEnabled && myVar.isPeriodicBoundaryEnabled && mesh.gridSize > 0;
+	double substepTree = 0.0;
+	double substepGravity = 0.0;
+
+	// Damped once per frame, on the last drift, like physicsUpdate() damps before its drift
+	const float damping = Physics::dampingFactor(myVar, frameStep);
+
+	for (int s = 0; s < substeps; s++) {
+
+		const float substepDamping = s == substeps - 1 ? damping : 1.0f;
+
+		// Opening half kick for particles whose step starts here, then everyone drifts
+		parallel_for(0, pParticles.size(), threads, [&](size_t i, int) {
+			ParticlePhysics& pParticle = pParticles[i];
+
+			float kick = s % levelStride(pParticle.stepLevel) == 0 ? levelStep(pParticle.stepLevel) * 0.5f : 0.0f;
+
+			Physics::stepParticle(pParticle, kick, substep, substepDamping, myVar, myVar.sphGround);
+			});
+
+		analyticHalos.step(substep * 0.5f, substep, substepDamping, myVar);
+
+		const int t = s + 1;
+
+		// Every step ends on the last substep. Those forces come from next frame's computeGravity
+		if (t == substeps) {
+			break;
+		}
+
+		if (!analyticHalos.halos.empty()) {
+			analyticHalos.computeReaction(pParticles, myVar);
+			analyticHalos.addMutualPull(myVar);
+			analyticHalos.step(substep * 0.5f, 0.0f, 1.0f, myVar);
+		}
+
+		bool anyActive = false;
+		for (const ParticlePhysics& pParticle : pParticles) {
+			if (t % levelStride(pParticle.stepLevel) == 0) {
+				anyActive = true;
+				break;
+			}
+		}
+
+		if (!anyActive) {
+			continue;
+		}
+
+		// The mesh needs no tree. Particles only moved a substep since the tree was built or last refit, so it's refit
+		// in place, keeping the particle order the active set relies on
+		if (!usePM) {
+			refitTree(myVar, simParam);
+			substepTree += timings.treeBuild;
+
+			if (!myVar.gridExists) {
+				continue;
+			}
+		}
+
+		substepGravity += timePhase([&]() {
+
+			// A fallback build reorders particles, so the active set is collected after the tree
+			std::vector<uint32_t>& activeParticles = activeParticleScratch.acquire();
+			for (uint32_t i = 0; i < static_cast<uint32_t>(pParticles.size()); i++) {
+				if (t % levelStride(pParticles[i].stepLevel) == 0) {
+					activeParticles.push_back(i);
+				}
+			}
+
+			physics.particleInteractions.resize(pParticles.size());
+
+			// Every walk is done before any kick, the kicks write the positions the walks read
+			parallel_for(0, activeParticles.size(), threads, [&](size_t a, int) {
+				uint32_t i = activeParticles[a];
+				ParticlePhysics& pParticle = pParticles[i];
+
+				glm::vec2 acc = { 0.0f, 0.0f };
+
+				if (!Physics::isGravityFrozen(rParticles[i], myVar)) {
+					if (usePM) {
+						acc = mesh.interpolate(pParticle.pos);
+					}
+					else if (useTreePM) {
+						acc = physics.calculateShortRangeForce(pParticles, myVar, i, mesh.split) / pParticle.mass
+							+ mesh.interpolate(pParticle.pos);
+					}
+					else {
+						acc = physics.calculateForceFromGrid(pParticles, myVar, i) / pParticle.mass;
+					}
+
+					if (!physics.analyticHalos.halos.empty()) {
+						acc += physics.analyticHalos.accelerationAt(pParticle.pos, myVar);
+					}
+				}
+
+				pParticle.acc = acc;
+				});
+
+			// Closing half kick with the new force, then a new level. A particle may always halve its step, but only
+			// grow it where the bigger step lines up with this substep
+			parallel_for(0, activeParticles.size(), threads, [&](size_t a, int) {
+				ParticlePhysics& pParticle = pParticles[activeParticles[a]];
+
+				Physics::stepParticle(pParticle, levelStep(pParticle.stepLevel) * 0.5f, 0.0f, 1.0f, myVar, myVar.sphGround);
+
+				int level = blockStepLevel(pParticle.acc, frameStep, myVar);
+				while (level < pParticle.stepLevel && t % levelStride(level) != 0) {
+					level++;
+				}
+
+				pParticle.stepLevel = level;
+				});
+			});
+	}
+
+	isBlockKickPending = true;
+	analyticHalos.pendingKick = substep * 0.5f;
+
+	Physics::removeOutsideDomain(pParticles, rParticles, myVar, myVar.sphGround);
+
+	timings.treeBuild = frameTree + substepTree;
+	timings.gravity += substepGravity;
+}
+
+void PhysicsPipeline::integrate(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics) {
+
+	if (usesBlockSteps(myVar)) {
+		double integrationStart = timings.treeBuild + timings.gravity;
+
+		timings.integration = timePhase([&]() {
+			integrateBlockSteps(myVar, simParam, physics);
+			});
+
+		// Substep tree builds and force walks are already counted in their own phases
+		timings.integration -= timings.treeBuild + timings.gravity - integrationStart;
+	}
+	else {
+		timings.integration = timePhase([&]() {
+
+			// Switching back from block steps: finish the half kick the last block frame left open
+			if (isBlockKickPending) {
+				const float frameStep = myVar.timeFactor;
+
+				for (ParticlePhysics& pParticle : simParam.pParticles) {
+					float halfStep = frameStep / static_cast<float>(1 << std::clamp(pParticle.stepLevel, 0, 16)) * 0.5f;
+					Physics::stepParticle(pParticle, halfStep, 0.0f, 1.0f, myVar, myVar.sphGround);
+				}
+
+				isBlockKickPending = false;
+			}
+
+			physics.physicsUpdate(simParam.pParticles, simParam.rParticles, myVar, myVar.sphGround);
+
+			// Halos step with the particles, including the half kick a block frame may have left open
+			AnalyticHalos& analyticHalos = physics.analyticHalos;
+			analyticHalos.addMutualPull(myVar);
+			analyticHalos.step(analyticHalos.pendingKick + myVar.timeFactor, myVar.timeFactor,
+				Physics::dampingFactor(myVar, myVar.timeFactor), myVar);
+			analyticHalos.pendingKick = 0.0f;
+			});
+	}
+
+	// conductHeat() already started this frame's temperature time
+	if (myVar.isTempEnabled) {
+		timings.temperature += timePhase([&]() {
+			physics.temperatureCalculation(simParam.pParticles, simParam.rParticles, myVar);
+			});
+	}
+}
+
+void PhysicsPipeline::step(UpdateVariables& myVar, SimulationParameters& simParam, Physics& physics, SPH& sph) {
+
+	myVar.halfDomainWidth = myVar.domainSize.x * 0.5f;
+	myVar.halfDomainHeight = myVar.domainSize.y * 0.5f;
+
+	myVar.timeFactor = myVar.fixedDeltaTime * myVar.timeStepMultiplier;
+	myVar.G = 6.674e-11 * myVar.gravityMultiplier;
+
+	buildTree(myVar, simParam);
+
+	prepareNeighbors(myVar, simParam);
+
+	if (myVar.gridExists) {
+		computeGravity(myVar, simParam, physics);
+
+		conductHeat(myVar, simParam, physics);
+
+		solveInteractions(myVar, simParam, physics, sph);
+
+		integrate(myVar, simParam, physics);
+	}
+
+	frameArena.endFrame();
+}
@@ -2,108 +2,370 @@
 
 #include "Physics/quadtree.h"
 
-Node::Node(glm::vec2 pos, float size,
-	uint32_t startIndex, uint32_t endIndex,
-	std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles) {
-
-	this->pos = pos;
-	this->size = size;
-	this->startIndex = startIndex;
-	this->endIndex = endIndex;
-	this->gridMass = 0.0f;
-	this->centerOfMass = { 0.0f, 0.0f };
-
-	if ((((endIndex - startIndex) <= 16 /*Max Leaf Particles*/ && size <= 2.0f) /*Max Non-Dense Size*/ || (endIndex - startIndex) == 1) ||
-		size <= 0.01f /*Min Leaf Size*/) {
-		computeLeafMass(pParticles);
+#include "UX/parallel_for.h"
+
+#include "simulationParameters.h"
+
+extern UpdateVariables myVar;
+
+std::vector<std::vector<Node>> Quadtree::taskBuffers;
+
+// Splits a node's range into its quadrants and pushes the non empty ones. Pushed in reverse so quadrant 0 pops first
+static void pushChildren(const std::vector<MortonEntry>& entries, const PendingNode& pending, uint32_t parent,
+	std::vector<PendingNode>& stack) {
+
+	// Keys in this range share every digit above this level, so the 2 bits at this level split it in quadrant order
+	const int shift = 2 * (Morton::bitsPerAxis - 1 - pending.level);
+
+	uint32_t boundaries[5];
+	boundaries[0] = pending.startIndex;
+	boundaries[4] = pending.endIndex;
+
+	for (uint64_t q = 1; q < 4; q++) {
+		boundaries[q] = static_cast<uint32_t>(std::partition_point(
+			entries.begin() + boundaries[q - 1], entries.begin() + pending.endIndex,
+			[shift, q](const MortonEntry& entry) {
+				return ((entry.key >> shift) & 3ULL) < q;
+			}) - entries.begin());
 	}
-	else {
-		subGridMaker(pParticles, rParticles);
-		computeInternalMass();
 
-		calculateNextNeighbor();
+	float half = pending.size * 0.5f;
+
+	for (int q = 3; q >= 0; q--) {
+		if (boundaries[q + 1] > boundaries[q]) {
+
+			glm::vec2 newPos = { pending.pos.x + ((q & 1) ? half : 0.0f), pending.pos.y + ((q & 2) ? half : 0.0f) };
+
+			stack.push_back({ newPos, half, boundaries[q], boundaries[q + 1], pending.level + 1, parent, q });
+		}
 	}
 }
 
-template<typename Predicate>
-uint32_t dualPartition(std::vector<ParticlePhysics>& pParticlesVector, std::vector<ParticleRendering>& rParticlesVector, uint32_t begin, uint32_t end, Predicate predicate) {
-	uint32_t i = begin;
-	for (uint32_t j = begin; j < end; ++j) {
-		if (predicate(pParticlesVector[j])) {
-			if (i != j) {
-				std::swap(pParticlesVector[i], pParticlesVector[j]);
-				std::swap(rParticlesVector[i], rParticlesVector[j]);
-			}
-			++i;
+static inline bool stopsSplitting(const PendingNode& pending) {
+	return Node::isLeaf(pending.endIndex - pending.startIndex, pending.size) || pending.level >= Morton::bitsPerAxis;
+}
+
+void Quadtree::buildSubtree(const std::vector<MortonEntry>& entries, const PendingNode& subtreeRoot, std::vector<Node>& nodes) {
+
+	std::vector<PendingNode> stack;
+	stack.reserve(Morton::bitsPerAxis * 4 + 4);
+
+	stack.push_back(subtreeRoot);
+	stack.back().parent = UINT32_MAX;
+
+	while (!stack.empty()) {
+		PendingNode pending = stack.back();
+		stack.pop_back();
+
+		uint32_t nodeIndex = nodes.size();
+		nodes.emplace_back(pending.pos, pending.size, pending.startIndex, pending.endIndex);
+
+		if (pending.parent != UINT32_MAX) {
+			nodes[pending.parent].subGrids[pending.quadrant & 1][(pending.quadrant & 2) >> 1] = nodeIndex;
+		}
+
+		if (stopsSplitting(pending)) {
+			continue;
 		}
+
+		pushChildren(entries, pending, nodeIndex, stack);
 	}
-	return i;
 }
 
-void Node::subGridMaker(std::vector<ParticlePhysics>& pParticles, std::vector<ParticleRendering>& rParticles) {
+void Quadtree::computeMasses(const std::vector<ParticlePhysics>& pParticles, std::vector<Node>& nodes) {
 
-	glm::vec2 mid = pos + size * 0.5f;
+	// Children always sit after their parent, so walking backwards finishes every child first
+	for (int64_t i = static_cast<int64_t>(nodes.size()) - 1; i >= 0; i--) {
+		Node& node = nodes[i];
 
-	uint32_t originalStart = startIndex;
-	uint32_t originalEnd = endIndex;
-	uint32_t boundaries[5];
-	boundaries[0] = originalStart;
+		if (!node.hasChildren()) {
+			node.computeLeafMass(pParticles);
+		}
+		else {
+			node.computeInternalMass(nodes);
 
-	auto isQuad0 = [mid](const ParticlePhysics& pParticle) {
-		return (pParticle.pos.x < mid.x && pParticle.pos.y < mid.y);
-		};
-	boundaries[1] = dualPartition(pParticles, rParticles, originalStart, originalEnd, isQuad0);
+			node.calculateNextNeighbor(nodes);
+		}
+	}
+}
 
-	auto isQuad1 = [mid](const ParticlePhysics& pParticle) {
-		return (pParticle.pos.x >= mid.x && pParticle.pos.y < mid.y);
-		};
-	boundaries[2] = dualPartition(pParticles, rParticles, boundaries[1], originalEnd, isQuad1);
+void Quadtree::root(Morton& morton,
+	std::vector<ParticlePhysics>& pParticles,
+	std::vector<ParticleRendering>& rParticles) {
+
+	frameArena.track("Tree nodes", globalNodes, false);
+	frameArena.track("Gravity nodes", gravityNodes, false);
+	frameArena.track("Morton keys", morton.entries, false);
+	frameArena.track("Morton sort scratch", morton.scratch, false);
+	frameArena.track("Reorder physics", morton.pSorted, false);
+	frameArena.track("Reorder rendering", morton.rSorted, false);
+
+	morton.computeSortedKeys(pParticles, boundingBox, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+	morton.reorderParticles(pParticles, rParticles);
+
+	const std::vector<MortonEntry>& entries = morton.entries;
+	const uint32_t particleCount = static_cast<uint32_t>(entries.size());
+
+	const int threads = clamp_thread_count(particleCount, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
+
+	// Around 16 subtrees per thread leaves the pool enough pieces to steal on clustered scenes
+	constexpr uint32_t minTaskParticles = 4096;
+	const uint32_t taskCutoff = std::max(minTaskParticles, particleCount / static_cast<uint32_t>(threads * 16));
+
+	std::vector<Segment>& segments = segmentScratch.acquire();
+	std::vector<Node>& topNodes = topNodeScratch.acquire();
+	std::vector<PendingNode>& tasks = taskScratch.acquire();
+
+	std::vector<PendingNode>& stack = stackScratch.acquire();
+	stack.push_back({ { boundingBox.x, boundingBox.y }, boundingBox.z, 0, particleCount, 0, UINT32_MAX, 0 });
+
+	while (!stack.empty()) {
+		PendingNode pending = stack.back();
+		stack.pop_back();
+
+		uint32_t segmentIndex = segments.size();
+
+		if (pending.parent != UINT32_MAX) {
+			Node& parent = topNodes[segments[pending.parent].index];
+			parent.subGrids[pending.quadrant & 1][(pending.quadrant & 2) >> 1] = segmentIndex;
+		}
+
+		if (pending.endIndex - pending.startIndex <= taskCutoff || stopsSplitting(pending)) {
+			segments.push_back({ true, static_cast<uint32_t>(tasks.size()), 0 });
+			tasks.push_back(pending);
+			continue;
+		}
 
-	auto isQuad2 = [mid](const ParticlePhysics& pParticle) {
-		return (pParticle.pos.x < mid.x && pParticle.pos.y >= mid.y);
+		segments.push_back({ false, static_cast<uint32_t>(topNodes.size()), 0 });
+		topNodes.emplace_back(pending.pos, pending.size, pending.startIndex, pending.endIndex);
+
+		pushChildren(entries, pending, segmentIndex, stack);
+	}
+
+	if (taskBuffers.size() < tasks.size()) {
+		taskBuffers.resize(tasks.size());
+	}
+
+	auto subtreeTask = [&](size_t t) {
+		std::vector<Node>& nodes = taskBuffers[t];
+		nodes.clear();
+
+		buildSubtree(entries, tasks[t], nodes);
+		computeMasses(pParticles, nodes);
 		};
-	boundaries[3] = dualPartition(pParticles, rParticles, boundaries[2], originalEnd, isQuad2);
 
-	boundaries[4] = originalEnd;
+	parallel_for(0, tasks.size(), threads, [&](size_t t, int) { subtreeTask(t); });
 
-	for (int q = 0; q < 4; ++q) {
-		if (boundaries[q + 1] > boundaries[q]) {
+	uint32_t totalNodes = 0;
+	for (Segment& segment : segments) {
+		segment.offset = totalNodes;
+		totalNodes += segment.isTask ? static_cast<uint32_t>(taskBuffers[segment.index].size()) : 1;
+	}
 
-			glm::vec2 newPos = { pos.x + ((q & 1) ? size * 0.5f : 0.0f), pos.y + ((q & 2) ? size * 0.5f : 0.0f) };
+	globalNodes.resize(totalNodes);
 
-			uint32_t childIndex = globalNodes.size();
-			globalNodes.emplace_back();
+	auto spliceTask = [&](size_t s) {
+		const Segment& segment = segments[s];
 
-			Node& newNode = globalNodes[childIndex];
-			newNode = Node(
-				newPos, size * 0.5f,
-				boundaries[q], boundaries[q + 1],
-				pParticles, rParticles
-			);
+		if (segment.isTask) {
+			const std::vector<Node>& nodes = taskBuffers[segment.index];
+
+			for (size_t i = 0; i < nodes.size(); i++) {
+				Node& node = globalNodes[segment.offset + i];
+				node = nodes[i];
+
+				for (int x = 0; x < 2; x++) {
+					for (int y = 0; y < 2; y++) {
+						if (node.subGrids[x][y] != UINT32_MAX) {
+							node.subGrids[x][y] += segment.offset;
+						}
+					}
+				}
+			}
+		}
+		else {
+			Node& node = globalNodes[segment.offset];
+			node = topNodes[segment.index];
+
+			for (int x = 0; x < 2; x++) {
+				for (int y = 0; y < 2; y++) {
+					if (node.subGrids[x][y] != UINT32_MAX) {
+						node.subGrids[x][y] = segments[node.subGrids[x][y]].offset;
+					}
+				}
+			}
+		}
+		};
 
-			bool lr = (q & 1) ? 1 : 0;
-			bool ud = (q & 2) ? 1 : 0;
+	parallel_for(0, segments.size(), threads, [&](size_t s, int) { spliceTask(s); });
 
-			subGrids[lr][ud] = childIndex;
+	// Subtrees are done, so the few top nodes can be finished backwards like in computeMasses
+	for (int64_t s = static_cast<int64_t>(segments.size()) - 1; s >= 0; s--) {
+		if (segments[s].isTask) {
+			continue;
 		}
+
+		Node& node = globalNodes[segments[s].offset];
+
+		node.computeInternalMass();
+
+		node.calculateNextNeighbor();
 	}
+
+	emitGravityNodes();
 }
 
-void Quadtree::root(std::vector<ParticlePhysics>& pParticles,
-	std::vector<ParticleRendering>& rParticles) {
+void Quadtree::emitGravityNodes() {
+
+	gravityNodes.resize(globalNodes.size());
+	gravityNodeTemps.resize(globalNodes.size());
+	gravityNodeQuads.resize(globalNodes.size());
+
+	auto emitTask = [&](size_t i) {
+		const Node& node = globalNodes[i];
+
+		uint32_t count = node.endIndex - node.startIndex;
+
+		gravityNodes[i] = toGravityNode(node);
+
+		gravityNodeTemps[i] = count > 0 ? node.gridTemp / static_cast<float>(count) : 0.0f;
+		gravityNodeQuads[i] = node.quadrupole;
+		};
+
+	parallel_for(0, globalNodes.size(), clamp_thread_count(globalNodes.size(), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1),
+		[&](size_t i, int) { emitTask(i); });
+}
+
+GravityNode Quadtree::toGravityNode(const Node& node) {
+
+	GravityNode gravityNode;
+	gravityNode.centerOfMass = node.centerOfMass;
+	gravityNode.gridMass = node.gridMass;
 
-	if (!pParticles.empty()) {
-		globalNodes.reserve(pParticles.size() * 4);
+	if (node.hasChildren()) {
+		gravityNode.sizeSq = node.size * node.size;
+		gravityNode.nextOrParticle = node.next;
 	}
 	else {
-		globalNodes.reserve(4);
+		gravityNode.sizeSq = 0.0f;
+		gravityNode.nextOrParticle = node.endIndex - node.startIndex == 1 ? node.startIndex : UINT32_MAX;
 	}
 
-	globalNodes.emplace_back();
+	return gravityNode;
+}
+
+void TreeRefit::recordBuild(const std::vector<ParticlePhysics>& pParticles) {
+
+	particleIds.resize(pParticles.size());
+	builtBoxes.resize(globalNodes.size());
+
+	const int threads = myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1;
+
+	parallel_for(0, pParticles.size(), threads, [&](size_t i, int) {
+		particleIds[i] = pParticles[i].id;
+		});
+
+	parallel_for(0, globalNodes.size(), threads, [&](size_t i, int) {
+		builtBoxes[i] = { globalNodes[i].pos, globalNodes[i].size };
+		});
+
+	stepsSinceBuild = 0;
+	inflation = 1.0f;
+}
 
-	globalNodes[0] = Node(
-		{ boundingBox.x, boundingBox.y }, boundingBox.z,
-		0, pParticles.size(),
-		pParticles, rParticles
-	);
-}
\ No newline at end of file
+bool TreeRefit::refit(const std::vector<ParticlePhysics>& pParticles) {
+
+	if (globalNodes.empty() || pParticles.size() != particleIds.size() || globalNodes.size() != builtBoxes.size()) {
+		return false;
+	}
+
+	const int threads = myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1;
+
+	// Spawning, deleting, merging or a load since the last build all show up as a different id sequence
+	const int orderThreads = clamp_thread_count(pParticles.size(), threads);
+	std::vector<uint8_t> thread_changed(static_cast<size_t>(orderThreads), 0);
+	parallel_for(0, pParticles.size(), orderThreads, [&](size_t i, int tid) {
+		if (pParticles[i].id != particleIds[i]) {
+			thread_changed[static_cast<size_t>(tid)] = 1;
+		}
+		});
+
+	for (uint8_t changed : thread_changed) {
+		if (changed) {
+			return false;
+		}
+	}
+
+	// Boxes are kept as min corner plus max extent while refitting. They start from the built box, so they only grow
+	boxMax.resize(globalNodes.size());
+
+	parallel_for(0, globalNodes.size(), threads, [&](size_t i, int) {
+		Node& node = globalNodes[i];
+
+		if (node.hasChildren()) {
+			return;
+		}
+
+		node.computeLeafMass(pParticles);
+
+		glm::vec2 min = { builtBoxes[i].x, builtBoxes[i].y };
+		glm::vec2 max = min + glm::vec2(builtBoxes[i].z);
+
+		for (uint32_t p = node.startIndex; p < node.endIndex; p++) {
+			min = glm::min(min, pParticles[p].pos);
+			max = glm::max(max, pParticles[p].pos);
+		}
+
+		node.pos = min;
+		boxMax[i] = max;
+		node.size = glm::max(max.x - min.x, max.y - min.y);
+		});
+
+	double builtSize = 0.0;
+	double refitSize = 0.0;
+
+	// Children sit after their parent, so a backwards pass finishes them first
+	for (int64_t i = static_cast<int64_t>(globalNodes.size()) - 1; i >= 0; i--) {
+		Node& node = globalNodes[i];
+
+		if (!node.hasChildren()) {
+			continue;
+		}
+
+		node.computeInternalMass();
+
+		glm::vec2 min = { builtBoxes[i].x, builtBoxes[i].y };
+		glm::vec2 max = min + glm::vec2(builtBoxes[i].z);
+
+		for (int x = 0; x < 2; x++) {
+			for (int y = 0; y < 2; y++) {
+				uint32_t child = node.subGrids[x][y];
+
+				if (child == UINT32_MAX) {
+					continue;
+				}
+
+				min = glm::min(min, globalNodes[child].pos);
+				max = glm::max(max, boxMax[child]);
+			}
+		}
+
+		node.pos = min;
+		boxMax[i] = max;
+		node.size = glm::max(max.x - min.x, max.y - min.y);
+
+		builtSize += builtBoxes[i].z;
+		refitSize += node.size;
+	}
+
+	stepsSinceBuild++;
+	inflation = builtSize > 0.0 ? static_cast<float>(refitSize / builtSize) : 1.0f;
+
+	if (inflation > maxInflation) {
+		return false;
+	}
+
+	Quadtree::emitGravityNodes();
+
+	return true;
+}
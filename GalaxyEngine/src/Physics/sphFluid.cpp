@@ -0,0 +1,364 @@
+#include "Physics/sphFluid.h"
+#include "UX/parallel_for.h"
+
+void SPHCellList::build(const std::vector<glm::vec2>& positions, float minCellSize) {
+
+	const int64_t count = static_cast<int64_t>(positions.size());
+
+	const int thread_count = clamp_thread_count(static_cast<size_t>(count), threadPool.size());
+	std::vector<glm::vec4> thread_bounds(static_cast<size_t>(thread_count), glm::vec4(
+		std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+		std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()));
+
+	parallel_for(0, static_cast<size_t>(count), thread_count, [&](size_t i, int tid) {
+		glm::vec4& bounds = thread_bounds[static_cast<size_t>(tid)];
+		bounds.x = std::min(bounds.x, positions[i].x);
+		bounds.y = std::min(bounds.y, positions[i].y);
+		bounds.z = std::max(bounds.z, positions[i].x);
+		bounds.w = std::max(bounds.w, positions[i].y);
+		});
+
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxY = std::numeric_limits<float>::lowest();
+
+	for (const glm::vec4& bounds : thread_bounds) {
+		minX = std::min(minX, bounds.x);
+		minY = std::min(minY, bounds.y);
+		maxX = std::max(maxX, bounds.z);
+		maxY = std::max(maxY, bounds.w);
+	}
+
+	if (count == 0) {
+		minX = minY = maxX = maxY = 0.0f;
+	}
+
+	const float maxCells = static_cast<float>(std::max<int64_t>(4 * count, 1 << 16));
+
+	// A few stray particles far from the fluid would stretch the grid over millions of empty cells. The grid then only
+	// covers the bulk and the strays are clamped into the border cells, which keeps the 3x3 search exact: clamping
+	// never pulls two positions further than one cell apart
+	if ((maxX - minX) * (maxY - minY) > maxCells * minCellSize * minCellSize) {
+		const size_t low = static_cast<size_t>(count) / 1000;
+		const size_t high = static_cast<size_t>(count) - 1 - low;
+
+		boundsScratch.resize(count);
+		for (int axis = 0; axis < 2; axis++) {
+			for (int64_t i = 0; i < count; i++) {
+				boundsScratch[i] = axis == 0 ? positions[i].x : positions[i].y;
+			}
+
+			std::nth_element(boundsScratch.begin(), boundsScratch.begin() + low, boundsScratch.end());
+			float lowValue = boundsScratch[low];
+			std::nth_element(boundsScratch.begin(), boundsScratch.begin() + high, boundsScratch.end());
+			float highValue = boundsScratch[high];
+
+			(axis == 0 ? minX : minY) = lowValue;
+			(axis == 0 ? maxX : maxY) = highValue;
+		}
+	}
+
+	const float extentX = maxX - minX;
+	const float extentY = maxY - minY;
+
+	cellSize = std::max(minCellSize, std::sqrt(extentX * extentY / maxCells));
+	cellSize = std::max(cellSize, std::max(extentX, extentY) / maxCells);
+
+	origin = { minX, minY };
+	width = static_cast<int>(extentX / cellSize) + 1;
+	height = static_cast<int>(extentY / cellSize) + 1;
+
+	const uint32_t cellCount = static_cast<uint32_t>(width) * static_cast<uint32_t>(height);
+
+	entries.resize(count);
+
+	parallel_for(0, static_cast<size_t>(count), [&](size_t i, int) {
+		uint64_t cell = static_cast<uint64_t>(cellY(positions[i].y)) * width + cellX(positions[i].x);
+		entries[i] = { cell, static_cast<uint32_t>(i) };
+		});
+
+	// Stable, so the slots of a cell keep their input order and a rebuild over the same positions is deterministic
+	Morton::radixSort(entries, scratch, threadPool.size());
+
+	cellStart.resize(static_cast<size_t>(cellCount) + 1);
+
+	// Each slot where the key changes starts its cell and every empty cell since the previous key, which gives every
+	// slot a disjoint range of cellStart to write
+	parallel_for(0, static_cast<size_t>(count) + 1, [&](size_t k, int) {
+		uint64_t first = k > 0 ? entries[k - 1].key + 1 : 0;
+		uint64_t last = k < static_cast<size_t>(count) ? entries[k].key : cellCount;
+
+		for (uint64_t c = first; c <= last; c++) {
+			cellStart[c] = static_cast<uint32_t>(k);
+		}
+		});
+}
+
+void SPHFluid::resize(size_t count) {
+	particleIndex.resize(count);
+	particleId.resize(count);
+	pos.resize(count);
+	vel.resize(count);
+	predPos.resize(count);
+	predVel.resize(count);
+	acc.resize(count);
+	force.resize(count);
+	pressForce.resize(count);
+	sphMass.resize(count);
+	restDens.resize(count);
+	stiff.resize(count);
+	visc.resize(count);
+	cohesion.resize(count);
+	dens.resize(count);
+	predDens.resize(count);
+	press.resize(count);
+	pressTmp.resize(count);
+	protoStiff.resize(count);
+	densFactor.resize(count);
+	densKappa.resize(count);
+	divKappa.resize(count);
+	isPinned.resize(count);
+}
+
+void SPHFluid::gather(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles,
+	SPHCellList& cells, float cellSize) {
+
+	gatheredIndex.clear();
+	gatheredPos.clear();
+
+	uint32_t maxId = 0;
+
+	for (size_t i = 0; i < pParticles.size(); i++) {
+		if (rParticles[i].isSPH && !rParticles[i].isBeingDrawn) {
+			gatheredIndex.push_back(static_cast<uint32_t>(i));
+			gatheredPos.push_back(pParticles[i].pos);
+
+			maxId = std::max(maxId, pParticles[i].id);
+		}
+	}
+
+	cells.build(gatheredPos, cellSize);
+
+	prevId.swap(particleId);
+	prevDensKappa.swap(densKappa);
+	prevDivKappa.swap(divKappa);
+
+	resize(gatheredIndex.size());
+
+	// slotById still holds the last gather's slots here, which carries the warm start over
+	parallel_for(0, size(), [&](size_t k, int) {
+		MortonEntry& entry = cells.entries[k];
+
+		const uint32_t i = gatheredIndex[entry.index];
+		const uint32_t id = pParticles[i].id;
+		const uint32_t prevSlot = id < slotById.size() ? slotById[id] : UINT32_MAX;
+
+		particleIndex[k] = i;
+		particleId[k] = id;
+
+		densKappa[k] = prevSlot != UINT32_MAX ? prevDensKappa[prevSlot] : 0.0f;
+		divKappa[k] = prevSlot != UINT32_MAX ? prevDivKappa[prevSlot] : 0.0f;
+
+		entry.index = static_cast<uint32_t>(k);
+		});
+
+	for (uint32_t id : prevId) {
+		slotById[id] = UINT32_MAX;
+	}
+
+	if (!gatheredIndex.empty() && slotById.size() <= maxId) {
+		slotById.resize(static_cast<size_t>(maxId) + 1, UINT32_MAX);
+	}
+
+	// Serial, copied particles can share an id and the last one wins
+	for (uint32_t k = 0; k < static_cast<uint32_t>(size()); k++) {
+		slotById[particleId[k]] = k;
+	}
+
+	copyFields(pParticles, rParticles);
+}
+
+bool SPHFluid::regather(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles) {
+
+	if (size() == 0) {
+		return false;
+	}
+
+	// Found slots, or -1 once a particle has none
+	const int thread_count = clamp_thread_count(pParticles.size(), threadPool.size());
+	std::vector<int64_t> thread_found(static_cast<size_t>(thread_count), 0);
+
+	parallel_for(0, pParticles.size(), thread_count, [&](size_t i, int tid) {
+		int64_t& found = thread_found[static_cast<size_t>(tid)];
+
+		if (found < 0 || !rParticles[i].isSPH || rParticles[i].isBeingDrawn) {
+			return;
+		}
+
+		uint32_t id = pParticles[i].id;
+		uint32_t slot = id < slotById.size() ? slotById[id] : UINT32_MAX;
+
+		if (slot == UINT32_MAX) {
+			found = -1;
+			return;
+		}
+
+		particleIndex[slot] = static_cast<uint32_t>(i);
+		found++;
+		});
+
+	int64_t found = 0;
+
+	for (int64_t value : thread_found) {
+		if (value < 0) {
+			return false;
+		}
+
+		found += value;
+	}
+
+	if (found != static_cast<int64_t>(size())) {
+		return false;
+	}
+
+	// Particles sharing an id could still have left a slot pointing at some other particle
+	const int slot_threads = clamp_thread_count(size(), threadPool.size());
+	std::vector<uint8_t> thread_changed(static_cast<size_t>(slot_threads), 0);
+
+	parallel_for(0, size(), slot_threads, [&](size_t k, int tid) {
+		if (particleIndex[k] >= pParticles.size() || pParticles[particleIndex[k]].id != particleId[k]) {
+			thread_changed[static_cast<size_t>(tid)] = 1;
+		}
+		});
+
+	for (uint8_t changed : thread_changed) {
+		if (changed) {
+			return false;
+		}
+	}
+
+	copyFields(pParticles, rParticles);
+
+	return true;
+}
+
+void SPHFluid::copyFields(const std::vector<ParticlePhysics>& pParticles, const std::vector<ParticleRendering>& rParticles) {
+
+	parallel_for(0, size(), [&](size_t k, int) {
+		const uint32_t i = particleIndex[k];
+		const ParticlePhysics& pParticle = pParticles[i];
+
+		pos[k] = pParticle.pos;
+		vel[k] = pParticle.vel;
+		predPos[k] = pParticle.predPos;
+		predVel[k] = pParticle.predVel;
+		acc[k] = pParticle.acc;
+		force[k] = { 0.0f, 0.0f };
+		pressForce[k] = { 0.0f, 0.0f };
+
+		sphMass[k] = pParticle.sphMass;
+		restDens[k] = pParticle.restDens;
+		stiff[k] = pParticle.stiff;
+		visc[k] = pParticle.visc;
+		cohesion[k] = pParticle.cohesion;
+
+		dens[k] = pParticle.dens;
+		predDens[k] = pParticle.predDens;
+		press[k] = 0.0f;
+		pressTmp[k] = pParticle.pressTmp;
+
+		isPinned[k] = rParticles[i].isPinned;
+		});
+}
+
+void SPHFluid::scatter(std::vector<ParticlePhysics>& pParticles) const {
+
+	parallel_for(0, pParticles.size(), [&](size_t i, int) {
+		pParticles[i].press = 0.0f;
+		pParticles[i].pressF = { 0.0f, 0.0f };
+		});
+
+	parallel_for(0, size(), [&](size_t k, int) {
+		ParticlePhysics& pParticle = pParticles[particleIndex[k]];
+
+		pParticle.predPos = predPos[k];
+		pParticle.predVel = predVel[k];
+		pParticle.predDens = predDens[k];
+		pParticle.press = press[k];
+		pParticle.pressTmp = pressTmp[k];
+		pParticle.pressF = (force[k] + pressForce[k]) / sphMass[k];
+		});
+}
+
+void SPHNeighborList::build(const std::vector<glm::vec2>& positions, const SPHCellList& cells, float buildRadius,
+	float buildSkin) {
+
+	const int64_t count = static_cast<int64_t>(positions.size());
+
+	const float searchSq = (buildRadius + buildSkin) * (buildRadius + buildSkin);
+
+	counts.resize(count);
+
+	parallel_for(0, static_cast<size_t>(count), [&](size_t i, int) {
+		const glm::vec2 posI = positions[i];
+		uint32_t found = 0;
+
+		cells.forEachNeighbor(posI, [&](uint32_t j) {
+			glm::vec2 d = positions[j] - posI;
+			found += (d.x * d.x + d.y * d.y < searchSq) && j != static_cast<uint32_t>(i);
+			});
+
+		counts[i] = found;
+		});
+
+	start.resize(static_cast<size_t>(count) + 1);
+	start[0] = 0;
+	for (int64_t i = 0; i < count; i++) {
+		start[i + 1] = start[i] + counts[i];
+	}
+
+	neighbors.resize(start[count]);
+
+	parallel_for(0, static_cast<size_t>(count), [&](size_t i, int) {
+		const glm::vec2 posI = positions[i];
+		uint32_t cursor = start[i];
+
+		cells.forEachNeighbor(posI, [&](uint32_t j) {
+			glm::vec2 d = positions[j] - posI;
+			if (d.x * d.x + d.y * d.y < searchSq && j != static_cast<uint32_t>(i)) {
+				neighbors[cursor++] = j;
+			}
+			});
+		});
+
+	builtPos = positions;
+	radius = buildRadius;
+	skin = buildSkin;
+	isBuilt = true;
+}
+
+bool SPHNeighborList::holds(const std::vector<glm::vec2>& positions, float currentRadius, float currentSkin) const {
+
+	if (!isBuilt || positions.size() != builtPos.size() || currentRadius != radius || currentSkin != skin) {
+		return false;
+	}
+
+	const float maxShiftSq = 0.25f * skin * skin;
+
+	const int thread_count = clamp_thread_count(positions.size(), threadPool.size());
+	std::vector<float> thread_max(static_cast<size_t>(thread_count), 0.0f);
+
+	parallel_for(0, positions.size(), thread_count, [&](size_t i, int tid) {
+		glm::vec2 d = positions[i] - builtPos[i];
+		thread_max[static_cast<size_t>(tid)] = std::max(thread_max[static_cast<size_t>(tid)], d.x * d.x + d.y * d.y);
+		});
+
+	float shiftSq = 0.0f;
+	for (float value : thread_max) {
+		shiftSq = std::max(shiftSq, value);
+	}
+
+	// Two particles each moving half the skin toward each other is the most a pair can close in
+	return shiftSq <= maxShiftSq;
+}
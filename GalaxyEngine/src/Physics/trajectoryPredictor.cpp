@@ -0,0 +1,185 @@
+#include "Physics/trajectoryPredictor.h"
+
+#include "Physics/physics.h"
+#include "Physics/quadtree.h"
+
+#include "parameters.h"
+
+struct TrajectoryPredictor::Field {
+	std::vector<GravityNode> nodes;
+	AnalyticHalos halos;
+
+	// The walk only reads plain settings from here. Quadrupoles and the relative criterion are off, the copy has
+	// neither the quadrupoles nor the last accelerations they need
+	UpdateVariables settings;
+
+	explicit Field(const UpdateVariables& myVar) : settings(myVar) {
+	}
+};
+
+TrajectoryPredictor::~TrajectoryPredictor() {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		field.reset();
+		isAiming = false;
+		latest.store(++requested, std::memory_order_release);
+	}
+
+	threadPool.wait(task);
+}
+
+void TrajectoryPredictor::startWorker() {
+	threadPool.run(task, [this]() { workerLoop(); });
+}
+
+void TrajectoryPredictor::captureField(const UpdateVariables& myVar, const Physics& physics) {
+
+	std::shared_ptr<Field> newField = std::make_shared<Field>(myVar);
+	newField->nodes = gravityNodes;
+	newField->halos = physics.analyticHalos;
+
+	newField->settings.isQuadrupoleEnabled = false;
+	newField->settings.isRelativeOpeningEnabled = false;
+	newField->settings.halfDomainWidth = myVar.domainSize.x * 0.5f;
+	newField->settings.halfDomainHeight = myVar.domainSize.y * 0.5f;
+
+	bool shouldStart = false;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		field = std::move(newField);
+
+		// A path from the old field is stale
+		latest.store(++requested, std::memory_order_release);
+		path.clear();
+
+		shouldStart = isAiming && !isRunning;
+		isRunning = isRunning || shouldStart;
+	}
+
+	if (shouldStart) {
+		startWorker();
+	}
+}
+
+void TrajectoryPredictor::aim(glm::vec2 pos, glm::vec2 vel, float mass, int steps) {
+
+	Launch newLaunch = { pos, vel, mass, steps };
+
+	bool shouldStart = false;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (isAiming && newLaunch == launch) {
+			return;
+		}
+
+		launch = newLaunch;
+		isAiming = true;
+		latest.store(++requested, std::memory_order_release);
+		path.clear();
+
+		shouldStart = !isRunning;
+		isRunning = true;
+	}
+
+	if (shouldStart) {
+		startWorker();
+	}
+}
+
+void TrajectoryPredictor::stop() {
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	field.reset();
+	isAiming = false;
+	latest.store(++requested, std::memory_order_release);
+	path.clear();
+}
+
+void TrajectoryPredictor::copyPath(std::vector<glm::vec2>& out) {
+
+	std::lock_guard<std::mutex> lock(mutex);
+	out = path;
+}
+
+void TrajectoryPredictor::workerLoop() {
+
+	uint64_t done = 0;
+
+	std::vector<glm::vec2> chunk;
+	chunk.reserve(chunkSteps);
+
+	while (true) {
+		Launch current;
+		std::shared_ptr<const Field> currentField;
+		uint64_t generation = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			// Nothing new to fly, the next aim() queues the task again
+			if (!isAiming || requested == done) {
+				isRunning = false;
+				return;
+			}
+
+			current = launch;
+			currentField = field;
+			generation = requested;
+			done = requested;
+		}
+
+		if (!currentField) {
+			continue;
+		}
+
+		// Works on its own copy, the walk wants mutable settings
+		UpdateVariables settings = currentField->settings;
+
+		const float accelScale = Physics::accelScale(settings);
+		const float step = settings.timeFactor > 0.0f ? settings.timeFactor : settings.fixedDeltaTime * settings.timeStepMultiplier;
+
+		glm::vec2 pos = current.pos;
+		glm::vec2 vel = current.vel;
+
+		for (int s = 0; s < current.steps; s += chunkSteps) {
+			chunk.clear();
+
+			int chunkEnd = std::min(s + chunkSteps, current.steps);
+			for (int k = s; k < chunkEnd; k++) {
+				if (latest.load(std::memory_order_relaxed) != generation) {
+					break;
+				}
+
+				glm::vec2 acc = Physics::calculateForceFromNodes(currentField->nodes, settings, pos, current.mass) / current.mass;
+
+				if (!currentField->halos.halos.empty()) {
+					acc += currentField->halos.accelerationAt(pos, settings);
+				}
+
+				// Same kick and drift as the scene integrator
+				vel += step * accelScale * acc;
+				pos += vel * step;
+
+				if (settings.isPeriodicBoundaryEnabled) {
+					pos.x -= settings.domainSize.x * std::floor(pos.x / settings.domainSize.x);
+					pos.y -= settings.domainSize.y * std::floor(pos.y / settings.domainSize.y);
+				}
+
+				chunk.push_back(pos);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (latest.load(std::memory_order_acquire) != generation) {
+				break;
+			}
+
+			path.insert(path.end(), chunk.begin(), chunk.end());
+		}
+	}
+}
@@ -64,7 +64,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "General");
+	ImGui::TextColored(UI::colMenuInformation, "General");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -83,10 +83,18 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 
 	buttonHelper("GPU (Beta)", "Simulates gravity on the GPU", myVar.isGPUEnabled, -1.0f, settingsButtonY, true, canEnableGPU);
 
+	bool canEnableFMM = !myVar.isGPUEnabled;
+
+	buttonHelper("FMM Gravity", "Solves gravity with the fast multipole method instead of Barnes-Hut. Scales linearly with the particle count. Gravity range heat exchange is only done by Barnes-Hut", myVar.isFMMEnabled, -1.0f, settingsButtonY, true, canEnableFMM);
+
+	buttonHelper("TreePM Gravity", "Solves long range gravity on an FFT mesh that includes the periodic copies of the domain, and only walks the tree for nearby particles. Only used with Looping Space. Replaces FMM and the group walk while active", myVar.isTreePMEnabled, -1.0f, settingsButtonY, true, canEnableFMM);
+
+	buttonHelper("PM Gravity", "Solves all gravity on an FFT mesh. Cost follows the mesh size instead of the particle count, for previews of millions of particles. Coarse below a few cells. Replaces every other CPU gravity solver while active and feeds the gravity display", myVar.isPMEnabled, -1.0f, settingsButtonY, true, canEnableFMM);
+
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Exit");
+	ImGui::TextColored(UI::colMenuInformation, "Exit");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -96,7 +104,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Save/Load");
+	ImGui::TextColored(UI::colMenuInformation, "Save/Load");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -107,7 +115,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Trails");
+	ImGui::TextColored(UI::colMenuInformation, "Trails");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -116,11 +124,12 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 
 	buttonHelper("Local Trails", "Enables trails moving relative to particles average position", myVar.isLocalTrailsEnabled, -1.0f, settingsButtonY, true, enabled);
 	buttonHelper("White Trails", "Makes all trails white", myParam.trails.whiteTrails, -1.0f, settingsButtonY, true, enabled);
+	buttonHelper("Future Orbits", "Draws where the selected particles are headed. A coarse copy of the scene runs ahead on a background thread and restarts when the scene or the selection changes", myVar.isFutureOrbitsEnabled, -1.0f, settingsButtonY, true, enabled);
 
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Visuals");
+	ImGui::TextColored(UI::colMenuInformation, "Visuals");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -206,7 +215,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Simulation");
+	ImGui::TextColored(UI::colMenuInformation, "Simulation");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -333,7 +342,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Fluid Mode Material");
+	ImGui::TextColored(UI::colMenuInformation, "Fluid Mode Material");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -398,29 +407,53 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Dark Matter");
+	ImGui::TextColored(UI::colMenuInformation, "Dark Matter");
 
 	ImGui::Separator();
 	ImGui::Spacing();
 
 	buttonHelper("Dark Matter", "Enables dark matter particles. This works for galaxies and Big Bang", myVar.isDarkMatterEnabled, -1.0f, settingsButtonY, true, enabled);
 	buttonHelper("Show Dark Matter", "Unhides dark matter particles", myParam.colorVisuals.showDarkMatterEnabled, -1.0f, settingsButtonY, true, enabled);
+	buttonHelper("Analytic Halos", "Galaxies get one smooth dark matter halo that moves with them instead of dark matter particles. Much faster, but a halo can't be stripped or torn apart. Existing dark matter can be frozen into a halo from the right click menu", myVar.isAnalyticHaloEnabled, -1.0f, settingsButtonY, true, enabled);
+
+	const char* haloProfiles[] = { "NFW Halo", "Plummer Halo", "Isothermal Halo" };
+
+	ImGui::PushItemWidth(-FLT_MIN);
+
+	if (ImGui::BeginCombo("##HaloProfile", haloProfiles[std::clamp(myVar.haloProfile, 0, 2)])) {
+		for (int i = 0; i < IM_ARRAYSIZE(haloProfiles); i++) {
+
+			bool isSelected = (myVar.haloProfile == i);
+
+			if (ImGui::Selectable(haloProfiles[i], isSelected)) {
+				myVar.haloProfile = i;
+			}
+
+			if (isSelected) {
+				ImGui::SetItemDefaultFocus();
+			}
+		}
+		ImGui::EndCombo();
+	}
+
+	ImGui::PopItemWidth();
 
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Space Modifiers");
+	ImGui::TextColored(UI::colMenuInformation, "Space Modifiers");
 
 	ImGui::Separator();
 	ImGui::Spacing();
 
 	buttonHelper("Fluid Ground Mode", "Adds vertical gravity and makes particles collide with the domain walls", myVar.sphGround, -1.0f, settingsButtonY, true, myVar.isSPHEnabled);
+	buttonHelper("Divergence-Free Fluid", "Solves water pressure so it also stops compressing, not only undoes it. Keeps deep water calmer and less squashed, at a higher cost per step", myVar.isDFSPHEnabled, -1.0f, settingsButtonY, true, myVar.isSPHEnabled);
 	buttonHelper("Looping Space", "Particles disappearing on one side will appear on the other side", myVar.isPeriodicBoundaryEnabled, -1.0f, settingsButtonY, true, enabled);
 
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Temperature");
+	ImGui::TextColored(UI::colMenuInformation, "Temperature");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -430,7 +463,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Constraints");
+	ImGui::TextColored(UI::colMenuInformation, "Constraints");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -451,7 +484,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Optics");
+	ImGui::TextColored(UI::colMenuInformation, "Optics");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -461,7 +494,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Spacing();
 	ImGui::Separator();
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Fields");
+	ImGui::TextColored(UI::colMenuInformation, "Fields");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -475,7 +508,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 	ImGui::Separator();
 
 	ImGui::Spacing();
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Misc.");
+	ImGui::TextColored(UI::colMenuInformation, "Misc.");
 
 	ImGui::Separator();
 	ImGui::Spacing();
@@ -598,7 +631,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Colors");
+			ImGui::TextColored(UI::colMenuInformation, "Colors");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -658,7 +691,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Neighbor Search");
+			ImGui::TextColored(UI::colMenuInformation, "Neighbor Search");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -669,7 +702,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Color Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Color Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -690,7 +723,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Size Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Size Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -703,7 +736,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Trails Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Trails Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -714,7 +747,21 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Field Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Future Orbits Parameters");
+
+			ImGui::Separator();
+			ImGui::Spacing();
+
+			sliderHelper("Future Orbit Steps", "Controls how many steps ahead the selected particles are predicted", myVar.futureOrbitSteps, 50, 3000, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Future Orbit Step Scale", "Timestep of the prediction compared to the scene's. Higher looks further ahead for the same cost but drifts sooner", myVar.futureOrbitStepScale, 1.0f, 16.0f, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Future Orbit Theta", "Theta of the prediction's tree walk. Higher is faster and less accurate", myVar.futureOrbitTheta, 0.5f, 2.0f, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Future Orbit Max Bodies", "Particles the prediction simulates. Larger scenes are decimated, the skipped particles' mass goes to the kept ones", myVar.futureOrbitMaxBodies, 1000, 200000, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Future Orbit Threads", "Threads the prediction may use. The scene keeps the rest", myVar.futureOrbitThreads, 1, 8, parametersSliderX, parametersSliderY, enabled);
+
+			ImGui::Spacing();
+			ImGui::Separator();
+
+			ImGui::TextColored(UI::colMenuInformation, "Field Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -729,7 +776,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Misc. Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Misc. Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -754,7 +801,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "System Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "System Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -764,19 +811,32 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Simulation Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Simulation Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
 
 			sliderHelper("Theta", "Controls the quality of the gravity calculation. Higher means lower quality", myVar.theta, 0.1f, 5.0f, parametersSliderX, parametersSliderY, enabled);
+			buttonHelper("Relative Opening", "Opens gravity tree nodes by their force error compared to each particle's last acceleration instead of by theta. Spends the interactions where they matter: dense cores walk less of the tree, sparse outskirts more. Used by the CPU tree walks", myVar.isRelativeOpeningEnabled, 240.0f, 30.0f, true, enabled);
+			bool isOpeningAccuracyEnabled = enabled && myVar.isRelativeOpeningEnabled;
+			sliderHelper("Opening Accuracy", "Force error allowed per node with Relative Opening, as a fraction of the particle's acceleration. Lower is more accurate and slower", myVar.openingAccuracy, 0.001f, 0.05f, parametersSliderX, parametersSliderY, isOpeningAccuracyEnabled);
+			buttonHelper("Group Gravity Walk", "Walks the gravity tree once per small group of nearby particles instead of once per particle. Faster, slightly more accurate up close", myVar.isGroupWalkEnabled, 240.0f, 30.0f, true, enabled);
+			buttonHelper("Quadrupole Gravity", "Adds each node's quadrupole moment to the far field force. Keeps the same accuracy at a higher theta", myVar.isQuadrupoleEnabled, 240.0f, 30.0f, true, enabled);
+			sliderHelper("FMM Order", "Expansion order of the FMM gravity solver. Higher is more accurate and slower", myVar.fmmOrder, 1, 12, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("PM Grid Level", "The PM and TreePM mesh has 2 to this power cells per side. Higher resolves more detail on the mesh and shortens the TreePM tree walk", myVar.pmGridLevel, 5, 10, parametersSliderX, parametersSliderY, enabled);
+			buttonHelper("PM TSC Assignment", "Spreads each particle over 3x3 mesh cells instead of 2x2. Smoother, less grid bound mesh forces", myVar.isPMTSCEnabled, 240.0f, 30.0f, true, enabled);
+			buttonHelper("Tree Refit", "Keeps the gravity tree between frames and only refits it. Rebuilds it when particles move too far, are added or removed, or after the rebuild interval. Best for slowly evolving scenes", myVar.isTreeRefitEnabled, 240.0f, 30.0f, true, enabled);
+			sliderHelper("Tree Rebuild Interval", "Maximum steps between full gravity tree rebuilds when Tree Refit is on", myVar.treeRebuildInterval, 1, 200, parametersSliderX, parametersSliderY, enabled);
+			buttonHelper("Block Timesteps", "Gives each particle its own power of two timestep based on its acceleration. Particles in dense regions take several small steps per frame while the rest take one. Gravity only, SPH and GPU use the global step", myVar.isBlockTimestepEnabled, 240.0f, 30.0f, true, enabled);
+			sliderHelper("Max Step Level", "Smallest block timestep is the frame step divided by 2 to this power", myVar.maxStepLevel, 1, 8, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Block Step Accuracy", "Scales each particle's timestep. Lower is more accurate and slower", myVar.blockStepAccuracy, 0.01f, 1.0f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Domain Width", "Controls the width of the global container", myVar.domainSize.x, 200.0f, 3840.0f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Domain Height", "Controls the height of the global container", myVar.domainSize.y, 200.0f, 2160.0f, parametersSliderX, parametersSliderY, enabled);
 
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, " General Physics Parameters");
+			ImGui::TextColored(UI::colMenuInformation, " General Physics Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -800,7 +860,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Temperature Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Temperature Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -808,11 +868,12 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			sliderHelper("Ambient Temperature", "Controls the desired temperature of the scene in Kelvin. 1 is near absolute zero. The default value is set just high enough to allow liquid water", myVar.ambientTemp, 1.0f, 2500.0f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Ambient Heat Rate", "Controls how fast particles' temperature try to match ambient temperature", myVar.globalAmbientHeatRate, 0.0f, 10.0f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Heat Conductivity Multiplier", "Controls the global heat conductivity of particles", myVar.globalHeatConductivity, 0.001f, 1.0f, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Heat Conduction Interval", "Frames between long range heat exchange passes. Each pass covers the time of the frames it skipped. Higher is faster for slowly changing temperatures", myVar.heatConductionInterval, 1, 10, parametersSliderX, parametersSliderY, enabled);
 
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Constraints Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Constraints Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -823,7 +884,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Fluids Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Fluids Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -833,7 +894,12 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			sliderHelper("Fluid Viscosity", "Controls how viscous particles are", sph.viscosity, 0.01f, 15.0f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Fluid Stiffness", "Controls how stiff particles are", sph.stiffMultiplier, 0.01f, 15.0f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Fluid Cohesion", "Controls how sticky particles are", sph.cohesionCoefficient, 0.0f, 10.0f, parametersSliderX, parametersSliderY, enabled);
-			sliderHelper("Fluid Delta", "Controls the scaling factor in the pressure solver to enforce fluid incompressibility", sph.delta, 500.0f, 20000.0f, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Fluid Delta", "Controls the pressure scaling factor of materials a single particle is already denser than, like rock and sand. Water computes its own from the timestep", sph.delta, 500.0f, 20000.0f, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Fluid Pressure Iterations", "Controls the maximum pressure solver iterations per step. More keeps water closer to its rest density", sph.maxIter, 1, 20, parametersSliderX, parametersSliderY, enabled);
+			bool isRelaxationEnabled = enabled && myVar.isDFSPHEnabled;
+			sliderHelper("Fluid Divergence Free Relaxation", "Controls how much of the missing pressure each Divergence Free SPH iteration adds. Higher converges in fewer iterations but can overshoot when water splashes", sph.dfsphRelaxation, 0.1f, 1.0f, parametersSliderX, parametersSliderY, isRelaxationEnabled);
+			sliderHelper("Fluid Density Tolerance", "Controls how compressed water can be before the pressure solver stops iterating", sph.densTolerance, 0.001f, 0.1f, parametersSliderX, parametersSliderY, enabled);
+			sliderHelper("Fluid Neighbor Skin", "Controls how far particles can move before fluid neighbor lists are rebuilt. 0 rebuilds them twice every step", sph.neighborSkin, 0.0f, 1.5f, parametersSliderX, parametersSliderY, enabled);
 			sliderHelper("Fluid Max Velocity", "Controls the maximum velocity a particle can have in Fluid mode", myVar.sphMaxVel, 0.0f, 2000.0f, parametersSliderX, parametersSliderY, enabled);
 		}
 
@@ -845,7 +911,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "General Sound Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "General Sound Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -857,7 +923,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Soundtrack Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "Soundtrack Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -880,7 +946,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "General Recording Parameters");
+			ImGui::TextColored(UI::colMenuInformation, "General Recording Parameters");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -916,7 +982,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Color Settings");
+			ImGui::TextColored(UI::colMenuInformation, "Color Settings");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -990,7 +1056,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Light Settings");
+			ImGui::TextColored(UI::colMenuInformation, "Light Settings");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -1006,7 +1072,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Wall Material Settings");
+			ImGui::TextColored(UI::colMenuInformation, "Wall Material Settings");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -1037,7 +1103,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Shape Settings");
+			ImGui::TextColored(UI::colMenuInformation, "Shape Settings");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -1048,7 +1114,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Render Settings");
+			ImGui::TextColored(UI::colMenuInformation, "Render Settings");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -1082,7 +1148,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::Spacing();
 			ImGui::Separator();
 
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "Misc. Settings");
+			ImGui::TextColored(UI::colMenuInformation, "Misc. Settings");
 
 			ImGui::Separator();
 			ImGui::Spacing();
@@ -1122,16 +1188,16 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 
 	ImGui::Begin("Stats", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
 
-	ImGui::PushFont(myVar.robotoMediumFont);
+	ImGui::PushFont(UI::robotoMediumFont);
 
 	ImGui::SetWindowFontScale(1.5f);
 
 	int particlesAmout = static_cast<int>(myParam.pParticles.size());
 	int selecParticlesAmout = static_cast<int>(myParam.pParticlesSelected.size());
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "%s%d", "Total Particles: ", particlesAmout);
+	ImGui::TextColored(UI::colMenuInformation, "%s%d", "Total Particles: ", particlesAmout);
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "%s%d", "Selected Particles: ", selecParticlesAmout);
+	ImGui::TextColored(UI::colMenuInformation, "%s%d", "Selected Particles: ", selecParticlesAmout);
 
 	if (GetFPS() >= 60) {
 		ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "%s%d", "FPS: ", GetFPS());
@@ -1148,26 +1214,26 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 		ImGui::Spacing();
 		ImGui::Separator();
 
-		ImGui::TextColored(UpdateVariables::colMenuInformation, "%s%d", "Total Walls: ", static_cast<int>(lighting.walls.size()));
+		ImGui::TextColored(UI::colMenuInformation, "%s%d", "Total Walls: ", static_cast<int>(lighting.walls.size()));
 
 		if (lighting.selectedWalls > 0) {
-			ImGui::TextColored(UpdateVariables::colButtonHover, "%s%d", "Selected Walls: ", lighting.selectedWalls);
+			ImGui::TextColored(UI::colButtonHover, "%s%d", "Selected Walls: ", lighting.selectedWalls);
 		}
 
 
-		ImGui::TextColored(UpdateVariables::colMenuInformation, "%s%d", "Total Lights: ", lighting.totalLights);
+		ImGui::TextColored(UI::colMenuInformation, "%s%d", "Total Lights: ", lighting.totalLights);
 
 		if (lighting.selectedLights > 0) {
-			ImGui::TextColored(UpdateVariables::colButtonHover, "%s%d", "Selected Lights: ", lighting.selectedLights);
+			ImGui::TextColored(UI::colButtonHover, "%s%d", "Selected Lights: ", lighting.selectedLights);
 		}
 
-		ImGui::TextColored(UpdateVariables::colMenuInformation, "%s%d", "Total Rays: ", lighting.accumulatedRays);
+		ImGui::TextColored(UI::colMenuInformation, "%s%d", "Total Rays: ", lighting.accumulatedRays);
 
 		ImGui::Spacing();
 
 		float samplesPorgress = static_cast<float>(lighting.currentSamples) / static_cast<float>(lighting.maxSamples);
 
-		ImGui::PushStyleColor(ImGuiCol_PlotHistogram, UpdateVariables::colButtonHover);
+		ImGui::PushStyleColor(ImGuiCol_PlotHistogram, UI::colButtonHover);
 		float progress = samplesPorgress;
 		ImVec2 size = ImVec2(ImGui::GetContentRegionAvail().x, 22.0f);
 		float radius = 8.0f;
@@ -1179,7 +1245,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 			ImGui::GetColorU32(ImVec4(0.2f, 0.2f, 0.2f, 1.0f)), radius);
 
 		draw_list->AddRectFilled(pos, ImVec2(pos.x + size.x * progress, pos.y + size.y),
-			ImGui::GetColorU32(UpdateVariables::colButtonHover), radius);
+			ImGui::GetColorU32(UI::colButtonHover), radius);
 
 		char buffer[128];
 		snprintf(buffer, sizeof(buffer), "Samples %d / %d", lighting.currentSamples - 1, lighting.maxSamples);
@@ -1399,7 +1465,7 @@ void UI::uiLogic(UpdateParameters& myParam, UpdateVariables& myVar, SPH& sph, Sa
 		buttonHelper("Export .ply Seq.", "Exports particles to a .ply file each frame, creating a .ply sequence", myVar.exportPlySeqFlag, -1.0f, settingsButtonY, true, enabled);
 
 		if (myVar.plyFrameNumber != 0) {
-			ImGui::TextColored(UpdateVariables::colMenuInformation, "%s%d", "Frames Exported: ", myVar.plyFrameNumber);
+			ImGui::TextColored(UI::colMenuInformation, "%s%d", "Frames Exported: ", myVar.plyFrameNumber);
 		}
 
 		ImGui::EndTabItem();
@@ -1419,7 +1485,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Performance ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Performance");
+	ImGui::TextColored(UI::colMenuInformation, "Performance");
 	ImGui::Spacing();
 
 	float enablePausedPlot = 1.0f;
@@ -1432,9 +1498,50 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 	ImGui::Separator();
 	ImGui::Spacing();
 
+	//------ Gravity Interactions ------//
+
+	ImGui::TextColored(UI::colMenuInformation, "Gravity Interactions");
+	ImGui::Spacing();
+
+	if (myVar.maxInteractions > 0) {
+		ImGui::Text("Average Per Particle: %.1f", myVar.averageInteractions);
+		ImGui::Text("Max Per Particle: %d", myVar.maxInteractions);
+		ImGui::Spacing();
+		plotLinesHelper(enablePausedPlot, "Interactions: ", graphHistoryLimit, myVar.averageInteractions, 0.0f, 1000.0f, { 340.0f, 200.0f });
+	}
+	else {
+		ImGui::Text("Only counted by the CPU tree walks");
+	}
+
+	ImGui::Spacing();
+	ImGui::Separator();
+	ImGui::Spacing();
+
+	//------ Frame Memory ------//
+
+	ImGui::TextColored(UI::colMenuInformation, "Frame Memory");
+	ImGui::Spacing();
+
+	const double bytesToMB = 1.0 / (1024.0 * 1024.0);
+
+	ImGui::Text("Reserved: %.2f MB", frameArena.capacityBytes() * bytesToMB);
+	ImGui::Text("High-Water: %.2f MB", frameArena.highWaterBytes() * bytesToMB);
+
+	if (ImGui::TreeNode("Buffers (high-water / reserved)")) {
+		for (const FrameArena::Entry& entry : frameArena.entries) {
+			ImGui::Text("%s: %.2f / %.2f MB", entry.name, entry.highWaterBytes * bytesToMB,
+				entry.capacityBytes(entry.buffer) * bytesToMB);
+		}
+		ImGui::TreePop();
+	}
+
+	ImGui::Spacing();
+	ImGui::Separator();
+	ImGui::Spacing();
+
 	//------ Particle Count ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Particle Count");
+	ImGui::TextColored(UI::colMenuInformation, "Particle Count");
 	ImGui::Spacing();
 
 	int particlesAmout = static_cast<int>(myParam.pParticles.size());
@@ -1450,7 +1557,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Composition ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Composition");
+	ImGui::TextColored(UI::colMenuInformation, "Composition");
 	ImGui::Spacing();
 
 	float waterAmount = 0.0f;
@@ -1542,7 +1649,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Mass ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Mass");
+	ImGui::TextColored(UI::colMenuInformation, "Mass");
 	ImGui::Spacing();
 
 	double totalMass = 0.0f;
@@ -1569,7 +1676,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Velocity ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Selected Velocity");
+	ImGui::TextColored(UI::colMenuInformation, "Selected Velocity");
 	ImGui::Spacing();
 
 	glm::vec2 selectedVel = { 0.0f, 0.0f };
@@ -1598,7 +1705,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Acceleration ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Selected Acceleration");
+	ImGui::TextColored(UI::colMenuInformation, "Selected Acceleration");
 	ImGui::Spacing();
 
 	glm::vec2 selectedAcc = { 0.0f, 0.0f };
@@ -1627,7 +1734,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Pressure ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Selected Pressure");
+	ImGui::TextColored(UI::colMenuInformation, "Selected Pressure");
 	ImGui::Spacing();
 
 	float totalPress = 0.0f;
@@ -1650,7 +1757,7 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 	//------ Temperature ------//
 
-	ImGui::TextColored(UpdateVariables::colMenuInformation, "Selected Temperature");
+	ImGui::TextColored(UI::colMenuInformation, "Selected Temperature");
 	ImGui::Spacing();
 
 	float totalTemp = 0.0f;
@@ -1670,6 +1777,44 @@ void UI::statsWindowLogic(UpdateParameters& myParam, UpdateVariables& myVar) {
 
 std::unordered_map<std::string, PlotData> UI::plotDataMap;
 
+// Background color
+ImVec4 UI::colWindowBg = ImVec4(0.05f, 0.043f, 0.071f, 0.9f);
+
+// Button colors
+ImVec4 UI::colButton = ImVec4(0.22f, 0.23f, 0.36f, 1.0f);
+ImVec4 UI::colButtonHover = ImVec4(0.3f, 0.4f, 0.8f, 1.0f);
+ImVec4 UI::colButtonPress = ImVec4(0.5f, 0.6f, 0.9f, 1.0f);
+
+ImVec4 UI::colButtonActive = ImVec4(0.25f, 0.6f, 0.2f, 1.0f);
+ImVec4 UI::colButtonActiveHover = ImVec4(0.35f, 0.7f, 0.3f, 1.0f);
+ImVec4 UI::colButtonActivePress = ImVec4(0.45f, 0.8f, 0.4f, 1.0f);
+
+ImVec4 UI::colButtonRedActive = ImVec4(0.65f, 0.2f, 0.2f, 1.0f);
+ImVec4 UI::colButtonRedActiveHover = ImVec4(0.75f, 0.3f, 0.3f, 1.0f);
+ImVec4 UI::colButtonRedActivePress = ImVec4(0.85f, 0.4f, 0.4f, 1.0f);
+
+// Slider Colors
+ImVec4 UI::colSliderGrab = ImVec4(0.32f, 0.33f, 0.46f, 1.0f);
+ImVec4 UI::colSliderGrabActive = ImVec4(0.3f, 0.5f, 0.9f, 1.0f);
+ImVec4 UI::colSliderBg = ImVec4(0.12f, 0.13f, 0.26f, 1.0f);
+ImVec4 UI::colSliderBgHover = ImVec4(0.22f, 0.23f, 0.36f, 1.0f);
+ImVec4 UI::colSliderBgActive = ImVec4(0.42f, 0.43f, 0.66f, 1.0f);
+
+// Plotline Colors
+ImVec4 UI::colPlotLine = ImVec4(0.68f, 0.7f, 0.9f, 1.0f);
+ImVec4 UI::colAxisText = ImVec4(1.0f, 0.8f, 1.0f, 1.0f);
+ImVec4 UI::colAxisGrid = ImVec4(0.4f, 0.5f, 0.6f, 1.0f);
+ImVec4 UI::colAxisBg = ImVec4(0.1f, 0.1f, 0.2f, 1.0f);
+ImVec4 UI::colFrameBg = ImVec4(0.12f, 0.12f, 0.2f, 1.0f);
+ImVec4 UI::colPlotBg = ImVec4(0.05f, 0.05f, 0.1f, 1.0f);
+ImVec4 UI::colPlotBorder = ImVec4(1.0f, 0.0f, 1.0f, 1.0f);
+ImVec4 UI::colLegendBg = ImVec4(0.1f, 0.1f, 0.1f, 1.0f);
+
+// Text Colors
+ImVec4 UI::colMenuInformation = ImVec4(0.77f, 0.77f, 0.97f, 1.0f);
+
+ImFont* UI::robotoMediumFont = nullptr;
+
 void UI::plotLinesHelper(const float& timeFactor, std::string label,
 	const int length,
 	float value, const float minValue, const float maxValue, ImVec2 size) {
@@ -1701,14 +1846,14 @@ void UI::plotLinesHelper(const float& timeFactor, std::string label,
 
 		ImPlot::SetupAxis(ImAxis_Y1, nullptr, ImPlotAxisFlags_AutoFit);
 
-		ImPlot::PushStyleColor(ImPlotCol_Line, UpdateVariables::colPlotLine);
-		ImPlot::PushStyleColor(ImPlotCol_AxisText, UpdateVariables::colAxisText);
-		ImPlot::PushStyleColor(ImPlotCol_AxisGrid, UpdateVariables::colAxisGrid);
-		ImPlot::PushStyleColor(ImPlotCol_AxisBg, UpdateVariables::colAxisBg);
-		ImPlot::PushStyleColor(ImPlotCol_FrameBg, UpdateVariables::colFrameBg);
-		ImPlot::PushStyleColor(ImPlotCol_PlotBg, UpdateVariables::colPlotBg);
-		ImPlot::PushStyleColor(ImPlotCol_PlotBorder, UpdateVariables::colPlotBorder);
-		ImPlot::PushStyleColor(ImPlotCol_LegendBg, UpdateVariables::colLegendBg);
+		ImPlot::PushStyleColor(ImPlotCol_Line, UI::colPlotLine);
+		ImPlot::PushStyleColor(ImPlotCol_AxisText, UI::colAxisText);
+		ImPlot::PushStyleColor(ImPlotCol_AxisGrid, UI::colAxisGrid);
+		ImPlot::PushStyleColor(ImPlotCol_AxisBg, UI::colAxisBg);
+		ImPlot::PushStyleColor(ImPlotCol_FrameBg, UI::colFrameBg);
+		ImPlot::PushStyleColor(ImPlotCol_PlotBg, UI::colPlotBg);
+		ImPlot::PushStyleColor(ImPlotCol_PlotBorder, UI::colPlotBorder);
+		ImPlot::PushStyleColor(ImPlotCol_LegendBg, UI::colLegendBg);
 
 		ImPlot::PlotLine(label.c_str(), ordered_x.data(), ordered_values.data(), length);
 
@@ -1732,9 +1877,9 @@ bool UI::buttonHelper(std::string label, std::string tooltip, bool& parameter,
 
 	bool pushedColor = false;
 	if (parameter) {
-		ImGui::PushStyleColor(ImGuiCol_Button, UpdateVariables::colButtonActive);
-		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UpdateVariables::colButtonActiveHover);
-		ImGui::PushStyleColor(ImGuiCol_ButtonActive, UpdateVariables::colButtonActivePress);
+		ImGui::PushStyleColor(ImGuiCol_Button, UI::colButtonActive);
+		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UI::colButtonActiveHover);
+		ImGui::PushStyleColor(ImGuiCol_ButtonActive, UI::colButtonActivePress);
 		pushedColor = true;
 	}
 
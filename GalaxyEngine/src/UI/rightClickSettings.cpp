@@ -123,6 +123,12 @@ void RightClickSettings::rightClickMenu(UpdateVariables& myVar, UpdateParameters
 		if (UI::buttonHelper("Delete Selection", "Deletes selected particles", myParam.particleDeletion.deleteSelection, -1.0f, buttonSizeY, enabled, enabled)) {
 			isMenuActive = false;
 		}
+		if (UI::buttonHelper("Freeze Dark Matter", "Replaces the selected dark matter particles, or all of them if none are selected, by one analytic halo of the chosen profile", myVar.freezeDarkMatterFlag, -1.0f, buttonSizeY, enabled, enabled)) {
+			isMenuActive = false;
+		}
+		if (UI::buttonHelper("Delete Halos", "Deletes all analytic dark matter halos", myVar.deleteHalosFlag, -1.0f, buttonSizeY, enabled, enabled)) {
+			isMenuActive = false;
+		}
 		if (UI::buttonHelper("Delete Stray Particles", "Deletes all particles that are not in groups", myParam.particleDeletion.deleteNonImportant, -1.0f, buttonSizeY, enabled, enabled)) {
 			isMenuActive = false;
 		}
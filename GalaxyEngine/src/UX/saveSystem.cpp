@@ -1,92 +1,33 @@
 #include "UX/saveSystem.h"
 
-void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar, UpdateParameters& myParam, SPH& sph, Physics& physics, Lighting& lighting, Field& field) {
+void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar, SimulationParameters& simParam, SPH& sph, Physics& physics, Lighting& lighting) {
 
 	YAML::Emitter out;
 	out.SetFloatPrecision(9);
 	out.SetDoublePrecision(17);
-	/*out << YAML::BeginMap;*/
-
-	// ----- Trails -----
-	paramIO(filename, out, "GlobalTrails", myVar.isGlobalTrailsEnabled);
-	paramIO(filename, out, "SelectedTrails", myVar.isSelectedTrailsEnabled);
-	paramIO(filename, out, "LocalTrails", myVar.isLocalTrailsEnabled);
-	paramIO(filename, out, "WhiteTrails", myParam.trails.whiteTrails);
-	paramIO(filename, out, "TrailsMaxLength", myVar.trailMaxLength);
-	paramIO(filename, out, "TrailsThickness", myParam.trails.trailThickness);
-
-	// ----- Color parameters -----
-	paramIO(filename, out, "SolidColor", myParam.colorVisuals.solidColor);
-	paramIO(filename, out, "DensityColor", myParam.colorVisuals.densityColor);
-	paramIO(filename, out, "ForceColor", myParam.colorVisuals.forceColor);
-	paramIO(filename, out, "VelocityColor", myParam.colorVisuals.velocityColor);
-	paramIO(filename, out, "ShockwaveColor", myParam.colorVisuals.shockwaveColor);
-	paramIO(filename, out, "TurbulenceColor", myParam.colorVisuals.turbulenceColor);
-	paramIO(filename, out, "PressureColor", myParam.colorVisuals.pressureColor);
-	paramIO(filename, out, "SPHColor", myParam.colorVisuals.SPHColor);
-	paramIO(filename, out, "SelectedColor", myParam.colorVisuals.selectedColor);
-	paramIO(filename, out, "ShowDarkMatter", myParam.colorVisuals.showDarkMatterEnabled);
-
-	// ----- Color sliders -----
-	paramIO(filename, out, "ColorMaxVel", myParam.colorVisuals.maxVel);
-	paramIO(filename, out, "ColorMaxPressure", myParam.colorVisuals.maxPress);
-	paramIO(filename, out, "MaxColorForce", myParam.colorVisuals.maxColorAcc);
-	paramIO(filename, out, "ShockwaveMaxAcc", myParam.colorVisuals.ShockwaveMaxAcc);
-	paramIO(filename, out, "MaxColorTurbulence", myParam.colorVisuals.maxColorTurbulence);
-	paramIO(filename, out, "TurbulenceFadeRate", myParam.colorVisuals.turbulenceFadeRate);
-	paramIO(filename, out, "TurbulenceContrast", myParam.colorVisuals.turbulenceContrast);
-	paramIO(filename, out, "TurbulenceCustomColor", myParam.colorVisuals.turbulenceCustomCol);
-	paramIO(filename, out, "TemperatureColor", myParam.colorVisuals.temperatureColor);
-	paramIO(filename, out, "TemperatureGasColor", myParam.colorVisuals.gasTempColor);
-	paramIO(filename, out, "MaxTemperatureColor", myParam.colorVisuals.tempColorMaxTemp);
-	paramIO(filename, out, "MaxNeighbors", myParam.colorVisuals.maxNeighbors);
-
-	// ----- Other visual sliders -----
-	paramIO(filename, out, "DensityRadius", myParam.neighborSearch.densityRadius);
-	paramIO(filename, out, "MaxSizeForce", myParam.densitySize.sizeAcc);
-	paramIO(filename, out, "Max Dynamic Size", myParam.densitySize.maxSize);
-	paramIO(filename, out, "Min Dynamic Size", myParam.densitySize.minSize);
-	paramIO(filename, out, "MaxSizeForce", myParam.densitySize.sizeAcc);
-	paramIO(filename, out, "ParticleSizeMult", myVar.particleSizeMultiplier);
-	paramIO(filename, out, "VisiblePAmountMult", myParam.particlesSpawning.particleAmountMultiplier);
-	paramIO(filename, out, "DMPAmountMult", myParam.particlesSpawning.DMAmountMultiplier);
-	paramIO(filename, out, "MassMultiplierToggle", myParam.particlesSpawning.massMultiplierEnabled);
-
-	// ----- Colors -----
-	paramIO(filename, out, "pColorsR", myParam.colorVisuals.pColor.r);
-	paramIO(filename, out, "pColorsG", myParam.colorVisuals.pColor.g);
-	paramIO(filename, out, "pColorsB", myParam.colorVisuals.pColor.b);
-	paramIO(filename, out, "pColorsA", myParam.colorVisuals.pColor.a);
-
-	paramIO(filename, out, "sColorsR", myParam.colorVisuals.sColor.r);
-	paramIO(filename, out, "sColorsG", myParam.colorVisuals.sColor.g);
-	paramIO(filename, out, "sColorsB", myParam.colorVisuals.sColor.b);
-	paramIO(filename, out, "sColorsA", myParam.colorVisuals.sColor.a);
+
+	sceneIO(filename, out, myVar, simParam, sph, physics, lighting);
+}
+
+void SaveSystem::sceneIO(const std::string& filename, YAML::Emitter& out, UpdateVariables& myVar, SimulationParameters& simParam, SPH& sph, Physics& physics, Lighting& lighting) {
+
+	// ----- Neighbor search -----
+	paramIO(filename, out, "DensityRadius", simParam.neighborSearch.densityRadius);
 
 	// ----- Misc Toggles -----
 	paramIO(filename, out, "DarkMatter", myVar.isDarkMatterEnabled);
+	paramIO(filename, out, "AnalyticHalos", myVar.isAnalyticHaloEnabled);
+	paramIO(filename, out, "HaloProfile", myVar.haloProfile);
 	paramIO(filename, out, "LoopingSpace", myVar.isPeriodicBoundaryEnabled);
 	paramIO(filename, out, "SPHEnabled", myVar.isSPHEnabled);
-	paramIO(filename, out, "DensitySize", myVar.isDensitySizeEnabled);
-	paramIO(filename, out, "ForceSize", myVar.isForceSizeEnabled);
-	paramIO(filename, out, "Glow", myVar.isGlowEnabled);
 	paramIO(filename, out, "ShipGas", myVar.isShipGasEnabled);
 	paramIO(filename, out, "Merger", myVar.isMergerEnabled);
 
-	// ----- SPH Materials -----
-	paramIO(filename, out, "SPHWater", myParam.brush.SPHWater);
-	paramIO(filename, out, "SPHRock", myParam.brush.SPHRock);
-	paramIO(filename, out, "SPHIron", myParam.brush.SPHIron);
-	paramIO(filename, out, "SPHSand", myParam.brush.SPHSand);
-	paramIO(filename, out, "SPHSoil", myParam.brush.SPHSoil);
-	paramIO(filename, out, "SPHIce", myParam.brush.SPHIce);
-	paramIO(filename, out, "SPHMud", myParam.brush.SPHMud);
-	paramIO(filename, out, "SPHRubber", myParam.brush.SPHRubber);
-	paramIO(filename, out, "SPHGas", myParam.brush.SPHGas);
-
 	// ----- Physics params -----
 	paramIO(filename, out, "Softening", myVar.softening);
 	paramIO(filename, out, "Theta", myVar.theta);
+	paramIO(filename, out, "RelativeOpening", myVar.isRelativeOpeningEnabled);
+	paramIO(filename, out, "OpeningAccuracy", myVar.openingAccuracy);
 	paramIO(filename, out, "TimeMult", myVar.timeStepMultiplier);
 	paramIO(filename, out, "GravityMultiplier", myVar.gravityMultiplier);
 	paramIO(filename, out, "GravityRampEnabled", myVar.gravityRampEnabled);
@@ -95,11 +36,11 @@ void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar,
 	paramIO(filename, out, "GravityRampTime", myVar.gravityRampTime);
 	paramIO(filename, out, "VelocityDampingEnabled", myVar.velocityDampingEnabled);
 	paramIO(filename, out, "VelocityDampingRate", myVar.velocityDampingPerSecond);
-	paramIO(filename, out, "HeavyParticlesMass", myParam.particlesSpawning.heavyParticleWeightMultiplier);
 	paramIO(filename, out, "TemperatureSimulation", myVar.isTempEnabled);
 	paramIO(filename, out, "AmbientTemperature", myVar.ambientTemp);
 	paramIO(filename, out, "AmbientHeatRate", myVar.globalAmbientHeatRate);
 	paramIO(filename, out, "HeatConductivityMultiplier", myVar.globalHeatConductivity);
+	paramIO(filename, out, "HeatConductionInterval", myVar.heatConductionInterval);
 
 	// ----- SPH -----
 	paramIO(filename, out, "SPHGravity", sph.verticalGravity);
@@ -109,20 +50,18 @@ void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar,
 	paramIO(filename, out, "SPHStiffness", sph.stiffMultiplier);
 	paramIO(filename, out, "SPHCohesion", sph.cohesionCoefficient);
 	paramIO(filename, out, "SPHGround", myVar.sphGround);
+	paramIO(filename, out, "SPHDivergenceFree", myVar.isDFSPHEnabled);
 	paramIO(filename, out, "SPHDelta", sph.delta);
+	paramIO(filename, out, "SPHMaxIter", sph.maxIter);
+	paramIO(filename, out, "SPHDensTolerance", sph.densTolerance);
+	paramIO(filename, out, "SPHDivergenceFreeRelaxation", sph.dfsphRelaxation);
 	paramIO(filename, out, "SPHMaxVel", myVar.sphMaxVel);
+	paramIO(filename, out, "SPHNeighborSkin", sph.neighborSkin);
 
 	// ----- Domain size -----
 	paramIO(filename, out, "DomainWidth", myVar.domainSize.x);
 	paramIO(filename, out, "DomainHeight", myVar.domainSize.y);
 
-	// ----- Camera -----
-	paramIO(filename, out, "CameraTargetX", myParam.myCamera.camera.target.x);
-	paramIO(filename, out, "CameraTargetY", myParam.myCamera.camera.target.y);
-	paramIO(filename, out, "CameraOffsetX", myParam.myCamera.camera.offset.x);
-	paramIO(filename, out, "CameraOffsetY", myParam.myCamera.camera.offset.y);
-	paramIO(filename, out, "CameraZoom", myParam.myCamera.camera.zoom);
-
 	// ----- Constraints -----
 	paramIO(filename, out, "ParticleConstraints", myVar.constraintsEnabled);
 	paramIO(filename, out, "UnbreakableConstraints", myVar.unbreakableConstraints);
@@ -196,18 +135,6 @@ void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar,
 	paramIO(filename, out, "ShowNormals", lighting.drawNormals);
 	paramIO(filename, out, "RelaxMove", lighting.relaxMove);
 
-	// ----- Gravity Field -----
-	paramIO(filename, out, "GravityField", myVar.isGravityFieldEnabled);
-	paramIO(filename, out, "GravityFieldDM", myVar.gravityFieldDMParticles);
-	paramIO(filename, out, "GravityDisplayThreshold", field.gravityDisplayThreshold);
-	paramIO(filename, out, "GravityDisplaySoftness", field.gravityDisplaySoftness);
-	paramIO(filename, out, "GravityDisplayStretch", field.gravityStretchFactor);
-	paramIO(filename, out, "GravityCustomColors", field.gravityCustomColors);
-	paramIO(filename, out, "GravityCustomColExp", field.gravityExposure);
-
-	// ----- Field Misc -----
-	paramIO(filename, out, "FieldRes", field.res);
-
 	/*out << YAML::EndMap;*/
 
 	std::string yamlString = out.c_str();
@@ -231,12 +158,12 @@ void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar,
 		file.write(reinterpret_cast<const char*>(&globalShapeId), sizeof(globalShapeId));
 		file.write(reinterpret_cast<const char*>(&globalWallId), sizeof(globalWallId));
 
-		uint32_t particleCount = myParam.pParticles.size();
+		uint32_t particleCount = simParam.pParticles.size();
 		file.write(reinterpret_cast<const char*>(&particleCount), sizeof(particleCount));
 
-		for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-			const ParticlePhysics& p = myParam.pParticles[i];
-			const ParticleRendering& r = myParam.rParticles[i];
+		for (size_t i = 0; i < simParam.pParticles.size(); i++) {
+			const ParticlePhysics& p = simParam.pParticles[i];
+			const ParticleRendering& r = simParam.rParticles[i];
 
 			file.write(reinterpret_cast<const char*>(&p.pos), sizeof(p.pos));
 			file.write(reinterpret_cast<const char*>(&p.predPos), sizeof(p.predPos));
@@ -473,139 +400,21 @@ void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar,
 			file.write(reinterpret_cast<const char*>(&cl.spread), sizeof(cl.spread));
 		}
 
-		file.close();
-	}
+		uint32_t haloCount = physics.analyticHalos.halos.size();
+		file.write(reinterpret_cast<const char*>(&haloCount), sizeof(haloCount));
 
-	deserializeParticleSystem(filename, yamlString, myVar, myParam, sph, physics, lighting, loadFlag);
-}
-
-void SaveSystem::saveLoadLogic(UpdateVariables& myVar, UpdateParameters& myParam, SPH& sph, Physics& physics, Lighting& lighting, Field& field) {
-	if (saveFlag) {
-		if (!std::filesystem::exists("Saves")) {
-			std::filesystem::create_directory("Saves");
+		for (const AnalyticHalo& h : physics.analyticHalos.halos) {
+			file.write(reinterpret_cast<const char*>(&h.pos), sizeof(h.pos));
+			file.write(reinterpret_cast<const char*>(&h.vel), sizeof(h.vel));
+			file.write(reinterpret_cast<const char*>(&h.mass), sizeof(h.mass));
+			file.write(reinterpret_cast<const char*>(&h.scaleRadius), sizeof(h.scaleRadius));
+			file.write(reinterpret_cast<const char*>(&h.cutoffRadius), sizeof(h.cutoffRadius));
+			file.write(reinterpret_cast<const char*>(&h.profile), sizeof(h.profile));
 		}
 
-		int nextAvailableIndex = 0;
-		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("Saves")) {
-
-			std::string filename = entry.path().filename().string();
-			if (filename.rfind("Save_", 0) == 0 && filename.find(".bin") != std::string::npos) {
-
-				size_t startPos = filename.find_last_of('_') + 1;
-				size_t endPos = filename.find(".bin");
-				int index = std::stoi(filename.substr(startPos, endPos - startPos));
-
-				if (index >= nextAvailableIndex) {
-					nextAvailableIndex = index + 1;
-				}
-			}
-		}
-
-		std::string savePath = "Saves/Save_" + std::to_string(nextAvailableIndex) + ".bin";
-
-		saveSystem(savePath.c_str(), myVar, myParam, sph, physics, lighting, field);
-
-		saveIndex++;
-
-		saveFlag = false;
+		file.close();
 	}
 
-	if (loadFlag) {
-
-		int fileIndex = 1;
-
-		filePaths.clear();
-
-		if (!std::filesystem::exists("Saves")) {
-			std::filesystem::create_directory("Saves");
-			std::cout << "Created Saves directory as it did not exist" << std::endl;
-			loadFlag = false;
-			return;
-		}
-
-		std::vector<std::pair<std::string, std::string>> files;
-		for (const auto& entry : std::filesystem::recursive_directory_iterator("Saves")) {
-			if (entry.is_regular_file()) {
-				const auto filename = entry.path().filename().string();
-				const auto fullpath = entry.path().string();
-				if (filename.rfind(".bin") != std::string::npos) {
-					std::string relativePath = fullpath.substr(6);
-					files.emplace_back(relativePath, fullpath);
-				}
-			}
-		}
-
-		if (files.empty()) {
-			std::cout << "No .bin files found in Saves directory" << std::endl;
-			loadFlag = false;
-			return;
-		}
-
-		std::sort(files.begin(), files.end(),
-			[](auto& A, auto& B) {
-				const std::string& nameA = A.first;
-				const std::string& nameB = B.first;
-
-				auto isDefault = [](const std::string& s) {
-					const std::string key = "DefaultSettings.bin";
-
-					return s.size() >= key.size()
-						&& s.compare(s.size() - key.size(), key.size(), key) == 0;
-					};
-				bool aIsDefault = isDefault(nameA);
-				bool bIsDefault = isDefault(nameB);
-				if (aIsDefault != bIsDefault) {
-					return aIsDefault;
-				}
-
-				auto getDir = [](const std::string& s) {
-					size_t pos = s.find_last_of("\\/");
-					return (pos == std::string::npos) ? std::string{} : s.substr(0, pos);
-					};
-				std::string dirA = getDir(nameA);
-				std::string dirB = getDir(nameB);
-				if (dirA != dirB) {
-					return dirA < dirB;
-				}
-
-				auto extractNumber = [](const std::string& s) -> int {
-					size_t i = 0;
-					while (i < s.size() && !std::isdigit(s[i])) ++i;
-					size_t j = i;
-					while (j < s.size() && std::isdigit(s[j])) ++j;
-					if (i < j) {
-						try { return std::stoi(s.substr(i, j - i)); }
-						catch (...) {}
-					}
-					return -1;
-					};
-				int numA = extractNumber(nameA);
-				int numB = extractNumber(nameB);
-				if (numA >= 0 && numB >= 0 && numA != numB) {
-					return numA < numB;
-				}
-				return nameA < nameB;
-			}
-		);
-
-		ImGui::SetNextWindowSize(loadMenuSize, ImGuiCond_Once);
-		ImGui::SetNextWindowPos(ImVec2(static_cast<float>(GetScreenWidth()) * 0.5f - loadMenuSize.x * 0.5f, 450.0f), ImGuiCond_Once);
-		ImGui::Begin("Files");
-
-		for (const auto& [filename, fullPath] : files) {
-
-			bool placeHolder = false;
-			bool enabled = true;
-
-			if (UI::buttonHelper(fullPath.c_str(), "Select scene file", placeHolder, ImGui::GetContentRegionAvail().x, buttonHeight, enabled, enabled)) {
-				saveSystem(fullPath.c_str(), myVar, myParam, sph, physics, lighting, field);
-				loadFlag = false;
-			}
-
-			filePaths.push_back(fullPath);
-			fileIndex++;
-		}
-
-		ImGui::End();
-	}
+	deserializeParticleSystem(filename, yamlString, myVar, simParam, sph, physics, lighting, loadFlag);
 }
+
@@ -0,0 +1,245 @@
+#include "UX/saveSystem.h"
+
+#include "UI/UI.h"
+
+#include "parameters.h"
+
+void SaveSystem::saveSystem(const std::string& filename, UpdateVariables& myVar, UpdateParameters& myParam, SPH& sph, Physics& physics, Lighting& lighting, Field& field) {
+
+	YAML::Emitter out;
+	out.SetFloatPrecision(9);
+	out.SetDoublePrecision(17);
+	/*out << YAML::BeginMap;*/
+
+	// ----- Trails -----
+	paramIO(filename, out, "GlobalTrails", myVar.isGlobalTrailsEnabled);
+	paramIO(filename, out, "SelectedTrails", myVar.isSelectedTrailsEnabled);
+	paramIO(filename, out, "LocalTrails", myVar.isLocalTrailsEnabled);
+	paramIO(filename, out, "WhiteTrails", myParam.trails.whiteTrails);
+	paramIO(filename, out, "TrailsMaxLength", myVar.trailMaxLength);
+	paramIO(filename, out, "TrailsThickness", myParam.trails.trailThickness);
+	paramIO(filename, out, "FutureOrbits", myVar.isFutureOrbitsEnabled);
+	paramIO(filename, out, "FutureOrbitSteps", myVar.futureOrbitSteps);
+	paramIO(filename, out, "FutureOrbitStepScale", myVar.futureOrbitStepScale);
+	paramIO(filename, out, "FutureOrbitTheta", myVar.futureOrbitTheta);
+	paramIO(filename, out, "FutureOrbitMaxBodies", myVar.futureOrbitMaxBodies);
+	paramIO(filename, out, "FutureOrbitThreads", myVar.futureOrbitThreads);
+
+	// ----- Color parameters -----
+	paramIO(filename, out, "SolidColor", myParam.colorVisuals.solidColor);
+	paramIO(filename, out, "DensityColor", myParam.colorVisuals.densityColor);
+	paramIO(filename, out, "ForceColor", myParam.colorVisuals.forceColor);
+	paramIO(filename, out, "VelocityColor", myParam.colorVisuals.velocityColor);
+	paramIO(filename, out, "ShockwaveColor", myParam.colorVisuals.shockwaveColor);
+	paramIO(filename, out, "TurbulenceColor", myParam.colorVisuals.turbulenceColor);
+	paramIO(filename, out, "PressureColor", myParam.colorVisuals.pressureColor);
+	paramIO(filename, out, "SPHColor", myParam.colorVisuals.SPHColor);
+	paramIO(filename, out, "SelectedColor", myParam.colorVisuals.selectedColor);
+	paramIO(filename, out, "ShowDarkMatter", myParam.colorVisuals.showDarkMatterEnabled);
+
+	// ----- Color sliders -----
+	paramIO(filename, out, "ColorMaxVel", myParam.colorVisuals.maxVel);
+	paramIO(filename, out, "ColorMaxPressure", myParam.colorVisuals.maxPress);
+	paramIO(filename, out, "MaxColorForce", myParam.colorVisuals.maxColorAcc);
+	paramIO(filename, out, "ShockwaveMaxAcc", myParam.colorVisuals.ShockwaveMaxAcc);
+	paramIO(filename, out, "MaxColorTurbulence", myParam.colorVisuals.maxColorTurbulence);
+	paramIO(filename, out, "TurbulenceFadeRate", myParam.colorVisuals.turbulenceFadeRate);
+	paramIO(filename, out, "TurbulenceContrast", myParam.colorVisuals.turbulenceContrast);
+	paramIO(filename, out, "TurbulenceCustomColor", myParam.colorVisuals.turbulenceCustomCol);
+	paramIO(filename, out, "TemperatureColor", myParam.colorVisuals.temperatureColor);
+	paramIO(filename, out, "TemperatureGasColor", myParam.colorVisuals.gasTempColor);
+	paramIO(filename, out, "MaxTemperatureColor", myParam.colorVisuals.tempColorMaxTemp);
+	paramIO(filename, out, "MaxNeighbors", myParam.colorVisuals.maxNeighbors);
+
+	// ----- Other visual sliders -----
+	paramIO(filename, out, "MaxSizeForce", myParam.densitySize.sizeAcc);
+	paramIO(filename, out, "Max Dynamic Size", myParam.densitySize.maxSize);
+	paramIO(filename, out, "Min Dynamic Size", myParam.densitySize.minSize);
+	paramIO(filename, out, "MaxSizeForce", myParam.densitySize.sizeAcc);
+	paramIO(filename, out, "ParticleSizeMult", myVar.particleSizeMultiplier);
+	paramIO(filename, out, "VisiblePAmountMult", myParam.particlesSpawning.particleAmountMultiplier);
+	paramIO(filename, out, "DMPAmountMult", myParam.particlesSpawning.DMAmountMultiplier);
+	paramIO(filename, out, "MassMultiplierToggle", myParam.particlesSpawning.massMultiplierEnabled);
+
+	// ----- Colors -----
+	paramIO(filename, out, "pColorsR", myParam.colorVisuals.pColor.r);
+	paramIO(filename, out, "pColorsG", myParam.colorVisuals.pColor.g);
+	paramIO(filename, out, "pColorsB", myParam.colorVisuals.pColor.b);
+	paramIO(filename, out, "pColorsA", myParam.colorVisuals.pColor.a);
+
+	paramIO(filename, out, "sColorsR", myParam.colorVisuals.sColor.r);
+	paramIO(filename, out, "sColorsG", myParam.colorVisuals.sColor.g);
+	paramIO(filename, out, "sColorsB", myParam.colorVisuals.sColor.b);
+	paramIO(filename, out, "sColorsA", myParam.colorVisuals.sColor.a);
+
+	// ----- Visual toggles -----
+	paramIO(filename, out, "DensitySize", myVar.isDensitySizeEnabled);
+	paramIO(filename, out, "ForceSize", myVar.isForceSizeEnabled);
+	paramIO(filename, out, "Glow", myVar.isGlowEnabled);
+
+	// ----- SPH Materials -----
+	paramIO(filename, out, "SPHWater", myParam.brush.SPHWater);
+	paramIO(filename, out, "SPHRock", myParam.brush.SPHRock);
+	paramIO(filename, out, "SPHIron", myParam.brush.SPHIron);
+	paramIO(filename, out, "SPHSand", myParam.brush.SPHSand);
+	paramIO(filename, out, "SPHSoil", myParam.brush.SPHSoil);
+	paramIO(filename, out, "SPHIce", myParam.brush.SPHIce);
+	paramIO(filename, out, "SPHMud", myParam.brush.SPHMud);
+	paramIO(filename, out, "SPHRubber", myParam.brush.SPHRubber);
+	paramIO(filename, out, "SPHGas", myParam.brush.SPHGas);
+
+	// ----- Spawning -----
+	paramIO(filename, out, "HeavyParticlesMass", myParam.particlesSpawning.heavyParticleWeightMultiplier);
+
+	// ----- Camera -----
+	paramIO(filename, out, "CameraTargetX", myParam.myCamera.camera.target.x);
+	paramIO(filename, out, "CameraTargetY", myParam.myCamera.camera.target.y);
+	paramIO(filename, out, "CameraOffsetX", myParam.myCamera.camera.offset.x);
+	paramIO(filename, out, "CameraOffsetY", myParam.myCamera.camera.offset.y);
+	paramIO(filename, out, "CameraZoom", myParam.myCamera.camera.zoom);
+
+	// ----- Gravity Field -----
+	paramIO(filename, out, "GravityField", myVar.isGravityFieldEnabled);
+	paramIO(filename, out, "GravityFieldDM", myVar.gravityFieldDMParticles);
+	paramIO(filename, out, "GravityDisplayThreshold", field.gravityDisplayThreshold);
+	paramIO(filename, out, "GravityDisplaySoftness", field.gravityDisplaySoftness);
+	paramIO(filename, out, "GravityDisplayStretch", field.gravityStretchFactor);
+	paramIO(filename, out, "GravityCustomColors", field.gravityCustomColors);
+	paramIO(filename, out, "GravityCustomColExp", field.gravityExposure);
+
+	// ----- Field Misc -----
+	paramIO(filename, out, "FieldRes", field.res);
+
+	sceneIO(filename, out, myVar, myParam, sph, physics, lighting);
+}
+
+void SaveSystem::saveLoadLogic(UpdateVariables& myVar, UpdateParameters& myParam, SPH& sph, Physics& physics, Lighting& lighting, Field& field) {
+	if (saveFlag) {
+		if (!std::filesystem::exists("Saves")) {
+			std::filesystem::create_directory("Saves");
+		}
+
+		int nextAvailableIndex = 0;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("Saves")) {
+
+			std::string filename = entry.path().filename().string();
+			if (filename.rfind("Save_", 0) == 0 && filename.find(".bin") != std::string::npos) {
+
+				size_t startPos = filename.find_last_of('_') + 1;
+				size_t endPos = filename.find(".bin");
+				int index = std::stoi(filename.substr(startPos, endPos - startPos));
+
+				if (index >= nextAvailableIndex) {
+					nextAvailableIndex = index + 1;
+				}
+			}
+		}
+
+		std::string savePath = "Saves/Save_" + std::to_string(nextAvailableIndex) + ".bin";
+
+		saveSystem(savePath.c_str(), myVar, myParam, sph, physics, lighting, field);
+
+		saveIndex++;
+
+		saveFlag = false;
+	}
+
+	if (loadFlag) {
+
+		int fileIndex = 1;
+
+		filePaths.clear();
+
+		if (!std::filesystem::exists("Saves")) {
+			std::filesystem::create_directory("Saves");
+			std::cout << "Created Saves directory as it did not exist" << std::endl;
+			loadFlag = false;
+			return;
+		}
+
+		std::vector<std::pair<std::string, std::string>> files;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator("Saves")) {
+			if (entry.is_regular_file()) {
+				const auto filename = entry.path().filename().string();
+				const auto fullpath = entry.path().string();
+				if (filename.rfind(".bin") != std::string::npos) {
+					std::string relativePath = fullpath.substr(6);
+					files.emplace_back(relativePath, fullpath);
+				}
+			}
+		}
+
+		if (files.empty()) {
+			std::cout << "No .bin files found in Saves directory" << std::endl;
+			loadFlag = false;
+			return;
+		}
+
+		std::sort(files.begin(), files.end(),
+			[](auto& A, auto& B) {
+				const std::string& nameA = A.first;
+				const std::string& nameB = B.first;
+
+				auto isDefault = [](const std::string& s) {
+					const std::string key = "DefaultSettings.bin";
+
+					return s.size() >= key.size()
+						&& s.compare(s.size() - key.size(), key.size(), key) == 0;
+					};
+				bool aIsDefault = isDefault(nameA);
+				bool bIsDefault = isDefault(nameB);
+				if (aIsDefault != bIsDefault) {
+					return aIsDefault;
+				}
+
+				auto getDir = [](const std::string& s) {
+					size_t pos = s.find_last_of("\\/");
+					return (pos == std::string::npos) ? std::string{} : s.substr(0, pos);
+					};
+				std::string dirA = getDir(nameA);
+				std::string dirB = getDir(nameB);
+				if (dirA != dirB) {
+					return dirA < dirB;
+				}
+
+				auto extractNumber = [](const std::string& s) -> int {
+					size_t i = 0;
+					while (i < s.size() && !std::isdigit(s[i])) ++i;
+					size_t j = i;
+					while (j < s.size() && std::isdigit(s[j])) ++j;
+					if (i < j) {
+						try { return std::stoi(s.substr(i, j - i)); }
+						catch (...) {}
+					}
+					return -1;
+					};
+				int numA = extractNumber(nameA);
+				int numB = extractNumber(nameB);
+				if (numA >= 0 && numB >= 0 && numA != numB) {
+					return numA < numB;
+				}
+				return nameA < nameB;
+			}
+		);
+
+		ImGui::SetNextWindowSize(ImVec2(loadMenuSize.x, loadMenuSize.y), ImGuiCond_Once);
+		ImGui::SetNextWindowPos(ImVec2(static_cast<float>(GetScreenWidth()) * 0.5f - loadMenuSize.x * 0.5f, 450.0f), ImGuiCond_Once);
+		ImGui::Begin("Files");
+
+		for (const auto& [filename, fullPath] : files) {
+
+			bool placeHolder = false;
+			bool enabled = true;
+
+			if (UI::buttonHelper(fullPath.c_str(), "Select scene file", placeHolder, ImGui::GetContentRegionAvail().x, buttonHeight, enabled, enabled)) {
+				saveSystem(fullPath.c_str(), myVar, myParam, sph, physics, lighting, field);
+				loadFlag = false;
+			}
+
+			filePaths.push_back(fullPath);
+			fileIndex++;
+		}
+
+		ImGui::End();
+	}
+}
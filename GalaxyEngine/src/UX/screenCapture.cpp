@@ -1,6 +1,7 @@
 #include "UI/UI.h"
 
 #include "UX/screenCapture.h"
+#include "UX/parallel_for.h"
 
 #include "parameters.h"
 
@@ -100,38 +101,36 @@ void ScreenCapture::exportMemoryFramesToDisk() {
 
 	auto startTime = std::chrono::high_resolution_clock::now();
 
-	int exportedCount = 0;
+	std::atomic<int> exportedCount{ 0 };
 	const int totalFrames = static_cast<int>(myFrames.size());
 
-#pragma omp parallel for reduction(+ : exportedCount) schedule(static)
-	for (int i = 0; i < totalFrames; ++i) {
+	std::mutex printMutex;
+
+	parallel_for(0, static_cast<size_t>(totalFrames), [&](size_t frame, int) {
+		const int i = static_cast<int>(frame);
 		try {
 			exportFrameToFile(myFrames[i], actualSavedVideoFolder,
 				actualSavedVideoName, i);
 			exportedCount++;
 
 			if (i % 100 == 0) {
-#pragma omp critical
-				{
-					printf("Exported frame %d/%d (%.1f%%)\n", i + 1, totalFrames,
-						(static_cast<float>(i + 1) / totalFrames) * 100.0f);
-				}
+				std::lock_guard<std::mutex> lock(printMutex);
+				printf("Exported frame %d/%d (%.1f%%)\n", i + 1, totalFrames,
+					(static_cast<float>(i + 1) / totalFrames) * 100.0f);
 			}
 		}
 		catch (...) {
-#pragma omp critical
-			{
-				printf("Warning: Failed to export frame %d\n", i);
-			}
+			std::lock_guard<std::mutex> lock(printMutex);
+			printf("Warning: Failed to export frame %d\n", i);
 		}
-	}
+		});
 
 	auto endTime = std::chrono::high_resolution_clock::now();
 	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
 		endTime - startTime);
 
 	printf("Successfully exported %d out of %d frames in %.2f seconds.\n",
-		exportedCount, static_cast<int>(myFrames.size()),
+		exportedCount.load(), static_cast<int>(myFrames.size()),
 		static_cast<double>(duration.count()) / 1000.0);
 }
 
@@ -408,6 +407,7 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 			if (myVar.cleanSceneAfterRecording) {
 				myParam.pParticles.clear();
 				myParam.rParticles.clear();
+				myVar.deleteHalosFlag = true;
 			}
 
 			printf("Stopped recording. File saved as '%s'\\n", outFileName.c_str());
@@ -522,6 +522,7 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 				if (myVar.cleanSceneAfterRecording) {
 					myParam.pParticles.clear();
 					myParam.rParticles.clear();
+					myVar.deleteHalosFlag = true;
 				}
 				UnloadImage(img);
 				return isFunctionRecording;
@@ -603,7 +604,7 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 		ImGui::Begin("Recording Menu", nullptr,
 			ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize);
 
-		ImGui::PushFont(myVar.robotoMediumFont);
+		ImGui::PushFont(UI::robotoMediumFont);
 
 		ImGui::SetWindowFontScale(1.5f);
 
@@ -635,6 +636,7 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 				if (myVar.cleanSceneAfterRecording) {
 					myParam.pParticles.clear();
 					myParam.rParticles.clear();
+					myVar.deleteHalosFlag = true;
 				}
 
 				printf("Recording ended via button. File saved "
@@ -646,9 +648,9 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 				ImGui::SetTooltip("Stop recording and save the video file");
 			}
 
-			ImGui::PushStyleColor(ImGuiCol_Button, UpdateVariables::colButtonRedActive);
-			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UpdateVariables::colButtonRedActiveHover);
-			ImGui::PushStyleColor(ImGuiCol_ButtonActive, UpdateVariables::colButtonRedActivePress);
+			ImGui::PushStyleColor(ImGuiCol_Button, UI::colButtonRedActive);
+			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UI::colButtonRedActiveHover);
+			ImGui::PushStyleColor(ImGuiCol_ButtonActive, UI::colButtonRedActivePress);
 
 			if (ImGui::Button("Cancel Recording",
 				ImVec2(ImGui::GetContentRegionAvail().x, 40.0f))) {
@@ -709,9 +711,9 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 					ImGui::GetStyle().Alpha * 0.5f);
 			}
 
-			ImGui::PushStyleColor(ImGuiCol_Button, UpdateVariables::colButtonRedActive);
-			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UpdateVariables::colButtonRedActiveHover);
-			ImGui::PushStyleColor(ImGuiCol_ButtonActive, UpdateVariables::colButtonRedActivePress);
+			ImGui::PushStyleColor(ImGuiCol_Button, UI::colButtonRedActive);
+			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UI::colButtonRedActiveHover);
+			ImGui::PushStyleColor(ImGuiCol_ButtonActive, UI::colButtonRedActivePress);
 
 			bool discardButtonClicked =
 				ImGui::Button(discardButtonText.c_str(),
@@ -768,7 +770,7 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 		ImGui::Begin("Save Recording?", nullptr,
 			ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize |
 			ImGuiWindowFlags_NoTitleBar);
-		ImGui::PushFont(myVar.robotoMediumFont);
+		ImGui::PushFont(UI::robotoMediumFont);
 		ImGui::SetWindowFontScale(1.5f);
 
 		ImGui::TextColored(ImVec4(1.0f, 1.0f, 1.0f, 1.0f), "Save Recording?");
@@ -1140,9 +1142,9 @@ bool ScreenCapture::screenGrab(RenderTexture2D& myParticlesTexture,
 
 		ImGui::SameLine();
 
-		ImGui::PushStyleColor(ImGuiCol_Button, UpdateVariables::colButtonRedActive);
-		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UpdateVariables::colButtonRedActiveHover);
-		ImGui::PushStyleColor(ImGuiCol_ButtonActive, UpdateVariables::colButtonRedActivePress);
+		ImGui::PushStyleColor(ImGuiCol_Button, UI::colButtonRedActive);
+		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, UI::colButtonRedActiveHover);
+		ImGui::PushStyleColor(ImGuiCol_ButtonActive, UI::colButtonRedActivePress);
 		if (ImGui::Button("Discard", ImVec2(100, 30))) {
 			if (!isFunctionRecording) {
 				// Use the centralized discard function for comprehensive cleanup
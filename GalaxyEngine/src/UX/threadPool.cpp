@@ -0,0 +1,372 @@
+#include "UX/threadPool.h"
+
+#include <algorithm>
+
+ThreadPool threadPool;
+
+// Index of the current thread in the pool it belongs to. Owners and workers set it, everything else stays outside
+static thread_local const ThreadPool* poolOfThread = nullptr;
+static thread_local int indexOfThread = -1;
+
+ThreadPool::~ThreadPool() {
+
+	stopWorkers();
+
+	// Background tasks nobody picked up before exit run here, so their groups still reach zero
+	for (std::unique_ptr<WorkQueue>& queue : queues) {
+		for (Task& task : queue->tasks) {
+			task.function();
+			task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+		}
+		queue->tasks.clear();
+	}
+}
+
+int ThreadPool::currentThread() const {
+	return poolOfThread == this ? indexOfThread : -1;
+}
+
+void ThreadPool::resize(int threads) {
+
+	threads = std::max(1, threads);
+
+	poolOfThread = this;
+	indexOfThread = 0;
+
+	if (threads == threadCount && !queues.empty()) {
+		return;
+	}
+
+	stopWorkers();
+
+	// Only background tasks can still be queued here, they move to the new queues
+	std::vector<Task> carried;
+	for (std::unique_ptr<WorkQueue>& queue : queues) {
+		for (Task& task : queue->tasks) {
+			carried.push_back(std::move(task));
+		}
+	}
+
+	threadCount = threads;
+
+	// One worker even when loops run on the owner alone, so background tasks never block the owner
+	const int queueCount = std::max(threadCount, 2);
+
+	queues.clear();
+	for (int t = 0; t < queueCount; t++) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	isStopping.store(false);
+
+	for (int t = 1; t < queueCount; t++) {
+		workers.emplace_back([this, t]() {
+			poolOfThread = this;
+			indexOfThread = t;
+			workerLoop(t);
+			});
+	}
+
+	for (Task& task : carried) {
+		push(queueCount - 1, std::move(task));
+	}
+}
+
+void ThreadPool::stopWorkers() {
+
+	if (workers.empty()) {
+		return;
+	}
+
+	isStopping.store(true);
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		workEpoch.fetch_add(1);
+	}
+	sleepCondition.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	workers.clear();
+}
+
+void ThreadPool::push(int thread, Task task) {
+
+	WorkQueue& queue = *queues[thread];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+		queue.count.fetch_add(1, std::memory_order_release);
+	}
+
+	// A worker going to sleep counts itself and then checks the epoch, this bumps the epoch and then checks the count,
+	// so one of the two sees the other. Taking sleepMutex makes sure a counted worker is already waiting
+	workEpoch.fetch_add(1);
+
+	if (sleepingWorkers.load() > 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		sleepCondition.notify_all();
+	}
+}
+
+bool ThreadPool::claimBackground() {
+
+	// Counts first and checks the stop after, stopWorkers() sets the stop and workers check the count after, so a
+	// worker leaving can't miss a task taken at the same time. Called with the queue locked
+	runningBackground.fetch_add(1);
+
+	if (isStopping.load()) {
+		runningBackground.fetch_sub(1);
+		return false;
+	}
+
+	return true;
+}
+
+bool ThreadPool::pop(int thread, Task& task, bool rangeOnly) {
+
+	WorkQueue& queue = *queues[thread];
+
+	if (queue.count.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.tasks.empty()) {
+		return false;
+	}
+
+	if (!queue.tasks.back().job && (rangeOnly || !claimBackground())) {
+		return false;
+	}
+
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+	queue.count.fetch_sub(1, std::memory_order_release);
+
+	return true;
+}
+
+bool ThreadPool::steal(int thread, Task& task, bool rangeOnly) {
+
+	const int queueCount = static_cast<int>(queues.size());
+
+	for (int offset = 1; offset < queueCount; offset++) {
+		WorkQueue& queue = *queues[(thread + offset) % queueCount];
+
+		if (queue.count.load(std::memory_order_acquire) == 0) {
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.tasks.empty()) {
+			continue;
+		}
+
+		// Range tasks index per thread buffers sized for their job, threads past that size leave them alone
+		Task& oldest = queue.tasks.front();
+		if (oldest.job ? thread >= oldest.job->maxThreads : (rangeOnly || !claimBackground())) {
+			continue;
+		}
+
+		task = std::move(oldest);
+		queue.tasks.pop_front();
+		queue.count.fetch_sub(1, std::memory_order_release);
+
+		return true;
+	}
+
+	return false;
+}
+
+bool ThreadPool::findTask(int thread, Task& task, bool rangeOnly) {
+	return pop(thread, task, rangeOnly) || steal(thread, task, rangeOnly);
+}
+
+void ThreadPool::execute(int thread, Task& task) {
+
+	if (task.job) {
+		runRange(thread, *task.job, task.begin, task.end);
+		return;
+	}
+
+	task.function();
+	runningBackground.fetch_sub(1);
+
+	task.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::runRange(int thread, RangeJob& job, size_t begin, size_t end) {
+
+	WorkQueue& queue = *queues[thread];
+
+	while (begin < end) {
+		size_t count = end - begin;
+
+		// Only split while this thread has nothing queued, an idle thread will steal the half
+		if (count > job.minGrain && job.maxThreads > 1 && queue.count.load(std::memory_order_acquire) == 0) {
+			size_t middle = begin + count / 2;
+
+			Task task;
+			task.job = &job;
+			task.begin = middle;
+			task.end = end;
+			push(thread, std::move(task));
+
+			end = middle;
+			continue;
+		}
+
+		size_t chunkEnd = begin + std::min(count, job.minGrain);
+
+		job.invoke(job.func, begin, chunkEnd, thread);
+
+		// Last access to the job, the owner may return as soon as this reaches zero
+		job.remaining.fetch_sub(chunkEnd - begin, std::memory_order_acq_rel);
+
+		begin = chunkEnd;
+	}
+}
+
+void ThreadPool::runRangeJob(RangeJob& job, size_t begin, size_t end, int maxThreads, size_t minGrain) {
+
+	if (end <= begin) {
+		return;
+	}
+
+	const size_t count = end - begin;
+	const int thread = currentThread();
+
+	maxThreads = std::min(maxThreads, threadCount);
+
+	if (thread < 0 || maxThreads <= 1) {
+		job.invoke(job.func, begin, end, 0);
+		return;
+	}
+
+	// Around 32 pieces per thread at the finest, enough to even out clustered work without drowning in splits
+	if (minGrain == 0) {
+		minGrain = std::max<size_t>(1, count / (static_cast<size_t>(maxThreads) * 32));
+	}
+
+	job.minGrain = minGrain;
+	job.maxThreads = maxThreads;
+	job.remaining.store(count, std::memory_order_release);
+
+	// A background task on a worker past maxThreads can't index the job's buffers, it hands the range to the lower
+	// threads and waits
+	const bool canHelp = thread < maxThreads;
+
+	if (canHelp) {
+		runRange(thread, job, begin, end);
+	}
+	else {
+		Task task;
+		task.job = &job;
+		task.begin = begin;
+		task.end = end;
+		push(thread, std::move(task));
+	}
+
+	// Helps with loop pieces only, a long background task picked up here would stall the loop
+	while (job.remaining.load(std::memory_order_acquire) > 0) {
+		Task task;
+		if (canHelp && findTask(thread, task, true)) {
+			execute(thread, task);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ThreadPool::run(TaskGroup& group, std::function<void()> task) {
+
+	const int thread = currentThread();
+
+	if (queues.empty()) {
+		task();
+		return;
+	}
+
+	group.pending.fetch_add(1, std::memory_order_acq_rel);
+
+	Task queued;
+	queued.group = &group;
+	queued.function = std::move(task);
+
+	// Kept off the owner's queue, a queued task there would stop its loops from splitting
+	push(thread > 0 ? thread : static_cast<int>(queues.size()) - 1, std::move(queued));
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+
+	const int thread = currentThread();
+
+	while (group.pending.load(std::memory_order_acquire) > 0) {
+		Task task;
+		if (thread >= 0 && findTask(thread, task, false)) {
+			execute(thread, task);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ThreadPool::workerLoop(int thread) {
+
+	// Spinning a little before sleeping catches the next loop of the same frame without a wake up
+	constexpr int spinRounds = 256;
+
+	while (true) {
+
+		// Once stopping, only loop pieces are taken, queued background tasks carry over to the new workers
+		const bool isDraining = isStopping.load(std::memory_order_acquire);
+
+		Task task;
+		if (findTask(thread, task, isDraining)) {
+			execute(thread, task);
+			continue;
+		}
+
+		// A background task still running may hand its loop to this thread
+		if (isDraining) {
+			if (runningBackground.load() == 0) {
+				return;
+			}
+			std::this_thread::yield();
+			continue;
+		}
+
+		uint64_t epoch = workEpoch.load(std::memory_order_acquire);
+
+		bool found = false;
+		for (int spin = 0; spin < spinRounds && !found; spin++) {
+			found = findTask(thread, task, false);
+			if (!found) {
+				std::this_thread::yield();
+			}
+		}
+
+		if (found) {
+			execute(thread, task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers.fetch_add(1);
+		sleepCondition.wait(lock, [&]() {
+			return isStopping.load() || workEpoch.load() != epoch;
+			});
+		sleepingWorkers.fetch_sub(1);
+	}
+}
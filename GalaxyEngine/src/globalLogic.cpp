@@ -2,28 +2,14 @@
 #include "UX/parallel_for.h"
 
 UpdateParameters myParam;
-UpdateVariables myVar;
 UI myUI;
-Physics physics;
 ParticleSpaceship ship;
-SPH sph;
 SaveSystem save;
 GESound geSound;
-Lighting lighting;
 CopyPaste copyPaste;
 
 Field field;
 
-std::vector<Node> globalNodes;
-
-uint32_t globalId = 0;
-uint32_t globalShapeId = 1;
-uint32_t globalWallId = 1;
-// If someday light id gets added, don't forget to add the id to the copy paste code too
-
-std::unordered_map<uint32_t, size_t> NeighborSearch::idToIndex;
-
-
 //void flattenQuadtree(Quadtree* node, std::vector<Quadtree*>& flatList) {
 //	if (!node) return;
 //
@@ -629,8 +615,7 @@ void gpuGravity() {
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboPData);
 		float* ptrPos = (float*)glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
 
-#pragma omp parallel for schedule(dynamic)
-		for (size_t i = 0; i < myParam.pParticles.size(); i++) {
+		parallel_for(0, myParam.pParticles.size(), myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1, [&](size_t i, int) {
 
 			/*myParam.pParticles[i].pos.x = ptrPos[i];
 			myParam.pParticles[i].pos.y = ptrPos[i + myParam.pParticles.size()];
@@ -640,7 +625,7 @@ void gpuGravity() {
 
 			myParam.pParticles[i].acc.x = ptrPos[i + 2 * myParam.pParticles.size()];
 			myParam.pParticles[i].acc.y = ptrPos[i + 3 * myParam.pParticles.size()];
-		}
+			});
 
 		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	}
@@ -675,324 +660,7 @@ void freeGPUMemory() {}
 
 #endif
 
-// -------- This is an unused quadtree creation method I made for learning purposes. It builds the quadtree from Morton keys -------- //
-
-//struct Barrier {
-//	uint32_t idx;
-//	int level;
-//
-//	Barrier(uint32_t idx, int level) {
-//		this->idx = idx;
-//		this->level = level;
-//	}
-//};
-//
-//struct MortonData {
-//	uint64_t key;
-//	float mass;
-//	glm::vec2 pos;
-//};
-//
-//std::vector<Node> TestTree::nodesTest;
-//
-//void mortonToQuadtree() {
-//
-//	std::vector<MortonData> compactedMorton;
-//
-//	float currentKeyMass = 0.0f;
-//	uint32_t duplicateAmount = 0;
-//
-//	for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-//
-//		if (!compactedMorton.empty()) {
-//			if (myParam.pParticles[i].mortonKey != compactedMorton.back().key) {
-//
-//				if (duplicateAmount > 0) {
-//					compactedMorton.back().mass += currentKeyMass;
-//				}
-//
-//				compactedMorton.push_back({ myParam.pParticles[i].mortonKey, myParam.pParticles[i].mass, myParam.pParticles[i].pos });
-//
-//				currentKeyMass = 0.0f;
-//				duplicateAmount = 0;
-//			}
-//			else {
-//				duplicateAmount++;
-//				currentKeyMass += myParam.pParticles[i].mass;
-//			}
-//		}
-//		else {
-//			compactedMorton.push_back({ myParam.pParticles[i].mortonKey, myParam.pParticles[i].mass, myParam.pParticles[i].pos });
-//		}
-//	}
-//
-//	int currentP = 0;
-//
-//	int start = 0;
-//	int end = compactedMorton.size();
-//
-//	int level = 0;
-//
-//	int totalBits = 18; // 18 bits per axis
-//
-//	std::vector<Barrier> barriers;
-//
-//	glm::vec2 min = glm::vec2(std::numeric_limits<float>::max());
-//	glm::vec2 max = glm::vec2(std::numeric_limits<float>::lowest());
-//
-//	for (const ParticlePhysics& particle : myParam.pParticles) {
-//		min = glm::min(min, particle.pos);
-//		max = glm::max(max, particle.pos);
-//	}
-//
-//	float boundingBoxSize = glm::max(max.x - min.x, max.y - min.y);
-//
-//	glm::vec2 center = (min + max) * 0.5f;
-//
-//	glm::vec2 boundingBoxPos = center - boundingBoxSize * 0.5f;
-//
-//	TestTree::nodesTest.clear();
-//
-//	TestTree::nodesTest.emplace_back(Node({ boundingBoxPos.x, boundingBoxPos.y }, boundingBoxSize, 0.0f, { 0.0f, 0.0f }, 0, 0));
-//
-//	while (currentP < compactedMorton.size()) {
-//
-//		float nodeMass = 0.0f;
-//		glm::vec2 nodeCoM = { 0.0f, 0.0f };
-//
-//		for (size_t i = start; i < end; i++) {
-//
-//			nodeMass += compactedMorton[i].mass;
-//
-//			nodeCoM += compactedMorton[i].pos * compactedMorton[i].mass;
-//
-//			if (i + 1 >= compactedMorton.size()) {
-//
-//				nodeCoM /= nodeMass;
-//
-//				Node node = { TestTree::nodesTest[0].pos, TestTree::nodesTest[0].size, nodeMass, nodeCoM, 1, level + 1};
-//
-//				for (int j = 0; j < level + 1; j++) {
-//
-//					int internalShift = (totalBits - 1 - j) * 2;
-//					bool lr = (compactedMorton[start].key >> internalShift) & 1u;
-//					bool ud = (compactedMorton[start].key >> (internalShift + 1)) & 1u;
-//
-//					node.pos.x = node.pos.x + (lr ? (node.size * 0.5f) : 0.0f);
-//					node.pos.y = node.pos.y + (ud ? (node.size * 0.5f) : 0.0f);
-//
-//					node.size *= 0.5f;
-//				}
-//
-//				TestTree::nodesTest.push_back(node);
-//
-//				TestTree::nodesTest[0].mass += nodeMass;
-//				TestTree::nodesTest[0].CoM += nodeCoM;
-//
-//				nodeMass = 0.0f;
-//				nodeCoM = { 0.0f, 0.0f };
-//
-//				level++;
-//				currentP++;
-//				end = compactedMorton.size();
-//				break;
-//			}
-//
-//			if (!barriers.empty() && barriers.back().idx == i + 1) {
-//
-//				nodeCoM /= nodeMass;
-//
-//				uint32_t next = end - start;
-//
-//				bool isLeaf = next == 1 ? 1 : 0;
-//
-//				Node node = { TestTree::nodesTest[0].pos, TestTree::nodesTest[0].size, nodeMass, nodeCoM, next, level + 1};
-//
-//				for (int j = 0; j < level + 1; j++) {
-//
-//					int internalShift = (totalBits - 1 - j) * 2;
-//					bool lr = (compactedMorton[start].key >> internalShift) & 1u;
-//					bool ud = (compactedMorton[start].key >> (internalShift + 1)) & 1u;
-//
-//					node.pos.x = node.pos.x + (lr ? (node.size * 0.5f) : 0.0f);
-//					node.pos.y = node.pos.y + (ud ? (node.size * 0.5f) : 0.0f);
-//
-//					node.size *= 0.5f;
-//				}
-//
-//				TestTree::nodesTest.push_back(node);
-//
-//				TestTree::nodesTest[0].mass += nodeMass;
-//				TestTree::nodesTest[0].CoM += nodeCoM;
-//
-//				nodeMass = 0.0f;
-//				nodeCoM = { 0.0f, 0.0f };
-//
-//				int prevShift = (totalBits - 1 - level) * 2;
-//
-//				unsigned int bits1 = (compactedMorton[i].key >> prevShift) & 0x3FFFFu;
-//				unsigned int bits2 = (compactedMorton[i - 1].key >> prevShift) & 0x3FFFFu;
-//
-//				if (bits1 == bits2) {
-//					level++;
-//
-//					currentP = start;
-//
-//					end = barriers.back().idx;
-//
-//					break;
-//				}
-//
-//				level = barriers.back().level;
-//
-//				if (barriers.size() > 1) {
-//					end = barriers.at(barriers.size() - 2).idx;
-//				}
-//				else {
-//					end = compactedMorton.size();
-//				}
-//
-//				currentP = barriers.back().idx;
-//
-//				start = barriers.back().idx;
-//
-//				TestTree::nodesTest[barriers.back().idx].next = TestTree::nodesTest.size();
-//
-//				barriers.pop_back();
-//
-//				break;
-//			}
-//
-//			int shift = (totalBits - 1 - level) * 2;
-//
-//			unsigned int bits1 = (compactedMorton[i].key >> shift) & 0b11u;
-//			unsigned int bits2 = (compactedMorton[i + 1].key >> shift) & 0b11u;
-//
-//			if (bits1 != bits2 && i + 1 != end) {
-//
-//				nodeCoM /= nodeMass;
-//
-//				Node node = { TestTree::nodesTest[0].pos, TestTree::nodesTest[0].size, nodeMass, nodeCoM, 1, level + 1};
-//
-//				for (int j = 0; j < level + 1; j++) {
-//
-//					int internalShift = (totalBits - 1 - j) * 2;
-//					bool lr = (compactedMorton[start].key >> internalShift) & 1u;
-//					bool ud = (compactedMorton[start].key >> (internalShift + 1)) & 1u;
-//
-//					node.pos.x = node.pos.x + (lr ? (node.size * 0.5f) : 0.0f);
-//					node.pos.y = node.pos.y + (ud ? (node.size * 0.5f) : 0.0f);
-//
-//					node.size *= 0.5f;
-//				}
-//
-//				TestTree::nodesTest.push_back(node);
-//
-//				TestTree::nodesTest[0].mass += nodeMass;
-//				TestTree::nodesTest[0].CoM += nodeCoM;
-//
-//				nodeMass = 0.0f;
-//				nodeCoM = { 0.0f, 0.0f };
-//
-//				end = i + 1;
-//
-//				if (end - start > 1) {
-//
-//					barriers.push_back(Barrier(end, level));
-//
-//					level++;
-//					currentP = start;
-//				}
-//				else if (end - start == 1) {
-//					start = end;
-//
-//					currentP = start;
-//
-//					if (!barriers.empty()) {
-//						end = barriers.back().idx;
-//					}
-//					else {
-//						end = compactedMorton.size();
-//					}
-//				}
-//
-//				break;
-//			}
-//		}
-//	}
-//
-//	TestTree::nodesTest[0].CoM /= TestTree::nodesTest[0].mass;
-//
-//	for (int i = totalBits; i >= 1; i--) {
-//		for (int j = 0; j < TestTree::nodesTest.size(); j++) {
-//			if (TestTree::nodesTest[j].level != i) continue;
-//
-//			int currentLevel = TestTree::nodesTest[j].level;
-//			int count = 0;
-//
-//			for (int k = j + 1; k < TestTree::nodesTest.size(); k++) {
-//				if (TestTree::nodesTest[k].level <= currentLevel) break;
-//
-//				if (TestTree::nodesTest[k].level == currentLevel + 1) {
-//					count += 1 + TestTree::nodesTest[k].next;
-//				}
-//			}
-//
-//			TestTree::nodesTest[j].next = count;
-//		}
-//	}
-//
-//
-//	/*static int idx = 1;
-//
-//	if (IO::shortcutPress(KEY_LEFT)) {
-//		idx--;
-//	}
-//	else if (IO::shortcutPress(KEY_RIGHT)) {
-//		idx++;
-//	}*/
-//
-//	/*std::cout << "Current Idx: " << idx << std::endl;*/
-//
-//	//for (size_t i = 0; i < TestTree::nodesTest.size(); i++) {
-//	//	//if (i == idx) {
-//	//		DrawRectangleLinesEx({ TestTree::nodesTest[i].pos.x, TestTree::nodesTest[i].pos.y, TestTree::nodesTest[i].size, TestTree::nodesTest[i].size }, 0.04f, RED);
-//
-//
-//	//		/*DrawText(TextFormat("%i", i), TestTree::nodesTest[i].pos.x + TestTree::nodesTest[i].size * 0.5f,
-//	//			TestTree::nodesTest[i].pos.y + TestTree::nodesTest[i].size * 0.5f, 5.0f, { 255, 255, 255, 128 });*/
-//
-//	//		/*if (TestTree::nodesTest[i].mass > 0.0f) {
-//	//			DrawCircleV({ TestTree::nodesTest[i].CoM.x, TestTree::nodesTest[i].CoM.y }, 2.0f, { 180,50,50,128 });
-//	//		}*/
-//	//	//}
-//	//}
-//}
-
-float boundingBoxSize = 0.0f;
-glm::vec2 boundingBoxPos = { 0.0f, 0.0f };
-
-glm::vec3 boundingBox() {
-	glm::vec2 min = glm::vec2(std::numeric_limits<float>::max());
-	glm::vec2 max = glm::vec2(std::numeric_limits<float>::lowest());
-
-	for (const ParticlePhysics& particle : myParam.pParticles) {
-		min = glm::min(min, particle.pos);
-		max = glm::max(max, particle.pos);
-	}
-
-	boundingBoxSize = glm::max(max.x - min.x, max.y - min.y);
-
-	glm::vec2 center = (min + max) * 0.5f;
-
-	boundingBoxPos = center - boundingBoxSize * 0.5f;
-
-	return { boundingBoxPos.x, boundingBoxPos.y, boundingBoxSize };
-}
-
-uint32_t gridRootIndex;
-
-glm::vec3 bb = { 0.0f, 0.0f, 0.0f };
+FuturePreview futurePreview;
 
 void updateScene() {
 
@@ -1021,26 +689,9 @@ void updateScene() {
 	}
 
 	if (myVar.timeFactor != 0.0f) {
-		bb = boundingBox();
-
-		/*if (myVar.timeFactor >= 0) {
-			myParam.morton.computeMortonKeys(myParam.pParticles, bb);
-			myParam.morton.sortParticlesByMortonKey(myParam.pParticles, myParam.rParticles);
-		}*/
-
-		/*if (!myParam.pParticles.empty()) {
-			mortonToQuadtree();
-		}*/
-
-		globalNodes.clear();
-
-		Quadtree root(myParam.pParticles, myParam.rParticles, bb);
-
-		gridRootIndex = 0;
+		pipeline.buildTree(myVar, myParam);
 	}
 
-	myVar.gridExists = gridRootIndex != -1 && !globalNodes.empty();
-
 	myVar.halfDomainWidth = myVar.domainSize.x * 0.5f;
 	myVar.halfDomainHeight = myVar.domainSize.y * 0.5f;
 
@@ -1048,6 +699,11 @@ void updateScene() {
 	myVar.gravityRampTime = 0.0f;
 	myVar.G = 6.674e-11 * myVar.gravityMultiplier;
 
+	// A tree build reorders the particles, so it has to happen before the neighbor search indexes them
+	if (myVar.drawQuadtree || myParam.particlesSpawning.needsTree(myVar)) {
+		pipeline.requireTree(myVar, myParam);
+	}
+
 	if (myVar.drawQuadtree) {
 		for (uint32_t i = 0; i < globalNodes.size(); i++) {
 
@@ -1063,50 +719,17 @@ void updateScene() {
 		}
 	}
 
-	for (ParticleRendering& rParticle : myParam.rParticles) {
-		rParticle.totalRadius = rParticle.size * myVar.particleTextureHalfSize * myVar.particleSizeMultiplier;
-	}
-
-	for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-		myParam.pParticles[i].neighborIds.clear();
-	}
-
 	myParam.brush.brushSize();
 
-	if (myVar.isMergerEnabled) {
-
-		// Heuristics for performance
-		constexpr float minCellSize = 2.0f;
-		constexpr float maxCellSize = 80.0f;
-
-		myParam.neighborSearch.cellSize = 0.0f;
-
-		for (size_t i = 0; i < myParam.pParticles.size(); ++i) {
-			auto& rP = myParam.rParticles[i];
-
-			if (rP.isDarkMatter) {
-				continue;
-			}
-
-			float candidate = rP.totalRadius * 2.0f;
-
-			myParam.neighborSearch.cellSize = std::max(myParam.neighborSearch.cellSize, candidate);
-		}
-
-		myParam.neighborSearch.cellSize = std::clamp(myParam.neighborSearch.cellSize, minCellSize, maxCellSize);
-	}
-	else {
-		myParam.neighborSearch.cellSize = 3.0f;
-	}
-
-	if (myVar.constraintsEnabled || myVar.drawConstraints || myVar.visualizeMesh || myVar.isBrushDrawing || myVar.isMergerEnabled) {
-		NeighborSearch::idToI(myParam.pParticles);
-		myParam.neighborSearch.neighborSearchHash(myParam.pParticles, myParam.rParticles);
-	}
+	pipeline.prepareNeighbors(myVar, myParam);
 
 	myParam.particlesSpawning.particlesInitialConditions(physics, myVar, myParam);
 
 	if (myVar.constraintsEnabled && !myVar.isBrushDrawing) {
+		if (IO::shortcutPress(KEY_P)) {
+			myVar.constraintAllSolids = true;
+		}
+
 		physics.createConstraints(myParam.pParticles, myParam.rParticles, myVar.constraintAfterDrawingFlag, myVar);
 	}
 	else if (!myVar.constraintsEnabled && !myVar.isBrushDrawing) {
@@ -1120,93 +743,38 @@ void updateScene() {
 	if ((myVar.timeFactor > 0.0f && myVar.gridExists) || myVar.isGPUEnabled) {
 
 		if (!myVar.isGPUEnabled) {
-			for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-				myParam.pParticles[i].acc = { 0.0f, 0.0f };
-			}
-
-			/*for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-				if ((myParam.rParticles[i].isBeingDrawn && myVar.isBrushDrawing && myVar.isSPHEnabled)
-					|| myParam.rParticles[i].isPinned) {
-					continue;
-				}
-
-				myParam.pParticles[i].pos += myParam.pParticles[i].vel * myVar.timeFactor
-					+ 0.5f * myParam.pParticles[i].prevAcc * myVar.timeFactor * myVar.timeFactor;
-			}*/
-
-#if defined(EMSCRIPTEN)
-			const size_t count = myParam.pParticles.size();
-			const int thread_count = clamp_thread_count(count, myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1);
-			auto gravity_task = [&](size_t i, int) {
-				if (!((myParam.rParticles[i].isBeingDrawn && myVar.isBrushDrawing && myVar.isSPHEnabled) || myParam.rParticles[i].isPinned)) {
-					glm::vec2 netForce = physics.calculateForceFromGrid(myParam.pParticles, myVar, myParam.pParticles[i]);
-					myParam.pParticles[i].acc = netForce / myParam.pParticles[i].mass;
-				}
-			};
-			parallel_for(0, count, thread_count, gravity_task);
-#else
-#pragma omp parallel for schedule(dynamic)
-			for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-				if (!((myParam.rParticles[i].isBeingDrawn && myVar.isBrushDrawing && myVar.isSPHEnabled) || myParam.rParticles[i].isPinned)) {
-					glm::vec2 netForce = physics.calculateForceFromGrid(myParam.pParticles, myVar, myParam.pParticles[i]);
-					myParam.pParticles[i].acc = netForce / myParam.pParticles[i].mass;
-				}
-			}
-#endif
-
-			/*for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-				for (size_t j = i + 1; j < myParam.pParticles.size(); j++) {
-					glm::vec2 d = myParam.pParticles[j].pos - myParam.pParticles[i].pos;
-					float rSq = glm::dot(d, d) + myVar.softening * myVar.softening;
-					float r = sqrt(rSq);
-
-					glm::vec2 forceDir = d / r;
-					float accFactor = myVar.G / rSq;
-
-					myParam.pParticles[i].acc += accFactor * myParam.pParticles[j].mass * forceDir;
-					myParam.pParticles[j].acc -= accFactor * myParam.pParticles[i].mass * forceDir;
-				}
-			}*/
-
-			/*for (size_t i = 0; i < myParam.pParticles.size(); i++) {
-				if ((myParam.rParticles[i].isBeingDrawn && myVar.isBrushDrawing && myVar.isSPHEnabled)
-					|| myParam.rParticles[i].isPinned) {
-					continue;
-				}
-
-				myParam.pParticles[i].vel += 0.5f * (myParam.pParticles[i].prevAcc + myParam.pParticles[i].acc)
-					* myVar.timeFactor;
-
-				myParam.pParticles[i].prevAcc = myParam.pParticles[i].acc;
-			}*/
+			pipeline.computeGravity(myVar, myParam, physics);
 		}
 		else {
 			gpuGravity();
-		}
+			pipeline.addHaloGravity(myVar, myParam, physics);
 
-		if (myVar.isMergerEnabled)
-			physics.mergerSolver(myParam.pParticles, myParam.rParticles, myVar);
-
-		if (myVar.isSPHEnabled) {
-			sph.pcisphSolver(myParam.pParticles, myParam.rParticles, myVar.timeFactor, myVar.domainSize, myVar.sphGround);
+			myVar.averageInteractions = 0.0f;
+			myVar.maxInteractions = 0;
 		}
 
-		physics.constraints(myParam.pParticles, myParam.rParticles, myVar);
+		pipeline.conductHeat(myVar, myParam, physics);
 
-		ship.spaceshipLogic(myParam.pParticles, myParam.rParticles, myVar.isShipGasEnabled);
+		pipeline.solveInteractions(myVar, myParam, physics, sph);
 
-		physics.physicsUpdate(myParam.pParticles, myParam.rParticles, myVar, myVar.sphGround);
+		ship.spaceshipLogic(myParam.pParticles, myParam.rParticles, myVar.isShipGasEnabled);
 
-		if (myVar.isTempEnabled) {
-			physics.temperatureCalculation(myParam.pParticles, myParam.rParticles, myVar);
-		}
+		pipeline.integrate(myVar, myParam, physics);
 
 	}
 	else {
 		physics.constraints(myParam.pParticles, myParam.rParticles, myVar);
 	}
 
-	field.gpuGravityDisplay(myParam, myVar);
+	// The mesh already holds the field, the display samples it instead of summing every particle per cell
+	if (myVar.isPMEnabled && !myVar.isGPUEnabled && pipeline.mesh.gridSize > 0) {
+		field.solvedGravityDisplay(myVar, [&](glm::vec2 pos) {
+			return glm::length(pipeline.mesh.interpolate(pos)) * Field::gravityDisplayMassScale;
+			});
+	}
+	else {
+		field.gpuGravityDisplay(myParam, myVar);
+	}
 
 	if ((myVar.isDensitySizeEnabled || myParam.colorVisuals.densityColor) && myVar.timeFactor > 0.0f && !myVar.isGravityFieldEnabled) {
 		myParam.neighborSearch.neighborSearch(myParam.pParticles, myParam.rParticles, myVar.particleSizeMultiplier, myVar.particleTextureHalfSize);
@@ -1237,6 +805,20 @@ void updateScene() {
 
 	myParam.particleDeletion.deleteStrays(myParam.pParticles, myParam.rParticles, myVar.isSPHEnabled);
 
+	if (myVar.freezeDarkMatterFlag) {
+		physics.analyticHalos.freezeDarkMatter(myParam.pParticles, myParam.rParticles, myVar);
+		myVar.freezeDarkMatterFlag = false;
+	}
+
+	// Set by Delete Halos and by the explicit scene resets. A scene with only halos, or a save that has them but no
+	// particles, keeps them
+	if (myVar.deleteHalosFlag) {
+		physics.analyticHalos.halos.clear();
+		myVar.deleteHalosFlag = false;
+	}
+
+	futurePreview.update(myParam, myVar, physics);
+
 	myParam.brush.particlesAttractor(myVar, myParam);
 
 	myParam.brush.particlesSpinner(myVar, myParam);
@@ -1283,6 +865,8 @@ void updateScene() {
 	}*/
 
 	myParam.myCamera.hasCamMoved();
+
+	frameArena.endFrame();
 }
 
 void drawConstraints() {
@@ -1523,6 +1107,10 @@ void drawScene(Texture2D& particleBlurTex, RenderTexture2D& myRayTracingTexture,
 	}
 	DrawRectangleLinesEx({ 0,0, static_cast<float>(myVar.domainSize.x), static_cast<float>(myVar.domainSize.y) }, 3, GRAY);
 
+	if (myVar.isFutureOrbitsEnabled) {
+		futurePreview.draw(myVar);
+	}
+
 	// Z-Curves debug toggle
 	if (myParam.pParticles.size() > 1 && myVar.drawZCurves) {
 		for (size_t i = 0; i < myParam.pParticles.size() - 1; i++) {
@@ -1683,16 +1271,18 @@ void loadConfig() {
 }
 
 void enableMultiThreading() {
-	if (myVar.isMultiThreadingEnabled) {
-		#if defined(_OPENMP)
-		omp_set_num_threads(std::max(1, myVar.threadsAmount));
-		#endif
-	}
-	else {
-		#if defined(_OPENMP)
-		omp_set_num_threads(1);
-		#endif
+
+	const int threads = myVar.isMultiThreadingEnabled ? std::max(1, myVar.threadsAmount) : 1;
+
+	// Resizing waits for the running background tasks. A preview run can take seconds, it restarts next frame instead
+	if (threads != threadPool.size()) {
+		futurePreview.cancel();
 	}
+
+	#if defined(_OPENMP)
+	omp_set_num_threads(threads);
+	#endif
+	threadPool.resize(threads);
 }
 
 void fullscreenToggle(int& lastScreenWidth, int& lastScreenHeight,
@@ -0,0 +1,372 @@
+#include "simulationState.h"
+#include "Physics/gravityKernel.h"
+#include "Physics/materialsSPH.h"
+#include "UX/parallel_for.h"
+#include "UX/saveSystem.h"
+
+// Steps a saved scene without opening a window and prints how long each physics phase took.
+// With --fmm-benchmark it instead compares the FMM solver at every order, and Barnes-Hut at the scene's theta and with
+// the relative opening criterion at a few accuracies, against direct summation on a sample of particles. The particle
+// mesh is compared too at a few mesh sizes, and TreePM in looping space. In looping space the meshes include every
+// periodic copy while the reference only takes the nearest one, so part of their error is that.
+// --kernel forces a path of the batched gravity kernel instead of the widest one the CPU supports.
+// Usage: ge-headless <scene.bin> [--steps N] [--threads T] [--kernel scalar|sse|avx2|neon] [--fmm-benchmark]
+
+// The particles the runner steps. The app keeps them in myParam next to its UI state
+static SimulationParameters simParam;
+
+static void printUsage() {
+	std::cout << "Usage: ge-headless <scene.bin> [--steps N] [--threads T] [--kernel scalar|sse|avx2|neon] [--fmm-benchmark]"
+		<< std::endl;
+}
+
+static void printAccuracy(const char* name, double ms, const std::vector<glm::dvec2>& exact, const std::vector<uint32_t>& samples,
+	const std::vector<ParticlePhysics>& pParticles) {
+
+	double sumSq = 0.0;
+	double maxError = 0.0;
+
+	for (size_t k = 0; k < samples.size(); k++) {
+		glm::dvec2 acc = glm::dvec2(pParticles[samples[k]].acc);
+		double exactLength = glm::length(exact[k]);
+
+		if (exactLength <= 0.0) {
+			continue;
+		}
+
+		double error = glm::length(acc - exact[k]) / exactLength;
+		sumSq += error * error;
+		maxError = std::max(maxError, error);
+	}
+
+	std::cout << std::left << std::setw(14) << name
+		<< std::right << std::setw(12) << std::fixed << std::setprecision(3) << ms << " ms"
+		<< std::setw(14) << std::scientific << std::setprecision(3) << std::sqrt(sumSq / samples.size()) << " rms"
+		<< std::setw(14) << maxError << " max" << std::defaultfloat << std::endl;
+}
+
+static void runFmmBenchmark() {
+
+	myVar.halfDomainWidth = myVar.domainSize.x * 0.5f;
+	myVar.halfDomainHeight = myVar.domainSize.y * 0.5f;
+	myVar.G = 6.674e-11 * myVar.gravityMultiplier;
+
+	pipeline.buildTree(myVar, simParam);
+	pipeline.requireTree(myVar, simParam);
+
+	std::vector<ParticlePhysics>& pParticles = simParam.pParticles;
+	const std::vector<ParticleRendering>& rParticles = simParam.rParticles;
+
+	const uint32_t particleCount = static_cast<uint32_t>(pParticles.size());
+	physics.particleInteractions.resize(particleCount);
+	const uint32_t sampleCount = std::min<uint32_t>(1000, particleCount);
+
+	std::vector<uint32_t> samples(sampleCount);
+	for (uint32_t k = 0; k < sampleCount; k++) {
+		samples[k] = static_cast<uint32_t>(static_cast<uint64_t>(k) * particleCount / sampleCount);
+	}
+
+	// Same force law as the solvers: softened, periodic when enabled, coincident particles skipped
+	std::vector<glm::dvec2> exact(sampleCount);
+	const double softeningSq = static_cast<double>(myVar.softening) * myVar.softening;
+
+	parallel_for(0, sampleCount, [&](size_t k, int) {
+		glm::vec2 pos = pParticles[samples[k]].pos;
+		glm::dvec2 acc = { 0.0, 0.0 };
+
+		for (uint32_t j = 0; j < particleCount; j++) {
+			glm::vec2 d = pParticles[j].pos - pos;
+
+			if (myVar.isPeriodicBoundaryEnabled) {
+				d.x -= myVar.domainSize.x * ((d.x > myVar.halfDomainWidth) - (d.x < -myVar.halfDomainWidth));
+				d.y -= myVar.domainSize.y * ((d.y > myVar.halfDomainHeight) - (d.y < -myVar.halfDomainHeight));
+			}
+
+			if (std::fabs(d.x) < 0.001f && std::fabs(d.y) < 0.001f) {
+				continue;
+			}
+
+			glm::dvec2 dd = glm::dvec2(d);
+			double invDistance = 1.0 / std::sqrt(dd.x * dd.x + dd.y * dd.y + softeningSq);
+			acc += dd * (myVar.G * pParticles[j].mass * invDistance * invDistance * invDistance);
+		}
+
+		exact[k] = acc;
+		});
+
+	std::cout << "Samples: " << sampleCount << std::endl;
+
+	// Every solver overwrites acc, TreePM's walk before its mesh adds the long range part
+	auto timeSolver = [&](auto&& solve) {
+		auto start = std::chrono::steady_clock::now();
+		solve();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+		};
+
+	auto printInteractions = [&]() {
+		uint64_t total = 0;
+		for (uint32_t i = 0; i < particleCount; i++) {
+			total += physics.particleInteractions[i];
+		}
+
+		std::cout << std::setw(14) << "" << std::setw(12) << std::fixed << std::setprecision(1)
+			<< static_cast<double>(total) / std::max<uint32_t>(particleCount, 1) << " interactions per particle"
+			<< std::defaultfloat << std::endl;
+		};
+
+	const bool wasRelativeOpening = myVar.isRelativeOpeningEnabled;
+	myVar.isRelativeOpeningEnabled = false;
+
+	double barnesHutMs = timeSolver([&]() {
+		parallel_for(0, particleCount, [&](size_t i, int) {
+			pParticles[i].acc = physics.calculateForceFromGrid(pParticles, myVar, static_cast<uint32_t>(i)) / pParticles[i].mass;
+			});
+		});
+
+	std::ostringstream barnesHutName;
+	barnesHutName << "BH theta " << myVar.theta;
+	printAccuracy(barnesHutName.str().c_str(), barnesHutMs, exact, samples, pParticles);
+	printInteractions();
+
+	// The relative criterion needs last step's accelerations, the theta walk's stand in for them. Each run overwrites
+	// acc, so they're put back before the next one
+	std::vector<glm::vec2> thetaAcc(particleCount);
+	for (uint32_t i = 0; i < particleCount; i++) {
+		thetaAcc[i] = pParticles[i].acc;
+	}
+
+	myVar.isRelativeOpeningEnabled = true;
+	const float savedAccuracy = myVar.openingAccuracy;
+
+	for (float accuracy : { 0.02f, 0.005f, 0.001f }) {
+		myVar.openingAccuracy = accuracy;
+
+		for (uint32_t i = 0; i < particleCount; i++) {
+			pParticles[i].acc = thetaAcc[i];
+		}
+
+		double relativeMs = timeSolver([&]() {
+			parallel_for(0, particleCount, [&](size_t i, int) {
+				pParticles[i].acc = physics.calculateForceFromGrid(pParticles, myVar, static_cast<uint32_t>(i)) / pParticles[i].mass;
+				});
+			});
+
+		std::ostringstream relativeName;
+		relativeName << "BH rel " << accuracy;
+		printAccuracy(relativeName.str().c_str(), relativeMs, exact, samples, pParticles);
+		printInteractions();
+	}
+
+	myVar.openingAccuracy = savedAccuracy;
+	myVar.isRelativeOpeningEnabled = wasRelativeOpening;
+
+	for (int order = 1; order <= FMM::maxOrder; order++) {
+		double fmmMs = timeSolver([&]() {
+			pipeline.fmm.computeGravity(pParticles, rParticles, myVar, order);
+			});
+
+		std::string name = "FMM order " + std::to_string(order);
+		printAccuracy(name.c_str(), fmmMs, exact, samples, pParticles);
+	}
+
+	for (int level = 6; level <= 9; level++) {
+		myVar.pmGridLevel = level;
+
+		double pmMs = timeSolver([&]() {
+			pipeline.mesh.computeGravity(pParticles, rParticles, myVar);
+			});
+
+		std::string name = "PM " + std::to_string(1 << level);
+		printAccuracy(name.c_str(), pmMs, exact, samples, pParticles);
+	}
+
+	if (!myVar.isPeriodicBoundaryEnabled) {
+		return;
+	}
+
+	for (int level = 6; level <= 9; level++) {
+		myVar.pmGridLevel = level;
+
+		double treePMMs = timeSolver([&]() {
+			pipeline.mesh.prepareSplit(myVar);
+
+			parallel_for(0, particleCount, [&](size_t i, int) {
+				pParticles[i].acc = physics.calculateShortRangeForce(pParticles, myVar, static_cast<uint32_t>(i), pipeline.mesh.split)
+					/ pParticles[i].mass;
+				});
+
+			pipeline.mesh.computeLongRange(pParticles, rParticles, myVar);
+			});
+
+		std::string name = "TreePM " + std::to_string(1 << level);
+		printAccuracy(name.c_str(), treePMMs, exact, samples, pParticles);
+	}
+}
+
+int main(int argc, char** argv) {
+
+	if (argc < 2) {
+		printUsage();
+		return 1;
+	}
+
+	std::string scenePath;
+	int steps = 100;
+	bool isFmmBenchmark = false;
+
+	int threadsAvailable = static_cast<int>(std::thread::hardware_concurrency());
+	if (threadsAvailable <= 0) {
+		threadsAvailable = 1;
+	}
+	myVar.threadsAmount = std::max(1, static_cast<int>(threadsAvailable * 0.5f));
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+
+		if ((arg == "--steps" || arg == "--threads") && i + 1 < argc) {
+			int value = 0;
+			try {
+				value = std::stoi(argv[++i]);
+			}
+			catch (...) {
+				printUsage();
+				return 1;
+			}
+
+			if (value <= 0) {
+				printUsage();
+				return 1;
+			}
+
+			if (arg == "--steps") {
+				steps = value;
+			}
+			else {
+				myVar.threadsAmount = value;
+			}
+		}
+		else if (arg == "--kernel" && i + 1 < argc) {
+			std::string name = argv[++i];
+			GravityKernel::Path path = GravityKernel::Path::Scalar;
+
+			if (name == "sse") {
+				path = GravityKernel::Path::SSE;
+			}
+			else if (name == "avx2") {
+				path = GravityKernel::Path::AVX2;
+			}
+			else if (name == "neon") {
+				path = GravityKernel::Path::NEON;
+			}
+			else if (name != "scalar") {
+				printUsage();
+				return 1;
+			}
+
+			if (!GravityKernel::setPath(path)) {
+				std::cerr << "Gravity kernel not supported on this CPU: " << name << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "--fmm-benchmark") {
+			isFmmBenchmark = true;
+		}
+		else if (scenePath.empty() && arg.rfind("--", 0) != 0) {
+			scenePath = arg;
+		}
+		else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (scenePath.empty() || !std::filesystem::exists(scenePath)) {
+		std::cerr << "Scene file not found: " << scenePath << std::endl;
+		return 1;
+	}
+
+	// SPH Materials initialization
+	SPHMaterials::Init();
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	myVar.isMultiThreadingEnabled = myVar.threadsAmount > 1;
+
+	const int threads = myVar.isMultiThreadingEnabled ? myVar.threadsAmount : 1;
+	#if defined(_OPENMP)
+	omp_set_num_threads(threads);
+	#endif
+	threadPool.resize(threads);
+
+	SaveSystem save;
+	save.loadFlag = true;
+	save.saveSystem(scenePath, myVar, simParam, sph, physics, lighting);
+	save.loadFlag = false;
+
+	if (simParam.pParticles.empty()) {
+		std::cerr << "No particles loaded from: " << scenePath << std::endl;
+		return 1;
+	}
+
+	myVar.isTimePlaying = true;
+
+	std::cout << "Particles: " << simParam.pParticles.size() << std::endl;
+	std::cout << "Threads: " << myVar.threadsAmount << std::endl;
+	std::cout << "Gravity kernel: " << GravityKernel::pathName(GravityKernel::path()) << std::endl;
+
+	if (isFmmBenchmark) {
+		runFmmBenchmark();
+		return 0;
+	}
+
+	std::cout << "Steps: " << steps << std::endl;
+
+	PhaseTimings accumulated;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < steps; i++) {
+		pipeline.step(myVar, simParam, physics, sph);
+
+		accumulated.treeBuild += pipeline.timings.treeBuild;
+		accumulated.neighbors += pipeline.timings.neighbors;
+		accumulated.gravity += pipeline.timings.gravity;
+		accumulated.merger += pipeline.timings.merger;
+		accumulated.sph += pipeline.timings.sph;
+		accumulated.constraints += pipeline.timings.constraints;
+		accumulated.integration += pipeline.timings.integration;
+		accumulated.temperature += pipeline.timings.temperature;
+	}
+
+	std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+
+	auto printPhase = [&](const char* name, double ms) {
+		std::cout << std::left << std::setw(14) << name
+			<< std::right << std::setw(12) << std::fixed << std::setprecision(3) << ms << " ms total"
+			<< std::setw(12) << ms / steps << " ms/step" << std::endl;
+		};
+
+	printPhase("Tree build", accumulated.treeBuild);
+	printPhase("Neighbors", accumulated.neighbors);
+	printPhase("Gravity", accumulated.gravity);
+	printPhase("Merger", accumulated.merger);
+	printPhase("SPH", accumulated.sph);
+	printPhase("Constraints", accumulated.constraints);
+	printPhase("Integration", accumulated.integration);
+	printPhase("Temperature", accumulated.temperature);
+	printPhase("Physics", accumulated.total());
+	printPhase("Wall", wall.count());
+
+	const double bytesToMB = 1.0 / (1024.0 * 1024.0);
+
+	std::cout << "Frame memory: " << std::fixed << std::setprecision(2) << frameArena.highWaterBytes() * bytesToMB
+		<< " MB high-water, " << frameArena.capacityBytes() * bytesToMB << " MB reserved" << std::endl;
+
+	for (const FrameArena::Entry& entry : frameArena.entries) {
+		std::cout << "  " << std::left << std::setw(28) << entry.name << std::right << std::setw(10)
+			<< entry.highWaterBytes * bytesToMB << " MB" << std::endl;
+	}
+
+	return 0;
+}
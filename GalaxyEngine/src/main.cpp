@@ -155,23 +155,23 @@ void main()
 	ImVec4* colors = style.Colors;
 
 	// Button and window colors
-	colors[ImGuiCol_WindowBg] = myVar.colWindowBg;
-	colors[ImGuiCol_Button] = myVar.colButton;
-	colors[ImGuiCol_ButtonHovered] = myVar.colButtonHover;
-	colors[ImGuiCol_ButtonActive] = myVar.colButtonPress;
+	colors[ImGuiCol_WindowBg] = UI::colWindowBg;
+	colors[ImGuiCol_Button] = UI::colButton;
+	colors[ImGuiCol_ButtonHovered] = UI::colButtonHover;
+	colors[ImGuiCol_ButtonActive] = UI::colButtonPress;
 
 	// Slider colors
-	style.Colors[ImGuiCol_SliderGrab] = myVar.colSliderGrab;        // Bright cyan-ish knob
-	style.Colors[ImGuiCol_SliderGrabActive] = myVar.colSliderGrabActive;  // Darker when dragging
+	style.Colors[ImGuiCol_SliderGrab] = UI::colSliderGrab;        // Bright cyan-ish knob
+	style.Colors[ImGuiCol_SliderGrabActive] = UI::colSliderGrabActive;  // Darker when dragging
 
-	style.Colors[ImGuiCol_FrameBg] = myVar.colSliderBg;           // Dark track when idle
-	style.Colors[ImGuiCol_FrameBgHovered] = myVar.colSliderBgHover;    // Lighter track on hover
-	style.Colors[ImGuiCol_FrameBgActive] = myVar.colSliderBgActive;     // Even lighter on active
+	style.Colors[ImGuiCol_FrameBg] = UI::colSliderBg;           // Dark track when idle
+	style.Colors[ImGuiCol_FrameBgHovered] = UI::colSliderBgHover;    // Lighter track on hover
+	style.Colors[ImGuiCol_FrameBgActive] = UI::colSliderBgActive;     // Even lighter on active
 
 	// Tab colors
-	style.Colors[ImGuiCol_Tab] = myVar.colButton;
-	style.Colors[ImGuiCol_TabHovered] = myVar.colButtonHover;
-	style.Colors[ImGuiCol_TabActive] = myVar.colButtonPress;
+	style.Colors[ImGuiCol_Tab] = UI::colButton;
+	style.Colors[ImGuiCol_TabHovered] = UI::colButtonHover;
+	style.Colors[ImGuiCol_TabActive] = UI::colButtonPress;
 
 	ImGuiIO& io = ImGui::GetIO();
 
@@ -183,14 +183,14 @@ void main()
 	config.PixelSnapH = false;        // Disable pixel snapping for smoother text
 	config.RasterizerMultiply = 0.9f; // Slightly boosts brightness
 
-	myVar.robotoMediumFont = io.Fonts->AddFontFromFileTTF(
+	UI::robotoMediumFont = io.Fonts->AddFontFromFileTTF(
 		"fonts/Roboto-Medium.ttf",
 		config.SizePixels,
 		&config,
 		io.Fonts->GetGlyphRangesDefault()
 	);
 
-	if (!myVar.robotoMediumFont) {
+	if (!UI::robotoMediumFont) {
 		std::cerr << "Failed to load special font!\n";
 	}
 	else {
@@ -0,0 +1,35 @@
+#include "simulationState.h"
+#include "Physics/materialsSPH.h"
+
+// Never destroyed, so ScratchVectors held by globals in any translation unit can unregister themselves at exit
+FrameArena& frameArena = *new FrameArena();
+
+ScratchVector<Quadtree::Segment> Quadtree::segmentScratch("Tree top segments");
+ScratchVector<Node> Quadtree::topNodeScratch("Tree top nodes");
+ScratchVector<PendingNode> Quadtree::taskScratch("Tree build tasks");
+ScratchVector<PendingNode> Quadtree::stackScratch("Tree build stack");
+
+UpdateVariables myVar;
+Physics physics;
+SPH sph;
+Lighting lighting;
+PhysicsPipeline pipeline;
+
+std::vector<Node> globalNodes;
+std::vector<GravityNode> gravityNodes;
+std::vector<float> gravityNodeTemps;
+std::vector<GravityQuadrupole> gravityNodeQuads;
+
+uint32_t globalId = 0;
+uint32_t globalShapeId = 1;
+uint32_t globalWallId = 1;
+// If someday light id gets added, don't forget to add the id to the copy paste code too
+
+std::unordered_map<uint32_t, size_t> NeighborSearch::idToIndex;
+
+// SPH Materials vector definition
+std::vector<std::unique_ptr<SPHMaterial>> SPHMaterials::materials;
+std::unordered_map<uint32_t, SPHMaterial*> SPHMaterials::idToMaterial;
+
+// Global particle base mass
+float UpdateVariables::particleBaseMass = 8500000000.0f;
@@ -744,6 +744,14 @@ EMSCRIPTEN_KEEPALIVE int web_get_symplectic_integrator() {
 	return myVar.useSymplecticIntegrator ? 1 : 0;
 }
 
+EMSCRIPTEN_KEEPALIVE void web_set_block_timesteps(int enabled) {
+	myVar.isBlockTimestepEnabled = (enabled != 0);
+}
+
+EMSCRIPTEN_KEEPALIVE int web_get_block_timesteps() {
+	return myVar.isBlockTimestepEnabled ? 1 : 0;
+}
+
 EMSCRIPTEN_KEEPALIVE void web_set_window_size(int width, int height) {
 	if (width < 1) width = 1;
 	if (height < 1) height = 1;
@@ -795,6 +803,7 @@ EMSCRIPTEN_KEEPALIVE void web_clear_scene() {
 	myParam.pParticlesSelected.clear();
 	myParam.rParticlesSelected.clear();
 	myParam.trails.segments.clear();
+	myVar.deleteHalosFlag = true;
 
 	lighting.rays.clear();
 	lighting.pointLights.clear();
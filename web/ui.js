@@ -322,6 +322,8 @@ function useWasmApi() {
         getTimeStepMultiplier: wrap("web_get_time_step_multiplier", "number", []),
         setSymplecticIntegrator: wrap("web_set_symplectic_integrator", null, ["number"]),
         getSymplecticIntegrator: wrap("web_get_symplectic_integrator", "number", []),
+        setBlockTimesteps: wrap("web_set_block_timesteps", null, ["number"]),
+        getBlockTimesteps: wrap("web_get_block_timesteps", "number", []),
         setThreadsAmount: wrap("web_set_threads_amount", null, ["number"]),
         getThreadsAmount: wrap("web_get_threads_amount", "number", []),
         setDomainWidth: wrap("web_set_domain_width", null, ["number"]),
@@ -897,6 +899,9 @@ function App() {
   const [symplecticIntegrator, setSymplecticIntegrator] = useState(
     storedState.symplecticIntegrator ?? false
   );
+  const [blockTimesteps, setBlockTimesteps] = useState(
+    storedState.blockTimesteps ?? false
+  );
   const [targetFps, setTargetFps] = useState(storedState.targetFps ?? 144);
   const [targetFpsInput, setTargetFpsInput] = useState(
     String(storedState.targetFps ?? 144)
@@ -1116,6 +1121,7 @@ function App() {
     timePlaying,
     timeStep,
     symplecticIntegrator,
+    blockTimesteps,
     targetFps,
     gravity,
     gravityRampEnabled,
@@ -1282,6 +1288,13 @@ function App() {
     setSymplecticIntegrator(symplecticIntegratorValue);
     api.setSymplecticIntegrator(symplecticIntegratorValue ? 1 : 0);
 
+    const blockTimestepsValue = getBool(
+      "blockTimesteps",
+      api.getBlockTimesteps() === 1
+    );
+    setBlockTimesteps(blockTimestepsValue);
+    api.setBlockTimesteps(blockTimestepsValue ? 1 : 0);
+
     const targetFpsValue = getNum("targetFps", api.getTargetFps());
     setTargetFps(targetFpsValue);
     setTargetFpsInput(String(targetFpsValue));
@@ -2458,6 +2471,7 @@ function App() {
     timePlaying,
     timeStep,
     symplecticIntegrator,
+    blockTimesteps,
     targetFps,
     gravity,
     gravityRampEnabled,
@@ -3460,6 +3474,15 @@ function App() {
                   }}
                 />
                 <${Note}>Energy-preserving integration. Disable for legacy behavior.</${Note}>
+                <${Toggle}
+                  label="Block Timesteps"
+                  value=${blockTimesteps}
+                  onChange=${(val) => {
+                    setBlockTimesteps(val);
+                    api?.setBlockTimesteps(val ? 1 : 0);
+                  }}
+                />
+                <${Note}>Per-particle power of two timesteps for gravity. SPH and GPU use the global step.</${Note}>
                 <${Slider}
                   label="Softening"
                   value=${softening}